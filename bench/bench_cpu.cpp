@@ -0,0 +1,187 @@
+// Interpreter throughput per opcode family and dispatch mode, whole frames
+// of synthetic ROMs, and the cost of loading a ROM. Every benchmark reports
+// MIPS (millions of CHIP-8 instructions per second); frame benchmarks also
+// report ns_per_frame. Run with --benchmark_format=json for tooling.
+#include "bench_roms.h"
+#include "chip8_emulator.h"
+#include "chip8_jit.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using chip8::DispatchMode;
+
+constexpr uint32_t CYCLES_PER_ITERATION = 1000;
+
+#if CHIP8_ENABLE_INSTRUMENTATION
+constexpr bool INSTRUMENTED = true;
+#else
+constexpr bool INSTRUMENTED = false;
+#endif
+
+// The default build must run the interpreter it ran before instrumentation
+// existed: no profiler to reach from step(), and the same two cache lines
+// of state. Fails the build otherwise, before any numbers are compared.
+template <typename Cpu>
+concept HasProfiler = requires(const Cpu &cpu) { cpu.profiler(); };
+using EmulatedCpu = chip8::BasicCpu<chip8::DefaultAccess, chip8::PcgRandom>;
+static_assert(HasProfiler<EmulatedCpu> == INSTRUMENTED);
+#if !CHIP8_ENABLE_INSTRUMENTATION
+static_assert(sizeof(EmulatedCpu) == 2 * 64);
+#endif
+
+void set_counters(benchmark::State &state, double instructions,
+                  double frames) {
+  // Lets a comparison tell profiled runs from the default build, which
+  // must match the numbers from before instrumentation existed.
+  state.counters["instrumented"] = INSTRUMENTED;
+  state.counters["MIPS"] =
+      benchmark::Counter(instructions * 1e-6, benchmark::Counter::kIsRate);
+  if (frames > 0) {
+    state.counters["ns_per_frame"] = benchmark::Counter(
+        frames * 1e-9,
+        benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+  }
+}
+
+// Returns false, after marking the benchmark skipped, if `mode` cannot run
+// on this host.
+template <typename Emulator>
+bool apply_dispatch_mode(benchmark::State &state, Emulator &emulator) {
+  const auto mode = static_cast<DispatchMode>(state.range(0));
+  if (mode == DispatchMode::Jit && !chip8::Jit::supported()) {
+    state.SkipWithError("JIT dispatch is not supported on this host");
+    return false;
+  }
+  emulator.set_dispatch_mode(mode);
+  return true;
+}
+
+// Args: dispatch mode.
+template <typename Emulator = chip8::Emulator, typename MakeRom>
+void BM_OpcodeFamily(benchmark::State &state, MakeRom make_rom) {
+  Emulator emulator;
+  if (!apply_dispatch_mode(state, emulator)) {
+    return;
+  }
+  // Measures the interpreter itself, never the idle-loop shortcut.
+  emulator.set_skip_idle_loops(false);
+  emulator.load_rom(make_rom());
+
+  for (auto _ : state) {
+    emulator.run_frame(CYCLES_PER_ITERATION);
+  }
+  set_counters(state,
+               static_cast<double>(state.iterations()) * CYCLES_PER_ITERATION,
+               0);
+}
+
+// Args: dispatch mode, cycles per frame. MIPS counts skipped idle cycles as
+// executed, i.e. it is the emulated speed.
+void BM_RunFrame(benchmark::State &state, const std::vector<uint8_t> &rom,
+                 bool skip_idle_loops) {
+  const auto cycles = static_cast<uint32_t>(state.range(1));
+  chip8::Emulator emulator{cycles};
+  if (!apply_dispatch_mode(state, emulator)) {
+    return;
+  }
+  emulator.set_skip_idle_loops(skip_idle_loops);
+  emulator.load_rom(rom);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(emulator.run_frame());
+  }
+  const auto frames = static_cast<double>(state.iterations());
+  set_counters(state, frames * cycles, frames);
+}
+
+// Args: dispatch mode. The memory family under an explicit access policy;
+// every fetch goes through it too, so the pair shows what bounds checks
+// cost per instruction.
+template <typename Access> void BM_MemoryAccess(benchmark::State &state) {
+  BM_OpcodeFamily<chip8::BasicEmulator<Access>>(state,
+                                                chip8::bench::memory_rom);
+}
+
+void BM_LoadRom(benchmark::State &state) {
+  const auto rom = chip8::bench::load_add_rom(); // fills memory
+  chip8::Emulator emulator;
+  for (auto _ : state) {
+    emulator.load_rom(rom);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(rom.size()));
+}
+
+void BM_Reset(benchmark::State &state) {
+  chip8::Emulator emulator;
+  emulator.load_rom(chip8::bench::NOISE_ROM);
+  for (auto _ : state) {
+    emulator.reset();
+    benchmark::ClobberMemory();
+  }
+}
+
+void dispatch_modes(benchmark::internal::Benchmark *bench) {
+  bench->ArgName("dispatch");
+  for (const auto mode : {DispatchMode::Switch, DispatchMode::Table,
+                          DispatchMode::Cached, DispatchMode::Jit}) {
+    bench->Arg(static_cast<int64_t>(mode));
+  }
+}
+
+void frame_sizes(benchmark::internal::Benchmark *bench) {
+  bench->ArgNames({"dispatch", "cycles"});
+  for (const auto mode : {DispatchMode::Switch, DispatchMode::Table,
+                          DispatchMode::Cached, DispatchMode::Jit}) {
+    for (const int64_t cycles : {10, 100, 1000}) {
+      bench->Args({static_cast<int64_t>(mode), cycles});
+    }
+  }
+}
+
+} // namespace
+
+// dispatch: 0 = switch, 1 = table, 2 = cached, 3 = jit
+BENCHMARK_CAPTURE(BM_OpcodeFamily, load_add, chip8::bench::load_add_rom)
+    ->Apply(dispatch_modes);
+BENCHMARK_CAPTURE(BM_OpcodeFamily, alu, chip8::bench::alu_rom)
+    ->Apply(dispatch_modes);
+BENCHMARK_CAPTURE(BM_OpcodeFamily, skip, chip8::bench::skip_rom)
+    ->Apply(dispatch_modes);
+BENCHMARK_CAPTURE(BM_OpcodeFamily, jump, chip8::bench::jump_rom)
+    ->Apply(dispatch_modes);
+BENCHMARK_CAPTURE(BM_OpcodeFamily, call_return, chip8::bench::call_return_rom)
+    ->Apply(dispatch_modes);
+BENCHMARK_CAPTURE(BM_OpcodeFamily, index, chip8::bench::index_rom)
+    ->Apply(dispatch_modes);
+BENCHMARK_CAPTURE(BM_OpcodeFamily, random, chip8::bench::random_rom)
+    ->Apply(dispatch_modes);
+BENCHMARK_CAPTURE(BM_OpcodeFamily, draw, chip8::bench::draw_rom)
+    ->Apply(dispatch_modes);
+BENCHMARK_CAPTURE(BM_OpcodeFamily, keys, chip8::bench::key_rom)
+    ->Apply(dispatch_modes);
+BENCHMARK_CAPTURE(BM_OpcodeFamily, timers, chip8::bench::timer_rom)
+    ->Apply(dispatch_modes);
+BENCHMARK_CAPTURE(BM_OpcodeFamily, memory, chip8::bench::memory_rom)
+    ->Apply(dispatch_modes);
+BENCHMARK_TEMPLATE(BM_MemoryAccess, chip8::CheckedAccess)
+    ->Apply(dispatch_modes);
+BENCHMARK_TEMPLATE(BM_MemoryAccess, chip8::MaskedAccess)
+    ->Apply(dispatch_modes);
+
+BENCHMARK_CAPTURE(BM_RunFrame, noise, chip8::bench::NOISE_ROM, false)
+    ->Apply(frame_sizes);
+BENCHMARK_CAPTURE(BM_RunFrame, noise_skip_idle, chip8::bench::NOISE_ROM, true)
+    ->Apply(frame_sizes);
+BENCHMARK_CAPTURE(BM_RunFrame, game_loop, chip8::bench::GAME_LOOP_ROM, false)
+    ->Apply(frame_sizes);
+BENCHMARK_CAPTURE(BM_RunFrame, game_loop_skip_idle,
+                  chip8::bench::GAME_LOOP_ROM, true)
+    ->Apply(frame_sizes);
+
+BENCHMARK(BM_LoadRom);
+BENCHMARK(BM_Reset);
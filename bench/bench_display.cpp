@@ -0,0 +1,102 @@
+// Sprite drawing, texel expansion and the SDL render path. Rendering runs
+// on SDL's dummy video driver with the software renderer, so it needs no
+// display and measures our upload and copy, not a GPU.
+#include "SDL2/SDL.h"
+#include "chip8_display.h"
+#include "constants.h"
+#include "framebuffer_expand.h"
+#include "sdl_display.h"
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace {
+
+constexpr std::array<uint8_t, 15> SPRITE{0xFF, 0x81, 0xBD, 0xA5, 0xA5,
+                                         0xBD, 0x81, 0xFF, 0x81, 0xBD,
+                                         0xA5, 0xA5, 0xBD, 0x81, 0xFF};
+
+// Args: x, y, sprite height.
+void BM_DrawSprite(benchmark::State &state) {
+  const auto x = static_cast<int>(state.range(0));
+  const auto y = static_cast<int>(state.range(1));
+  const auto sprite =
+      std::span(SPRITE).first(static_cast<std::size_t>(state.range(2)));
+  chip8::Display display;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(display.draw_sprite(x, y, sprite));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ExpandRows(benchmark::State &state) {
+  std::array<uint64_t, chip8::SCREEN_HEIGHT> rows{};
+  for (std::size_t y = 0; y < rows.size(); ++y) {
+    rows[y] = 0x0123456789ABCDEFull * (y + 1);
+  }
+  std::vector<uint32_t> texels(std::size_t{chip8::SCREEN_WIDTH} *
+                               chip8::SCREEN_HEIGHT);
+  for (auto _ : state) {
+    chip8::expand_rows(rows, texels.data(),
+                       chip8::SCREEN_WIDTH * sizeof(uint32_t), 0xFFFFFFFFu,
+                       0x000000FFu);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(texels.size() * 4));
+}
+
+// Opens the dummy video driver for the duration of a render benchmark.
+class DummyVideo {
+public:
+  DummyVideo() {
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    // Selecting the renderer by name skips the accelerated/vsync filter
+    // that SdlDisplay's flags would otherwise apply.
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+  }
+  DummyVideo(const DummyVideo &) = delete;
+  DummyVideo &operator=(const DummyVideo &) = delete;
+  ~DummyVideo() { SDL_QuitSubSystem(SDL_INIT_VIDEO); }
+};
+
+// Args: rows redrawn per frame (0 = nothing changed).
+void BM_Render(benchmark::State &state) {
+  DummyVideo video;
+  std::unique_ptr<chip8::SdlDisplay> sdl;
+  try {
+    sdl = std::make_unique<chip8::SdlDisplay>();
+  } catch (const std::exception &ex) {
+    state.SkipWithError(ex.what());
+    return;
+  }
+
+  const auto height = static_cast<std::size_t>(state.range(0));
+  chip8::Display display;
+  sdl->render(display);
+  for (auto _ : state) {
+    if (height > 0) {
+      (void)display.draw_sprite(0, 0, std::span(SPRITE).first(height));
+    }
+    sdl->render(display);
+  }
+  state.counters["ns_per_frame"] = benchmark::Counter(
+      static_cast<double>(state.iterations()) * 1e-9,
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+} // namespace
+
+BENCHMARK(BM_DrawSprite)
+    ->ArgNames({"x", "y", "height"})
+    ->Args({8, 0, 5})    // byte aligned
+    ->Args({3, 0, 5})    // straddles two bytes
+    ->Args({60, 0, 5})   // wraps horizontally
+    ->Args({60, 28, 15}) // wraps both ways
+    ->Args({8, 0, 15});
+BENCHMARK(BM_ExpandRows);
+BENCHMARK(BM_Render)->ArgName("rows")->Arg(0)->Arg(5)->Arg(15)->UseRealTime();
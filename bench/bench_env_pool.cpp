@@ -0,0 +1,86 @@
+// Steps per second of the synchronous VectorEnv against EnvPool, with and
+// without a learner that spends time on every batch it receives.
+#include "bench_roms.h"
+#include "env_pool.h"
+#include "vector_env.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+using chip8::bench::NOISE_ROM;
+
+// Stands in for the learner's forward pass on a batch.
+void learner_work(int64_t microseconds) {
+  const auto until = std::chrono::steady_clock::now() +
+                     std::chrono::microseconds(microseconds);
+  while (std::chrono::steady_clock::now() < until) {
+  }
+}
+
+// Args: instances, learner microseconds per batch.
+void BM_VectorEnvStep(benchmark::State &state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  chip8::VectorEnv env{NOISE_ROM, count};
+  std::vector<uint16_t> actions(count);
+  std::vector<uint8_t> observations(count * env.observation_size());
+  std::vector<float> rewards(count);
+  std::vector<uint8_t> dones(count);
+
+  for (auto _ : state) {
+    env.step(actions, observations, rewards, dones);
+    learner_work(state.range(1));
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(count));
+}
+
+// Args: instances, learner microseconds per batch, batch size. A batch
+// size equal to the instance count is synchronous stepping on the pool.
+void BM_EnvPool(benchmark::State &state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  const auto batch = static_cast<std::size_t>(state.range(2));
+  chip8::EnvPool pool{NOISE_ROM, count};
+  std::vector<std::size_t> ids(count);
+  std::iota(ids.begin(), ids.end(), 0);
+  std::vector<uint16_t> actions(count);
+  std::vector<uint8_t> observations(batch * pool.observation_size());
+  std::vector<float> rewards(batch);
+  std::vector<uint8_t> dones(batch);
+
+  pool.send(ids, actions);
+  const std::span<std::size_t> received = std::span(ids).first(batch);
+  const std::span<const uint16_t> keys = std::span(actions).first(batch);
+  for (auto _ : state) {
+    pool.recv(received, observations, rewards, dones);
+    learner_work(state.range(1));
+    pool.send(received, keys);
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(batch));
+
+  std::vector<std::size_t> rest(pool.in_flight());
+  std::vector<uint8_t> rest_observations(rest.size() *
+                                         pool.observation_size());
+  std::vector<float> rest_rewards(rest.size());
+  std::vector<uint8_t> rest_dones(rest.size());
+  pool.recv(rest, rest_observations, rest_rewards, rest_dones);
+}
+
+} // namespace
+
+BENCHMARK(BM_VectorEnvStep)
+    ->ArgNames({"envs", "learner_us"})
+    ->Args({256, 0})
+    ->Args({256, 200})
+    ->UseRealTime();
+BENCHMARK(BM_EnvPool)
+    ->ArgNames({"envs", "learner_us", "batch"})
+    ->Args({256, 0, 256})
+    ->Args({256, 200, 256})
+    ->Args({256, 0, 128})
+    ->Args({256, 200, 128})
+    ->UseRealTime();
@@ -0,0 +1,126 @@
+#pragma once
+#include "constants.h"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+// Synthetic ROMs for chip8_bench. They are built here rather than shipped
+// as files so the benchmark does not depend on the working directory.
+namespace chip8::bench {
+
+// Draws random bytes at random positions forever.
+inline const std::vector<uint8_t> NOISE_ROM{
+    0xC0, 0x3F, // 0x200: RND V0, 0x3F
+    0xC1, 0x1F, // 0x202: RND V1, 0x1F
+    0xA2, 0x00, // 0x204: LD I, 0x200
+    0xD0, 0x13, // 0x206: DRW V0, V1, 3
+    0x12, 0x00, // 0x208: JP 0x200
+};
+
+// Shaped like a game's main loop: poll keys, move, redraw, wait a tick.
+inline const std::vector<uint8_t> GAME_LOOP_ROM{
+    0x60, 0x20, // 0x200: LD V0, 32
+    0x61, 0x10, // 0x202: LD V1, 16
+    0x62, 0x05, // 0x204: LD V2, 5
+    0xA2, 0x2A, // 0x206: LD I, sprite
+    0xD0, 0x14, // 0x208: DRW V0, V1, 4      erase
+    0xE2, 0xA1, // 0x20A: SKNP V2
+    0x70, 0xFF, // 0x20C: ADD V0, -1
+    0x70, 0x01, // 0x20E: ADD V0, 1
+    0xC3, 0x03, // 0x210: RND V3, 3
+    0x81, 0x34, // 0x212: ADD V1, V3
+    0x71, 0xFF, // 0x214: ADD V1, -1
+    0xD0, 0x14, // 0x216: DRW V0, V1, 4      draw
+    0x64, 0x01, // 0x218: LD V4, 1
+    0xF4, 0x15, // 0x21A: LD DT, V4
+    0xF4, 0x07, // 0x21C: LD V4, DT
+    0x34, 0x00, // 0x21E: SE V4, 0
+    0x12, 0x1C, // 0x220: JP 0x21C
+    0x12, 0x08, // 0x222: JP 0x208
+    0x00, 0x00, //
+    0x00, 0x00, //
+    0x00, 0x00, //
+    0x3C, 0x7E, // 0x22A: sprite
+    0x7E, 0x3C, //
+};
+
+// `body` repeated back to back in up to `limit` bytes, followed by a jump
+// to the start, so almost every instruction executed is from `body`.
+inline std::vector<uint8_t>
+repeat_rom(std::initializer_list<uint16_t> body,
+           std::size_t limit = MEMORY_SIZE - START_ADDRESS - 2) {
+  std::vector<uint8_t> rom;
+  while (rom.size() + 2 * body.size() <= limit) {
+    for (const uint16_t opcode : body) {
+      rom.push_back(static_cast<uint8_t>(opcode >> 8));
+      rom.push_back(static_cast<uint8_t>(opcode));
+    }
+  }
+  rom.push_back(static_cast<uint8_t>(0x10 | (START_ADDRESS >> 8)));
+  rom.push_back(static_cast<uint8_t>(START_ADDRESS));
+  return rom;
+}
+
+// Instruction mixes dominated by one opcode family each.
+inline std::vector<uint8_t> load_add_rom() {
+  return repeat_rom({0x6012, 0x7101, 0x6234, 0x7305}); // 6xkk, 7xkk
+}
+
+inline std::vector<uint8_t> alu_rom() {
+  return repeat_rom({0x8010, 0x8121, 0x8232, 0x8343, 0x8454, 0x8565,
+                     0x8676, 0x8787, 0x889E}); // 8xy0 - 8xyE
+}
+
+inline std::vector<uint8_t> skip_rom() {
+  // V0 stays 0, so none of these skip.
+  return repeat_rom({0x3001, 0x4000, 0x5010, 0x9000}); // 3xkk, 4xkk, 5xy0
+}
+
+inline std::vector<uint8_t> jump_rom() {
+  std::vector<uint8_t> rom;
+  for (uint16_t pc = START_ADDRESS; pc < MEMORY_SIZE - 2; pc += 2) {
+    const auto next = static_cast<uint16_t>(
+        pc + 2 < MEMORY_SIZE - 2 ? pc + 2 : START_ADDRESS);
+    rom.push_back(static_cast<uint8_t>(0x10 | (next >> 8))); // 1nnn
+    rom.push_back(static_cast<uint8_t>(next));
+  }
+  return rom;
+}
+
+inline std::vector<uint8_t> call_return_rom() {
+  return {
+      0x22, 0x04, // 0x200: CALL 0x204
+      0x12, 0x00, // 0x202: JP 0x200
+      0x00, 0xEE, // 0x204: RET
+  };
+}
+
+inline std::vector<uint8_t> index_rom() {
+  return repeat_rom({0xA300, 0xF01E, 0xF029}); // Annn, Fx1E, Fx29
+}
+
+inline std::vector<uint8_t> random_rom() {
+  return repeat_rom({0xC0FF, 0xC10F}); // Cxkk
+}
+
+inline std::vector<uint8_t> draw_rom() {
+  // I = 0 points at the "0" glyph; draws at (V0, V1) = (0, 0).
+  return repeat_rom({0xD015, 0xD01F}); // Dxyn
+}
+
+inline std::vector<uint8_t> key_rom() {
+  return repeat_rom({0xE09E, 0xE0A1, 0xE19E}); // Ex9E, ExA1
+}
+
+inline std::vector<uint8_t> timer_rom() {
+  return repeat_rom({0xF015, 0xF018, 0xF107}); // Fx15, Fx18, Fx07
+}
+
+inline std::vector<uint8_t> memory_rom() {
+  // Stores and reloads V0-V7 at 0xE00, past the end of the code.
+  return repeat_rom({0xAE00, 0xF033, 0xF755, 0xF765}, // Fx33, Fx55, Fx65
+                    0x800);
+}
+
+} // namespace chip8::bench
@@ -0,0 +1,188 @@
+#pragma once
+#include "chip8_emulator.h"
+#include "constants.h"
+#include "headless_audio.h"
+#include "input_movie.h"
+#include "rom_profiler.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace chip8 {
+
+enum class BatchStopReason { FrameLimit, Halted, Error };
+
+[[nodiscard]] constexpr std::string_view
+to_string(BatchStopReason reason) noexcept {
+  switch (reason) {
+  case BatchStopReason::FrameLimit:
+    return "frame_limit";
+  case BatchStopReason::Halted:
+    return "halted";
+  case BatchStopReason::Error:
+    return "error";
+  }
+  return "unknown";
+}
+
+struct BatchJob {
+  std::string name;
+  std::shared_ptr<const std::vector<uint8_t>> rom;
+  uint32_t frames{};
+  uint32_t cycles_per_frame{10};
+  DispatchMode dispatch_mode{DispatchMode::Switch};
+  // When set, the movie's inputs, seed, cycles per frame and length replace
+  // the settings above and the final state is checked against it.
+  std::shared_ptr<const InputMovie> movie{};
+  // Fills in the result's hot listing and collapsed stacks.
+  bool profile{false};
+  // When set, the buzzer is rendered into this WAV file (see HeadlessAudio).
+  std::filesystem::path audio{};
+};
+
+struct BatchResult {
+  uint32_t frames_run{};
+  uint64_t cycles_run{};
+  uint16_t program_counter{};
+  uint64_t display_hash{};
+  BatchStopReason stop_reason{BatchStopReason::FrameLimit};
+  std::optional<bool> movie_verified; // set for movie jobs
+  std::string error;
+  // RomProfiler output for profiled jobs.
+  std::string hot_listing;
+  std::string collapsed_stacks;
+};
+
+// FNV-1a over the packed framebuffer rows, little-endian byte order.
+[[nodiscard]] inline uint64_t hash_display(const Display &display) noexcept {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (const uint64_t row : display.rows()) {
+    for (int shift = 0; shift < 64; shift += 8) {
+      hash ^= (row >> shift) & 0xFF;
+      hash *= 0x100000001B3ull;
+    }
+  }
+  return hash;
+}
+
+// A ROM is considered finished once it parks on a `1nnn` jumping to itself.
+[[nodiscard]] inline bool is_halted(const Emulator &emulator) noexcept {
+  const uint16_t pc = emulator.cpu().program_counter();
+  const auto memory = emulator.memory().span();
+  if (pc >= memory.size() - 1) {
+    return false;
+  }
+  const auto opcode =
+      static_cast<uint16_t>(memory[pc] << 8 | memory[pc + 1]);
+  return (opcode & 0xF000) == 0x1000 && (opcode & 0x0FFF) == pc;
+}
+
+// Runs a single job to completion on the calling thread. Every instance is
+// seeded identically, so the result only depends on the job itself.
+[[nodiscard]] inline BatchResult run_batch_job(const BatchJob &job) {
+  BatchResult result;
+  try {
+    Emulator emulator{job.cycles_per_frame};
+    emulator.set_dispatch_mode(job.dispatch_mode);
+    if (job.profile) {
+      emulator.enable_profiling();
+    }
+    std::ofstream audio_file;
+    std::optional<HeadlessAudio> audio;
+    if (!job.audio.empty()) {
+      audio_file.open(job.audio, std::ios::binary);
+      if (!audio_file) {
+        throw std::runtime_error("Failed to open WAV file: " +
+                                 job.audio.string());
+      }
+      audio.emplace(audio_file);
+      emulator.set_beep_sink(&*audio);
+    }
+    auto write_profile = [&] {
+      if (const RomProfiler *profiler = emulator.profiler()) {
+        std::ostringstream hot;
+        profiler->write_hot_listing(hot, emulator.memory().span());
+        result.hot_listing = std::move(hot).str();
+        std::ostringstream stacks;
+        profiler->write_collapsed_stacks(stacks, emulator.memory().span());
+        result.collapsed_stacks = std::move(stacks).str();
+      }
+    };
+    if (job.movie) {
+      const auto playback = play_movie(emulator, *job.movie, *job.rom);
+      result.frames_run = playback.frames;
+      result.cycles_run =
+          uint64_t{playback.frames} * job.movie->cycles_per_frame;
+      result.movie_verified = playback.verified;
+      result.program_counter = emulator.cpu().program_counter();
+      result.display_hash = hash_display(emulator.display());
+      write_profile();
+      if (audio) {
+        audio->finish();
+      }
+      return result;
+    }
+    emulator.load_rom(std::span<const uint8_t>(*job.rom));
+
+    while (result.frames_run < job.frames) {
+      const RunFrameResult frame = emulator.run_frame();
+      ++result.frames_run;
+      result.cycles_run += job.cycles_per_frame;
+      if (is_halted(emulator)) {
+        result.stop_reason = BatchStopReason::Halted;
+        break;
+      }
+      if (frame.waiting_for_key) {
+        // No input ever arrives here, so the rest of the run is the timers
+        // counting down, and they are 8 bits: skip to the state the frame
+        // limit would leave. A recording hears a beep out first.
+        if (audio && frame.sound_active) {
+          continue;
+        }
+        const uint32_t rest = job.frames - result.frames_run;
+        emulator.tick_timers(std::min<uint32_t>(rest, 0xFF));
+        result.frames_run += rest;
+        result.cycles_run += uint64_t{rest} * job.cycles_per_frame;
+        if (audio) {
+          audio->skip_frames(rest);
+        }
+      }
+    }
+
+    result.program_counter = emulator.cpu().program_counter();
+    result.display_hash = hash_display(emulator.display());
+    write_profile();
+    if (audio) {
+      audio->finish();
+    }
+  } catch (const std::exception &ex) {
+    result.stop_reason = BatchStopReason::Error;
+    result.error = ex.what();
+  }
+  return result;
+}
+
+// Shards jobs across the pool. Results are indexed like the input, so the
+// output is identical regardless of the pool size or scheduling order.
+[[nodiscard]] inline std::vector<BatchResult>
+run_batch(std::span<const BatchJob> jobs, WorkStealingPool &pool) {
+  std::vector<BatchResult> results(jobs.size());
+  pool.parallel_for(jobs.size(), [&](std::size_t index) {
+    results[index] = run_batch_job(jobs[index]);
+  });
+  return results;
+}
+
+} // namespace chip8
@@ -0,0 +1,131 @@
+#pragma once
+#include "spsc_queue.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <span>
+
+namespace chip8 {
+
+// The buzzer turning on or off, stamped in emulated time: `offset` is the
+// position within `frame`, from 0 up to but excluding 1.
+struct BeepEvent {
+  uint64_t frame{};
+  float offset{};
+  bool on{};
+};
+
+struct SynthConfig {
+  int sample_rate{44100};
+  double frames_per_second{60.0};
+  double frequency{440.0};
+  float volume{0.2f};
+  // Events timed further ahead than this, in frames, mean the emulator's
+  // clock ran ahead of the sound card's and the two are lined up again.
+  double max_lead_frames{2.0};
+};
+
+// Turns BeepEvents into a sine beep, sample-accurately and without
+// transcendental math per sample: one precomputed period is read with a
+// fixed-point phase accumulator. Emulated frames are mapped onto the
+// sample clock relative to an anchor event; an event that would land in the
+// past or too far ahead re-anchors the mapping at the block being rendered,
+// so clock drift between emulator and sound card never adds up to latency.
+class BeepSynth {
+public:
+  static constexpr std::size_t TABLE_BITS = 10;
+  static constexpr std::size_t TABLE_SIZE = std::size_t{1} << TABLE_BITS;
+
+  explicit BeepSynth(SynthConfig config = {}) noexcept
+      : samples_per_frame_{config.sample_rate / config.frames_per_second},
+        max_lead_{config.max_lead_frames * samples_per_frame_},
+        phase_step_{static_cast<uint32_t>(std::llround(
+            config.frequency / config.sample_rate * 4294967296.0))} {
+    for (std::size_t i = 0; i < TABLE_SIZE; ++i) {
+      table_[i] = config.volume *
+                  static_cast<float>(std::sin(2.0 * std::numbers::pi *
+                                              static_cast<double>(i) /
+                                              TABLE_SIZE));
+    }
+  }
+
+  // Fills `out` with the next samples, applying each queued event at the
+  // sample it maps to. Events due after this block stay queued.
+  void render(std::span<float> out, SpscQueue<BeepEvent> &events) noexcept {
+    const uint64_t block_start = samples_rendered_;
+    std::size_t pos = 0;
+    while (const auto event = events.front()) {
+      const uint64_t at = schedule(*event, block_start) - block_start;
+      if (at >= out.size()) {
+        break;
+      }
+      const auto until = std::max(pos, static_cast<std::size_t>(at));
+      generate(out.subspan(pos, until - pos));
+      pos = until;
+      set_on(event->on);
+      BeepEvent consumed;
+      events.try_pop(consumed);
+    }
+    generate(out.subspan(pos));
+    samples_rendered_ += out.size();
+  }
+
+  // The building blocks of render(), for callers that do their own timing
+  // such as offline rendering: fills `out` with the beep or with silence.
+  void generate(std::span<float> out) noexcept {
+    if (!on_) {
+      std::ranges::fill(out, 0.0f);
+      return;
+    }
+    for (float &sample : out) {
+      sample = table_[phase_ >> (32 - TABLE_BITS)];
+      phase_ += phase_step_;
+    }
+  }
+
+  void set_on(bool on) noexcept {
+    if (on && !on_) {
+      phase_ = 0; // start on a zero crossing
+    }
+    on_ = on;
+  }
+
+  [[nodiscard]] bool on() const noexcept { return on_; }
+  [[nodiscard]] uint64_t samples_rendered() const noexcept {
+    return samples_rendered_;
+  }
+
+private:
+  // Sample at which `event` takes effect, never before `block_start`.
+  uint64_t schedule(const BeepEvent &event, uint64_t block_start) noexcept {
+    const double frame = static_cast<double>(event.frame) + event.offset;
+    if (anchored_) {
+      const double sample =
+          anchor_sample_ + (frame - anchor_frame_) * samples_per_frame_;
+      const auto start = static_cast<double>(block_start);
+      if (sample >= start && sample <= start + max_lead_) {
+        return static_cast<uint64_t>(std::llround(sample));
+      }
+    }
+    anchored_ = true;
+    anchor_frame_ = frame;
+    anchor_sample_ = static_cast<double>(block_start);
+    return block_start;
+  }
+
+  double samples_per_frame_;
+  double max_lead_;
+  uint32_t phase_step_;
+  uint32_t phase_{};
+  bool on_{false};
+  uint64_t samples_rendered_{};
+  bool anchored_{false};
+  double anchor_frame_{};
+  double anchor_sample_{};
+  std::array<float, TABLE_SIZE> table_{};
+};
+
+} // namespace chip8
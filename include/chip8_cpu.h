@@ -1,30 +1,95 @@
 #pragma once
+#include "chip8_decode_cache.h"
 #include "chip8_display.h"
 #include "chip8_irand_gen.h"
+#include "chip8_jit.h"
 #include "chip8_keyboard.h"
 #include "chip8_memory.h"
+#include "chip8_pcg_rand.h"
 #include "chip8_timer.h"
 #include "constants.h"
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <span>
+#if CHIP8_ENABLE_INSTRUMENTATION
+#include "chip8_opcode_profiler.h"
+#endif
 
 namespace chip8 {
 
-class Emulator;
+template <typename Access> class BasicEmulator;
 
-class Cpu {
+// Selects how Cpu::execute() turns an opcode into work. `Switch` is the
+// reference interpreter; `Table` jumps through a compile-time generated
+// handler per 16-bit opcode with the register operands baked in; `Cached`
+// additionally remembers the handler per address so code that has run once
+// skips fetch and decode until memory under it is written; `Jit` runs hot
+// register-only code as translated x86-64 and interprets the rest through
+// the table (x86-64 hosts only, see Jit::supported()).
+enum class DispatchMode { Switch, Table, Cached, Jit };
+
+// `Access` is the memory access policy, see CheckedAccess and MaskedAccess.
+// With CheckedAccess an instruction reaching outside memory, testing a key
+// above 0xF, returning from an empty stack or calling into a full one
+// throws std::out_of_range out of execute() and run(). MaskedAccess wraps
+// addresses to 12 bits, keys to 4 and treats the 16 stack levels as a
+// ring, so nothing the ROM does can make them throw.
+//
+// `Random` is the generator Cxkk draws from. Emulator names the concrete
+// PcgRandom, so the call is direct and inlinable; the default takes any
+// RandomGenerator through its virtual interface, e.g. a mock in tests, and
+// is only built into chip8_test_cpu.
+template <typename Access, typename Random = RandomGenerator> class BasicCpu {
 public:
-  explicit Cpu(Memory &memory, Display &display, Keyboard &keyboard,
-               Timer &timer, RandomGenerator &rng) noexcept
+  explicit BasicCpu(BasicMemory<Access> &memory, Display &display,
+                    Keyboard &keyboard, Timer &timer, Random &rng) noexcept
       : memory_(memory), display_(display), keyboard_(keyboard), timer_(timer),
         rng_(rng) {
     reset();
   }
 
+  BasicCpu(const BasicCpu &) = delete;
+  BasicCpu &operator=(const BasicCpu &) = delete;
+  ~BasicCpu();
+
   void execute();
 
+  // Executes `cycles` instructions; equivalent to calling execute() that many
+  // times, but lets the JIT run whole blocks at once. Returns early when an
+  // Fx0A finds no key, since nothing could change until one is pressed, and
+  // after an Fx18 while sound timer writes are watched. Returns the number
+  // of instructions executed.
+  uint32_t run(uint32_t cycles);
+
+  // Like run(), but once the program is caught in an idle loop, i.e. a short
+  // cycle of side-effect free instructions that leaves every register as it
+  // found it, such as polling the delay timer, the remaining whole
+  // iterations are skipped instead of executed. Nothing but a timer tick or
+  // a key change can end such a loop, so the caller must not change either
+  // during the call. Ends in exactly the state run() would, and returns
+  // early in the same cases; returns the cycles executed or skipped.
+  uint32_t run_skipping_idle(uint32_t cycles);
+
+  // Whether the last run() stopped at an Fx0A waiting for a key press.
+  [[nodiscard]] constexpr bool waiting_for_key() const noexcept {
+    return waiting_for_key_;
+  }
+
+  // Instructions run_skipping_idle() has not had to execute since reset.
+  [[nodiscard]] constexpr uint64_t idle_cycles_skipped() const noexcept {
+    return idle_cycles_skipped_;
+  }
+
+  // Throws std::runtime_error for DispatchMode::Jit on unsupported hosts.
+  void set_dispatch_mode(DispatchMode mode);
+  [[nodiscard]] constexpr DispatchMode dispatch_mode() const noexcept {
+    return dispatch_mode_;
+  }
+
   [[nodiscard]] constexpr uint16_t program_counter() const noexcept {
     return pc_;
   }
@@ -35,13 +100,66 @@ public:
   [[nodiscard]] constexpr uint16_t index_register() const noexcept {
     return I_;
   }
+  // Return addresses pushed by 2nnn, outermost first.
+  [[nodiscard]] constexpr std::span<const uint16_t>
+  call_stack() const noexcept {
+    return std::span<const uint16_t>{stack_}.first(
+        std::min<std::size_t>(sp_, NUM_CPU_STACK));
+  }
+
+#if CHIP8_ENABLE_INSTRUMENTATION
+  // What this Cpu has executed so far; merged into ProcessProfile when it
+  // is destroyed.
+  [[nodiscard]] const OpcodeProfiler &profiler() const noexcept {
+    return *profiler_;
+  }
+#endif
 
 private:
+  // Only instructions that access memory, keys or the stack can throw, and
+  // only when checked.
+  static constexpr bool NOEXCEPT = !Access::THROWS;
+  using Handler = void (*)(BasicCpu &, uint16_t) noexcept(NOEXCEPT);
+
   void reset() noexcept;
+  void attach_memory_observer() noexcept;
+  // Returns the number of instructions run natively, 0 if pc_ must be
+  // interpreted.
+  [[nodiscard]] uint32_t run_jit(uint32_t budget);
+
+  // Steps through at most MAX_IDLE_LOOP instructions and, if they formed an
+  // idle loop, skips as many whole iterations as fit in `cycles`. Returns
+  // the cycles executed or skipped.
+  [[nodiscard]] uint32_t skip_idle_loop(uint32_t cycles);
+
+  static constexpr uint32_t MAX_IDLE_LOOP = 8;
+  static constexpr uint32_t IDLE_PROBE_INTERVAL = 32;
+  static constexpr uint32_t MAX_IDLE_PROBE_INTERVAL = 512;
 
-  void execute_0(uint16_t opcode) noexcept;
+  // execute() wrapped in the profiler hooks of instrumented builds.
+  void step() {
+#if CHIP8_ENABLE_INSTRUMENTATION
+    const auto memory = memory_.get().span();
+    const auto opcode = pc_ < MEMORY_SIZE - 1
+                            ? static_cast<uint16_t>(memory[pc_] << 8 |
+                                                    memory[pc_ + 1])
+                            : uint16_t{0};
+    const auto start = profiler_->begin(opcode);
+    execute();
+    profiler_->end(start);
+#else
+    execute();
+#endif
+  }
+
+  // Keys, pushes and pops as described for `Access` above.
+  [[nodiscard]] bool key_pressed(uint8_t key) const noexcept(NOEXCEPT);
+  void push(uint16_t addr) noexcept(NOEXCEPT);
+  [[nodiscard]] uint16_t pop() noexcept(NOEXCEPT);
+
+  void execute_0(uint16_t opcode) noexcept(NOEXCEPT);
   void execute_1(uint16_t opcode) noexcept;
-  void execute_2(uint16_t opcode) noexcept;
+  void execute_2(uint16_t opcode) noexcept(NOEXCEPT);
   void execute_3(uint16_t opcode) noexcept;
   void execute_4(uint16_t opcode) noexcept;
   void execute_5(uint16_t opcode) noexcept;
@@ -53,22 +171,55 @@ private:
   void execute_B(uint16_t opcode) noexcept;
   void execute_C(uint16_t opcode) noexcept;
   void execute_D(uint16_t opcode) noexcept;
-  void execute_E(uint16_t opcode) noexcept;
-  void execute_F(uint16_t opcode) noexcept;
+  void execute_E(uint16_t opcode) noexcept(NOEXCEPT);
+  void execute_F(uint16_t opcode) noexcept(NOEXCEPT);
 
-  friend class Emulator;
+  // Operand-specialised handlers backing DispatchMode::Table, defined in
+  // chip8_cpu.cpp.
+  struct Ops;
 
-  std::reference_wrapper<Memory> memory_;
-  std::reference_wrapper<Display> display_;
-  std::reference_wrapper<Keyboard> keyboard_;
-  std::reference_wrapper<Timer> timer_;
-  std::reference_wrapper<RandomGenerator> rng_;
+  friend class BasicEmulator<Access>;
 
+  static constexpr std::size_t CACHE_LINE = 64;
+
+  // Everything the interpreter reads or writes per instruction, apart from
+  // the components, shares the first cache line; the pointers it follows
+  // to reach them fill the second.
+  alignas(CACHE_LINE) std::array<uint8_t, NUM_CPU_REGISTERS> v_{};
   std::array<uint16_t, NUM_CPU_STACK> stack_{};
-  std::array<uint8_t, NUM_CPU_REGISTERS> v_{};
   uint16_t I_{};
-  uint8_t sp_{};
   uint16_t pc_{};
+  uint8_t sp_{};
+  bool waiting_for_key_{false};
+  // Makes run() return after the current instruction; set by a blocked
+  // Fx0A, and by Fx18 while stop_on_sound_write_ is, so the Emulator can
+  // time buzzer changes to the instruction.
+  bool stop_run_{false};
+  bool stop_on_sound_write_{false};
+  DispatchMode dispatch_mode_{DispatchMode::Switch};
+
+  alignas(CACHE_LINE) std::reference_wrapper<BasicMemory<Access>> memory_;
+  std::reference_wrapper<Display> display_;
+  std::reference_wrapper<Keyboard> keyboard_;
+  std::reference_wrapper<Timer> timer_;
+  std::reference_wrapper<Random> rng_;
+  std::unique_ptr<DecodeCache<Handler>> decode_cache_;
+  std::unique_ptr<Jit> jit_;
+
+  uint64_t idle_cycles_skipped_{};
+#if CHIP8_ENABLE_INSTRUMENTATION
+  std::unique_ptr<OpcodeProfiler> profiler_{
+      std::make_unique<OpcodeProfiler>()};
+#endif
 };
 
+// Built in chip8_cpu.cpp: the PcgRandom ones, which Emulator runs, into
+// chip8_core; the RandomGenerator ones, for mocks, into chip8_test_cpu.
+extern template class BasicCpu<CheckedAccess>;
+extern template class BasicCpu<MaskedAccess>;
+extern template class BasicCpu<CheckedAccess, PcgRandom>;
+extern template class BasicCpu<MaskedAccess, PcgRandom>;
+
+using Cpu = BasicCpu<DefaultAccess>;
+
 } // namespace chip8
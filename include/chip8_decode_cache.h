@@ -0,0 +1,39 @@
+#pragma once
+#include "chip8_memory.h"
+#include "constants.h"
+#include <array>
+#include <cstdint>
+
+namespace chip8 {
+
+// Pre-decoded instructions keyed by the address they were fetched from. An
+// entry covers two bytes, so a write to `addr` drops the instructions
+// starting at `addr` and `addr - 1`, which wraps to the last address.
+// `Handler` is the owning Cpu's instruction handler pointer.
+template <typename Handler> class DecodeCache final : public MemoryObserver {
+public:
+  struct Entry {
+    Handler handler{nullptr};
+    uint16_t opcode{};
+  };
+
+  [[nodiscard]] const Entry &at(uint16_t pc) const noexcept {
+    return entries_[pc];
+  }
+
+  void fill(uint16_t pc, Handler handler, uint16_t opcode) noexcept {
+    entries_[pc] = {handler, opcode};
+  }
+
+  void invalidate_all() noexcept { entries_.fill({}); }
+
+  void on_write(uint16_t addr) noexcept override {
+    entries_[addr] = {};
+    entries_[(addr - 1) & (MEMORY_SIZE - 1)] = {};
+  }
+
+private:
+  std::array<Entry, MEMORY_SIZE> entries_{};
+};
+
+} // namespace chip8
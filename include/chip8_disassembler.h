@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace chip8 {
+
+// Cowgod-style mnemonic for one instruction, e.g. "DRW V0, V1, 5" or
+// "LD I, 0x2A0"; words that are not instructions come out as "DW 0x1234".
+[[nodiscard]] inline std::string disassemble(uint16_t opcode) {
+  const unsigned x = (opcode >> 8) & 0x0F;
+  const unsigned y = (opcode >> 4) & 0x0F;
+  const unsigned n = opcode & 0x000F;
+  const unsigned kk = opcode & 0x00FF;
+  const unsigned nnn = opcode & 0x0FFF;
+
+  char text[24];
+  auto format = [&](const char *pattern, auto... args) {
+    std::snprintf(text, sizeof(text), pattern, args...);
+    return std::string{text};
+  };
+
+  switch (opcode >> 12) {
+  case 0x0:
+    if (opcode == 0x00E0) {
+      return "CLS";
+    }
+    if (opcode == 0x00EE) {
+      return "RET";
+    }
+    return format("SYS 0x%03X", nnn);
+  case 0x1:
+    return format("JP 0x%03X", nnn);
+  case 0x2:
+    return format("CALL 0x%03X", nnn);
+  case 0x3:
+    return format("SE V%X, 0x%02X", x, kk);
+  case 0x4:
+    return format("SNE V%X, 0x%02X", x, kk);
+  case 0x5:
+    if (n == 0) {
+      return format("SE V%X, V%X", x, y);
+    }
+    break;
+  case 0x6:
+    return format("LD V%X, 0x%02X", x, kk);
+  case 0x7:
+    return format("ADD V%X, 0x%02X", x, kk);
+  case 0x8: {
+    static constexpr const char *ALU[16] = {
+        "LD",  "OR", "AND",  "XOR", "ADD", "SUB", "SHR", "SUBN",
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "SHL", nullptr};
+    if (ALU[n] != nullptr) {
+      return format("%s V%X, V%X", ALU[n], x, y);
+    }
+    break;
+  }
+  case 0x9:
+    if (n == 0) {
+      return format("SNE V%X, V%X", x, y);
+    }
+    break;
+  case 0xA:
+    return format("LD I, 0x%03X", nnn);
+  case 0xB:
+    return format("JP V0, 0x%03X", nnn);
+  case 0xC:
+    return format("RND V%X, 0x%02X", x, kk);
+  case 0xD:
+    return format("DRW V%X, V%X, %u", x, y, n);
+  case 0xE:
+    if (kk == 0x9E) {
+      return format("SKP V%X", x);
+    }
+    if (kk == 0xA1) {
+      return format("SKNP V%X", x);
+    }
+    break;
+  case 0xF:
+    switch (kk) {
+    case 0x07:
+      return format("LD V%X, DT", x);
+    case 0x0A:
+      return format("LD V%X, K", x);
+    case 0x15:
+      return format("LD DT, V%X", x);
+    case 0x18:
+      return format("LD ST, V%X", x);
+    case 0x1E:
+      return format("ADD I, V%X", x);
+    case 0x29:
+      return format("LD F, V%X", x);
+    case 0x33:
+      return format("LD B, V%X", x);
+    case 0x55:
+      return format("LD [I], V%X", x);
+    case 0x65:
+      return format("LD V%X, [I]", x);
+    default:
+      break;
+    }
+    break;
+  default:
+    break;
+  }
+  return format("DW 0x%04X", static_cast<unsigned>(opcode));
+}
+
+} // namespace chip8
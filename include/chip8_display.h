@@ -2,51 +2,98 @@
 #pragma once
 #include "constants.h"
 #include <array>
+#include <bit>
+#include <cstddef>
 #include <cstdint>
 #include <span>
+#include <utility>
 
 namespace chip8 {
 
 class Display {
 public:
-  explicit Display() noexcept { clear(); }
+  static_assert(SCREEN_WIDTH == 64, "one uint64_t per row");
+  static_assert(SCREEN_HEIGHT <= 32, "one dirty bit per row");
+
+  explicit Display() noexcept = default;
 
   // Clear screen
-  void clear() noexcept { buffer_.fill(0); }
+  void clear() noexcept {
+    for (int y = 0; y < SCREEN_HEIGHT; ++y) {
+      store_row(y, 0);
+    }
+  }
 
   // Set or reset pixel at (x,y)
   constexpr void set_pixel(int x, int y, bool on) noexcept {
     auto [nx, ny] = wrap(x, y);
-    buffer_[ny * SCREEN_WIDTH + nx] = on ? 1 : 0;
+    const uint64_t mask = pixel_mask(nx);
+    store_row(ny, on ? rows_[ny] | mask : rows_[ny] & ~mask);
   }
 
   // Query pixel state
   [[nodiscard]] constexpr bool is_pixel_set(int x, int y) const noexcept {
     auto [nx, ny] = wrap(x, y);
-    return buffer_[ny * SCREEN_WIDTH + nx] != 0;
+    return (rows_[ny] & pixel_mask(nx)) != 0;
   }
 
-  // Draw sprite at (x,y), returns true if collision occurred
+  // Draw sprite at (x,y), returns true if collision occurred. Each sprite
+  // row is rotated into place, so horizontal wrapping comes for free.
   [[nodiscard]] bool draw_sprite(int x, int y,
                                  std::span<const uint8_t> sprite) noexcept {
-    bool collision = false;
-    for (int row = 0; row < static_cast<int>(sprite.size()); ++row) {
-      uint8_t line = sprite[row];
-      for (int bit = 0; bit < 8; ++bit) {
-        if (line & (0b10000000 >> bit)) {
-          auto [nx, ny] = wrap(x + bit, y + row);
-          auto &pixel = buffer_[ny * SCREEN_WIDTH + nx];
-          if (pixel == 1) {
-            collision = true;
-          }
-          pixel ^= 1; // XOR drawing
-        }
-      }
+    auto [nx, ny] = wrap(x, y);
+    uint64_t collision = 0;
+    for (std::size_t row = 0; row < sprite.size(); ++row) {
+      const uint64_t bits = std::rotr(uint64_t{sprite[row]} << 56, nx);
+      const auto line = static_cast<int>((ny + row) % SCREEN_HEIGHT);
+      collision |= rows_[line] & bits;
+      store_row(line, rows_[line] ^ bits); // XOR drawing
+    }
+    return collision != 0;
+  }
+
+  // Packed framebuffer: bit 63 of a row is x = 0, bit 0 is x = 63.
+  [[nodiscard]] constexpr std::span<const uint64_t, SCREEN_HEIGHT>
+  rows() const noexcept {
+    return rows_;
+  }
+
+  // Replaces the framebuffer; rows that differ are marked dirty.
+  constexpr void
+  restore(std::span<const uint64_t, SCREEN_HEIGHT> rows) noexcept {
+    for (int y = 0; y < SCREEN_HEIGHT; ++y) {
+      store_row(y, rows[y]);
     }
-    return collision;
+  }
+
+  // Advances whenever a row actually changes. Consumers remember the value
+  // they last synchronised with and pass it to dirty_rows().
+  [[nodiscard]] constexpr uint64_t generation() const noexcept {
+    return generation_;
+  }
+
+  // Bit y is set when row y changed after `since` was read from
+  // generation(); zero means there is nothing new to show.
+  [[nodiscard]] constexpr uint32_t dirty_rows(uint64_t since) const noexcept {
+    uint32_t dirty = 0;
+    for (int y = 0; y < SCREEN_HEIGHT; ++y) {
+      dirty |= static_cast<uint32_t>(row_generation_[y] > since) << y;
+    }
+    return dirty;
   }
 
 private:
+  constexpr void store_row(int y, uint64_t bits) noexcept {
+    if (rows_[y] != bits) {
+      rows_[y] = bits;
+      row_generation_[y] = ++generation_;
+    }
+  }
+
+  [[nodiscard]] static constexpr uint64_t pixel_mask(int x) noexcept {
+    return uint64_t{1} << (SCREEN_WIDTH - 1 - x);
+  }
+
   // Wrap coordinates (Chip-8 wraps around screen edges)
   [[nodiscard]] static constexpr int wrap_coord(int value, int max) noexcept {
     const int mod = value % max;
@@ -58,7 +105,9 @@ private:
     return {wrap_coord(x, SCREEN_WIDTH), wrap_coord(y, SCREEN_HEIGHT)};
   }
 
-  std::array<uint8_t, SCREEN_WIDTH * SCREEN_HEIGHT> buffer_;
+  std::array<uint64_t, SCREEN_HEIGHT> rows_{};
+  std::array<uint64_t, SCREEN_HEIGHT> row_generation_{};
+  uint64_t generation_{};
 };
 
 } // namespace chip8
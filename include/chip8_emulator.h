@@ -4,12 +4,20 @@
 #include "chip8_keyboard.h"
 #include "chip8_memory.h"
 #include "chip8_pcg_rand.h"
+#include "chip8_rewind_buffer.h"
+#include "chip8_save_state.h"
 #include "chip8_timer.h"
 #include "constants.h"
 #include "emulator_types.h"
+#include "rom_profiler.h"
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <optional>
 #include <span>
 #include <stdexcept>
 #include <string>
@@ -17,11 +25,17 @@
 
 namespace chip8 {
 
-class Emulator {
+// `Access` is the memory access policy of the whole machine; see BasicCpu
+// for what it means for a ROM that strays outside memory.
+template <typename Access> class BasicEmulator {
 public:
-  explicit Emulator(uint32_t cycles_per_frame = 10)
-      : rng_{0xC0FFEEu}, cpu_{memory_, display_, Keyboard_, timers_, rng_},
-        cycles_per_frame_{cycles_per_frame}, state_{EmulatorState::Stopped} {}
+  static constexpr uint64_t DEFAULT_SEED = 0xC0FFEEu;
+
+  explicit BasicEmulator(uint32_t cycles_per_frame = 10,
+                         uint64_t seed = DEFAULT_SEED)
+      : rng_{seed}, cpu_{memory_, display_, Keyboard_, timers_, rng_},
+        cycles_per_frame_{cycles_per_frame}, state_{EmulatorState::Stopped},
+        seed_{seed} {}
 
   // Core lifecycle
   void start() noexcept { state_ = EmulatorState::Running; }
@@ -32,19 +46,46 @@ public:
   }
 
   void reset() noexcept {
-    memory_ = Memory{};
+    memory_ = BasicMemory<Access>{};
     display_.clear();
     Keyboard_ = Keyboard{};
     timers_ = Timer{};
-    rng_.reseed(0xC0FFEEu);
+    rng_.reseed(seed_);
     cpu_.reset();
     state_ = EmulatorState::Stopped;
+    if (rewind_) {
+      rewind_->clear();
+    }
   }
 
   void set_cycles_per_frame(uint32_t cycles) noexcept {
     cycles_per_frame_ = cycles;
   }
 
+  // Takes effect at the next reset(), i.e. when the next ROM is loaded.
+  void set_seed(uint64_t seed) noexcept { seed_ = seed; }
+  [[nodiscard]] constexpr uint64_t seed() const noexcept { return seed_; }
+
+  [[nodiscard]] constexpr uint32_t cycles_per_frame() const noexcept {
+    return cycles_per_frame_;
+  }
+
+  // On by default: frames end in the same state either way, idle loops such
+  // as waiting on the delay timer just stop costing their cycles. See
+  // Cpu::run_skipping_idle().
+  void set_skip_idle_loops(bool enabled) noexcept {
+    skip_idle_loops_ = enabled;
+  }
+  [[nodiscard]] constexpr bool skip_idle_loops() const noexcept {
+    return skip_idle_loops_;
+  }
+
+  // Throws std::runtime_error, keeping the current mode, if `mode` cannot
+  // run here, e.g. DispatchMode::Jit off x86-64; see Cpu::set_dispatch_mode().
+  void set_dispatch_mode(DispatchMode mode) {
+    cpu_.set_dispatch_mode(mode);
+  }
+
   void load_rom(std::span<const uint8_t> rom) {
     if (rom.empty()) {
       throw std::invalid_argument("ROM data is empty.");
@@ -94,15 +135,55 @@ public:
     uint32_t cycles_to_run =
         cycles_override > 0 ? cycles_override : cycles_per_frame_;
 
-    for (uint32_t i = 0; i < cycles_to_run; ++i)
-      cpu_.execute();
+    report_beep(0);
+    if (cpu_.waiting_for_key_ && !Keyboard_.last_pressed().has_value()) {
+      // Parked: the Fx0A would only spin, so only the timers move.
+    } else if (profiler_) {
+      cpu_.waiting_for_key_ = false;
+      const auto memory = memory_.span();
+      for (uint32_t i = 0; i < cycles_to_run && !cpu_.waiting_for_key_;
+           ++i) {
+        const uint16_t pc = cpu_.pc_;
+        const auto opcode =
+            pc < MEMORY_SIZE - 1
+                ? static_cast<uint16_t>(memory[pc] << 8 | memory[pc + 1])
+                : uint16_t{0};
+        profiler_->sample(pc, opcode, cpu_.I_, cpu_.call_stack());
+        cpu_.execute();
+        report_beep(i, cycles_to_run);
+      }
+    } else if (beep_sink_) {
+      // The CPU stops after every Fx18, so each change is timed exactly.
+      cpu_.waiting_for_key_ = false;
+      uint32_t done = 0;
+      while (done < cycles_to_run && !cpu_.waiting_for_key_) {
+        const uint32_t rest = cycles_to_run - done;
+        done += skip_idle_loops_ ? cpu_.run_skipping_idle(rest)
+                                 : cpu_.run(rest);
+        report_beep(done - 1, cycles_to_run);
+      }
+    } else if (skip_idle_loops_) {
+      cpu_.run_skipping_idle(cycles_to_run);
+    } else {
+      cpu_.run(cycles_to_run);
+    }
 
     // Tick timers once per frame (typically 60 Hz)
     tick_timers(1);
+    if (beep_sink_) {
+      beep_sink_->end_frame();
+      report_beep(0); // the tick may have ended the beep
+    }
+
+    if (rewind_) {
+      save_state(scratch_state_);
+      rewind_->push(scratch_state_);
+    }
 
     return {
         .frame_complete = true,
         .sound_active = timers_.beep(),
+        .waiting_for_key = cpu_.waiting_for_key_,
     };
   }
 
@@ -111,6 +192,143 @@ public:
       timers_.tick_60hz();
   }
 
+  // Snapshot of memory, CPU, timers, keys, framebuffer and RNG; cheap
+  // enough to take every frame. Settings such as cycles per frame and the
+  // dispatch mode are not part of it.
+  [[nodiscard]] SaveState save_state() const noexcept {
+    SaveState state;
+    save_state(state);
+    return state;
+  }
+
+  void save_state(SaveState &out) const noexcept {
+    out.magic = SaveState::MAGIC;
+    out.version = SaveState::VERSION;
+    out.pc = cpu_.pc_;
+    out.index = cpu_.I_;
+    out.keys = Keyboard_.key_mask();
+    out.sp = cpu_.sp_;
+    out.delay = timers_.delay();
+    out.sound = timers_.sound();
+    out.last_pressed = Keyboard_.last_pressed().value_or(SaveState::NO_KEY);
+    out.run_state = static_cast<uint8_t>(state_);
+    out.reserved = {};
+    out.v = cpu_.v_;
+    out.stack = cpu_.stack_;
+    std::ranges::copy(display_.rows(), out.display.begin());
+    std::ranges::copy(memory_.span(), out.memory.begin());
+    out.rng = {};
+    std::memcpy(out.rng.data(), &rng_.engine(), sizeof(SaveState::RngEngine));
+  }
+
+  // Throws std::invalid_argument, leaving the emulator untouched, when
+  // `state` does not come from a compatible save_state().
+  void load_state(const SaveState &state) {
+    if (state.magic != SaveState::MAGIC) {
+      throw std::invalid_argument("Not a CHIP-8 save state.");
+    }
+    if (state.version != SaveState::VERSION) {
+      throw std::invalid_argument("Unsupported save state version.");
+    }
+    if (state.sp > NUM_CPU_STACK ||
+        state.run_state > static_cast<uint8_t>(EmulatorState::Paused) ||
+        (state.last_pressed >= NUM_KEYS &&
+         state.last_pressed != SaveState::NO_KEY)) {
+      throw std::invalid_argument("Corrupt save state.");
+    }
+
+    memory_.restore(state.memory);
+    display_.restore(state.display);
+    Keyboard_.restore(state.keys,
+                      state.last_pressed == SaveState::NO_KEY
+                          ? std::nullopt
+                          : std::optional<uint8_t>{state.last_pressed});
+    timers_.set_delay(state.delay);
+    timers_.set_sound(state.sound);
+    std::memcpy(&rng_.engine(), state.rng.data(), sizeof(SaveState::RngEngine));
+    cpu_.v_ = state.v;
+    cpu_.stack_ = state.stack;
+    cpu_.I_ = state.index;
+    cpu_.sp_ = state.sp;
+    cpu_.pc_ = state.pc;
+    cpu_.waiting_for_key_ = false;
+    // Cached decodes and translated blocks describe the old memory.
+    cpu_.attach_memory_observer();
+    state_ = static_cast<EmulatorState>(state.run_state);
+  }
+
+  // Accepts the raw bytes of a SaveState, e.g. read back from a file.
+  void load_state(std::span<const std::byte> bytes) {
+    if (bytes.size() != sizeof(SaveState)) {
+      throw std::invalid_argument("Save state has the wrong size.");
+    }
+    SaveState state;
+    std::memcpy(&state, bytes.data(), sizeof(SaveState));
+    load_state(state);
+  }
+
+  // Records the state after every frame from now on, in `capacity_bytes`
+  // of delta-compressed history (see RewindBuffer).
+  void enable_rewind(
+      std::size_t capacity_bytes = RewindBuffer::DEFAULT_CAPACITY,
+      uint32_t keyframe_interval = RewindBuffer::DEFAULT_KEYFRAME_INTERVAL) {
+    rewind_ = std::make_unique<RewindBuffer>(capacity_bytes, keyframe_interval);
+  }
+
+  void disable_rewind() noexcept { rewind_.reset(); }
+
+  // Steps back up to `frames` recorded frames and returns how many it went.
+  // The keys keep their live state so a held button is not replayed from
+  // history; the rewound frames are forgotten.
+  uint32_t rewind(uint32_t frames = 1) {
+    if (!rewind_ || rewind_->size() < 2) {
+      return 0;
+    }
+    const auto steps = static_cast<uint32_t>(
+        std::min<std::size_t>(frames, rewind_->size() - 1));
+    for (uint32_t i = 0; i < steps; ++i) {
+      rewind_->pop();
+    }
+    const uint16_t keys = Keyboard_.key_mask();
+    const auto last_pressed = Keyboard_.last_pressed();
+    load_state(rewind_->newest());
+    Keyboard_.restore(keys, last_pressed);
+    return steps;
+  }
+
+  // Recorded history, e.g. for bisecting to the frame where something went
+  // wrong with RewindBuffer::read() and load_state(); null when disabled.
+  [[nodiscard]] const RewindBuffer *rewind_buffer() const noexcept {
+    return rewind_.get();
+  }
+
+  // Samples every instruction and data access from now on, see
+  // RomProfiler. Runs one instruction at a time, so the JIT is bypassed
+  // while profiling. The profile survives loading another ROM.
+  void enable_profiling() { profiler_ = std::make_unique<RomProfiler>(); }
+  void disable_profiling() noexcept { profiler_.reset(); }
+
+  // Null unless profiling.
+  [[nodiscard]] const RomProfiler *profiler() const noexcept {
+    return profiler_.get();
+  }
+
+  // Reports every buzzer change to `sink` from now on, starting from off;
+  // null stops reporting. The sink is not owned and must outlive its use.
+  // The CPU then returns to run_frame() after each Fx18, which is rare
+  // enough not to slow it down.
+  void set_beep_sink(BeepSink *sink) noexcept {
+    beep_sink_ = sink;
+    reported_beep_ = false;
+    cpu_.stop_on_sound_write_ = sink != nullptr;
+  }
+
+  // Whether the ROM is blocked in Fx0A; run_frame() then costs next to
+  // nothing until a key goes down.
+  [[nodiscard]] constexpr bool waiting_for_key() const noexcept {
+    return cpu_.waiting_for_key();
+  }
+
   [[nodiscard]] constexpr EmulatorState state() const noexcept {
     return state_;
   }
@@ -121,16 +339,46 @@ public:
 
   [[nodiscard]] constexpr Keyboard &keyboard() noexcept { return Keyboard_; }
 
+  [[nodiscard]] constexpr BasicMemory<Access> const &memory() const noexcept {
+    return memory_;
+  }
+
+  [[nodiscard]] constexpr BasicCpu<Access, PcgRandom> const &
+  cpu() const noexcept {
+    return cpu_;
+  }
+
 private:
-  Memory memory_;
+  // Tells the sink if the buzzer changed, dating the change to instruction
+  // `cycle` of the `cycles` in this frame.
+  void report_beep(uint32_t cycle, uint32_t cycles = 1) {
+    if (beep_sink_ && timers_.beep() != reported_beep_) {
+      reported_beep_ = !reported_beep_;
+      beep_sink_->beep(static_cast<float>(static_cast<double>(cycle) /
+                                          cycles),
+                       reported_beep_);
+    }
+  }
+
+  BasicMemory<Access> memory_;
   Display display_;
   Keyboard Keyboard_;
   Timer timers_;
   PcgRandom rng_;
-  Cpu cpu_;
+  BasicCpu<Access, PcgRandom> cpu_;
 
   EmulatorState state_;
   uint32_t cycles_per_frame_;
+  uint64_t seed_;
+  bool skip_idle_loops_{true};
+
+  std::unique_ptr<RewindBuffer> rewind_;
+  SaveState scratch_state_;
+  std::unique_ptr<RomProfiler> profiler_;
+  BeepSink *beep_sink_{nullptr};
+  bool reported_beep_{false};
 };
 
+using Emulator = BasicEmulator<DefaultAccess>;
+
 } // namespace chip8
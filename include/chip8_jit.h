@@ -0,0 +1,83 @@
+#pragma once
+#include "chip8_memory.h"
+#include "constants.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace chip8 {
+
+// Translates runs of register-only instructions (6xkk, 7xkk, 8xyN, Annn,
+// Fx1E, Fx29, the 3/4/5/9 skips and 1nnn) into x86-64. Anything touching
+// the display, keyboard, timers, RNG, stack or memory ends the block and is
+// left to the interpreter. Blocks are dropped when memory under them is
+// written, and an address that keeps getting rewritten is interpreted from
+// then on.
+class Jit final : public MemoryObserver {
+public:
+  // Shared with generated code; the layout is baked into the emitted
+  // instructions.
+  struct Frame {
+    uint8_t *v;
+    uint16_t *index;
+    uint16_t pc;
+    uint32_t budget;
+    uint32_t executed;
+  };
+  static_assert(offsetof(Frame, v) == 0 && offsetof(Frame, index) == 8 &&
+                offsetof(Frame, pc) == 16 && offsetof(Frame, budget) == 20 &&
+                offsetof(Frame, executed) == 24);
+
+  [[nodiscard]] static constexpr bool supported() noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // Throws std::runtime_error off x86-64 or when the code buffer cannot be
+  // mapped.
+  Jit();
+  ~Jit() override;
+
+  Jit(const Jit &) = delete;
+  Jit &operator=(const Jit &) = delete;
+
+  // Runs translated code from frame.pc for at most frame.budget (> 0)
+  // instructions and updates pc/executed. Returns false, leaving the frame
+  // untouched, when the instruction at frame.pc has to be interpreted.
+  // Code is written while its pages are writable and only run once they are
+  // executable instead; throws std::runtime_error if the host refuses
+  // either switch.
+  [[nodiscard]] bool run(std::span<const uint8_t, MEMORY_SIZE> memory,
+                         Frame &frame);
+
+  void invalidate_all() noexcept;
+  void on_write(uint16_t addr) noexcept override;
+
+private:
+  using BlockFn = void (*)(Frame *);
+
+  enum class BlockState : uint8_t { Unknown, Compiled, Interpreted };
+
+  struct Block {
+    BlockFn fn{nullptr};
+    uint16_t end{};
+    BlockState state{BlockState::Unknown};
+  };
+
+  void compile(std::span<const uint8_t, MEMORY_SIZE> memory, uint16_t start);
+
+  static constexpr std::size_t CODE_SIZE = 1 << 20;
+  static constexpr uint16_t MAX_BLOCK_INSTRUCTIONS = 64;
+  static constexpr uint8_t MAX_INVALIDATIONS = 8;
+
+  uint8_t *code_{nullptr};
+  std::size_t code_used_{};
+  std::array<Block, MEMORY_SIZE> blocks_{};
+  std::array<uint8_t, MEMORY_SIZE> invalidations_{};
+};
+
+} // namespace chip8
@@ -33,6 +33,37 @@ public:
   // Clear last_pressed_ after being consumed by Fx instructions
   void clear_last_pressed() noexcept { last_pressed_.reset(); }
 
+  // Bit k is set while key k is held.
+  [[nodiscard]] uint16_t key_mask() const noexcept {
+    uint16_t mask = 0;
+    for (uint8_t key = 0; key < NUM_KEYS; ++key) {
+      mask |= static_cast<uint16_t>(keys_[key]) << key;
+    }
+    return mask;
+  }
+
+  // Presses and releases keys until the held set equals `mask`, in key
+  // order, as if the changes had arrived one by one through
+  // set_key_state(); keys that keep their state are left alone.
+  void set_key_mask(uint16_t mask) noexcept {
+    for (uint8_t key = 0; key < NUM_KEYS; ++key) {
+      const bool pressed = (mask >> key & 1u) != 0;
+      if (keys_[key] != pressed) {
+        set_key_state(key, pressed);
+      }
+    }
+  }
+
+  void restore(uint16_t mask, std::optional<uint8_t> last_pressed) {
+    if (last_pressed.has_value()) {
+      check_key_bounds(last_pressed.value());
+    }
+    for (uint8_t key = 0; key < NUM_KEYS; ++key) {
+      keys_[key] = (mask >> key & 1u) != 0;
+    }
+    last_pressed_ = last_pressed;
+  }
+
 private:
   void check_key_bounds(uint8_t key) const {
     if (key >= NUM_KEYS) {
@@ -0,0 +1,126 @@
+#pragma once
+#include "chip8_pcg_rand.h"
+#include "constants.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace chip8 {
+
+// Runs N copies of one ROM that differ only in RNG seed and keypad input.
+// Registers, I, PC, SP, timers and framebuffers are stored lane by lane in
+// structure-of-arrays form (v_[x * N + lane] and so on), so an instruction
+// shared by a range of lanes is one loop over contiguous arrays that the
+// compiler turns into SIMD code. Each cycle the lanes are split into runs of
+// neighbours with the same PC and opcode; while the copies agree that is a
+// single run over all lanes, and when they diverge the stragglers simply
+// execute in shorter runs, down to one lane at a time.
+//
+// Every lane matches an Emulator constructed with the same cycles per frame
+// and seed, fed the same Keyboard::set_key_mask() calls, bit for bit,
+// including how DefaultAccess treats addresses outside memory, keys above
+// 0xF and stack overflow or underflow: a lane wraps them as Cpu does, or
+// throws the same std::out_of_range in checked builds.
+class LockstepEngine {
+public:
+  struct Stats {
+    uint64_t lockstep_cycles{}; // every lane ran the same instruction
+    uint64_t divergent_cycles{};
+  };
+
+  explicit LockstepEngine(std::size_t lanes, uint32_t cycles_per_frame = 10);
+
+  // Resets every lane to a fresh Emulator::load_rom(rom); lane i draws its
+  // random numbers from PcgRandom(seeds[i]).
+  void load_rom(std::span<const uint8_t> rom, std::span<const uint64_t> seeds);
+
+  // Same effect as Keyboard::set_key_mask() on the lane's keypad.
+  void set_key_mask(std::size_t lane, uint16_t mask) noexcept;
+
+  // Same as Emulator::run_frame() on every lane.
+  void run_frame();
+
+  [[nodiscard]] std::size_t lanes() const noexcept { return lanes_; }
+  [[nodiscard]] uint32_t cycles_per_frame() const noexcept {
+    return cycles_per_frame_;
+  }
+  [[nodiscard]] const Stats &stats() const noexcept { return stats_; }
+
+  [[nodiscard]] uint16_t program_counter(std::size_t lane) const noexcept {
+    return pc_[lane];
+  }
+  [[nodiscard]] uint16_t index_register(std::size_t lane) const noexcept {
+    return I_[lane];
+  }
+  [[nodiscard]] std::array<uint8_t, NUM_CPU_REGISTERS>
+  registers(std::size_t lane) const noexcept;
+  [[nodiscard]] uint8_t delay(std::size_t lane) const noexcept {
+    return delay_[lane];
+  }
+  [[nodiscard]] uint8_t sound(std::size_t lane) const noexcept {
+    return sound_[lane];
+  }
+  [[nodiscard]] std::optional<uint8_t>
+  last_pressed(std::size_t lane) const noexcept;
+
+  [[nodiscard]] std::span<const uint8_t, MEMORY_SIZE>
+  memory(std::size_t lane) const noexcept {
+    return std::span<const uint8_t, MEMORY_SIZE>{
+        memory_.data() + lane * MEMORY_SIZE, MEMORY_SIZE};
+  }
+
+  // Packed like Display::rows().
+  [[nodiscard]] std::span<const uint64_t, SCREEN_HEIGHT>
+  rows(std::size_t lane) const noexcept {
+    return std::span<const uint64_t, SCREEN_HEIGHT>{
+        rows_.data() + lane * SCREEN_HEIGHT, SCREEN_HEIGHT};
+  }
+
+  // Every lane's rows back to back, lane 0 first.
+  [[nodiscard]] std::span<const uint64_t> all_rows() const noexcept {
+    return rows_;
+  }
+
+private:
+  static constexpr uint8_t NO_KEY = 0xFF;
+
+  void step();
+  [[nodiscard]] uint16_t fetch(std::size_t lane, uint16_t pc) const;
+  // Runs `opcode` on lanes [begin, end), whose PCs already point past it.
+  void execute(uint16_t opcode, std::size_t begin, std::size_t end);
+  void execute_8(uint16_t opcode, std::size_t begin, std::size_t end);
+  void execute_F(uint16_t opcode, std::size_t begin, std::size_t end);
+  void draw(uint16_t opcode, std::size_t lane);
+  void write_memory(std::size_t lane, uint16_t addr, uint8_t value);
+
+  [[nodiscard]] uint8_t *reg(std::size_t x) noexcept {
+    return v_.data() + x * lanes_;
+  }
+
+  std::size_t lanes_;
+  uint32_t cycles_per_frame_;
+
+  std::vector<uint8_t> v_;        // [register][lane]
+  std::vector<uint16_t> I_;
+  std::vector<uint16_t> pc_;
+  std::vector<uint8_t> sp_;
+  std::vector<uint16_t> stack_;   // [lane][level]
+  std::vector<uint8_t> delay_;
+  std::vector<uint8_t> sound_;
+  std::vector<uint16_t> keys_;    // bit k set while key k is held
+  std::vector<uint8_t> last_pressed_;
+  std::vector<uint64_t> rows_;    // [lane][row]
+  std::vector<uint8_t> memory_;   // [lane][address]
+  std::vector<PcgRandom> rng_;
+
+  // Addresses some lane has written since load_rom(). Lanes sharing a PC
+  // can only disagree on the opcode if one of its bytes is in here.
+  std::array<bool, MEMORY_SIZE> written_{};
+
+  Stats stats_;
+};
+
+} // namespace chip8
@@ -8,26 +8,70 @@
 
 namespace chip8 {
 
-class Memory {
+// Notified after every write, e.g. to drop cached decodes of that address.
+class MemoryObserver {
 public:
-  constexpr explicit Memory() noexcept : data_{} {
+  virtual ~MemoryObserver() = default;
+  virtual void on_write(uint16_t addr) noexcept = 0;
+};
+
+// Memory access policies. CheckedAccess throws std::out_of_range for an
+// address past the end, to catch a ROM that strays while debugging it;
+// MaskedAccess wraps every address to 12 bits like the original address
+// bus, with no branch and nothing to throw.
+struct CheckedAccess {
+  static constexpr bool THROWS = true;
+
+  [[nodiscard]] static constexpr uint16_t address(uint16_t addr) {
+    if (addr >= MEMORY_SIZE) {
+      throw std::out_of_range("Memory access out of bounds\n");
+    }
+    return addr;
+  }
+};
+
+struct MaskedAccess {
+  static_assert((MEMORY_SIZE & (MEMORY_SIZE - 1)) == 0);
+  static constexpr bool THROWS = false;
+
+  [[nodiscard]] static constexpr uint16_t address(uint16_t addr) noexcept {
+    return static_cast<uint16_t>(addr & (MEMORY_SIZE - 1));
+  }
+};
+
+// Configure with -DCHIP8_CHECKED_MEMORY=ON to make Memory, Cpu and Emulator
+// check every access.
+#if CHIP8_CHECKED_MEMORY
+using DefaultAccess = CheckedAccess;
+#else
+using DefaultAccess = MaskedAccess;
+#endif
+
+template <typename Access> class BasicMemory {
+public:
+  constexpr explicit BasicMemory() noexcept : data_{} {
     std::copy(DEFAULT_CHAR_SET.begin(), DEFAULT_CHAR_SET.end(), data_.begin());
   };
 
-  constexpr void write_byte(uint16_t addr, uint8_t val) {
-    check_bounds(addr);
+  // The observer hears the address actually written.
+  constexpr void write_byte(uint16_t addr,
+                            uint8_t val) noexcept(!Access::THROWS) {
+    addr = Access::address(addr);
     data_[addr] = val;
+    if (observer_ != nullptr) {
+      observer_->on_write(addr);
+    }
   }
 
-  [[nodiscard]] constexpr uint8_t read_byte(uint16_t addr) {
-    check_bounds(addr);
-    return data_[addr];
+  [[nodiscard]] constexpr uint8_t
+  read_byte(uint16_t addr) noexcept(!Access::THROWS) {
+    return data_[Access::address(addr)];
   }
 
-  [[nodiscard]] constexpr uint16_t read_two_bytes(uint16_t addr) {
-    check_bounds(addr + 1);
-    return static_cast<uint16_t>(data_[addr]) << 8 |
-           static_cast<uint16_t>(data_[addr + 1]);
+  [[nodiscard]] constexpr uint16_t
+  read_two_bytes(uint16_t addr) noexcept(!Access::THROWS) {
+    return static_cast<uint16_t>(data_[Access::address(addr)]) << 8 |
+           static_cast<uint16_t>(data_[Access::address(addr + 1)]);
   }
 
   [[nodiscard]] constexpr std::span<const uint8_t, MEMORY_SIZE>
@@ -35,13 +79,22 @@ public:
     return {data_};
   }
 
-private:
-  constexpr void check_bounds(uint16_t addr) const {
-    if (addr >= MEMORY_SIZE) {
-      throw std::out_of_range("Memory access out of bounds\n");
-    }
+  // Replaces the whole contents without notifying the observer; whoever
+  // attached it has to drop anything derived from the old bytes.
+  constexpr void restore(std::span<const uint8_t, MEMORY_SIZE> bytes) noexcept {
+    std::copy(bytes.begin(), bytes.end(), data_.begin());
+  }
+
+  // At most one observer; pass nullptr to detach.
+  constexpr void set_observer(MemoryObserver *observer) noexcept {
+    observer_ = observer;
   }
+
+private:
   std::array<uint8_t, MEMORY_SIZE> data_;
+  MemoryObserver *observer_{nullptr};
 };
 
+using Memory = BasicMemory<DefaultAccess>;
+
 } // namespace chip8
\ No newline at end of file
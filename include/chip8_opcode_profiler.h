@@ -0,0 +1,280 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Build with -DCHIP8_ENABLE_INSTRUMENTATION=ON (CMake) to have every Cpu
+// count what it executes. Off by default: Cpu then has no profiler member
+// and no hooks, so the interpreter compiles exactly as without this header.
+#ifndef CHIP8_ENABLE_INSTRUMENTATION
+#define CHIP8_ENABLE_INSTRUMENTATION 0
+#endif
+
+namespace chip8 {
+
+// Counts executions per opcode pattern ("8xy4", "Fx33", ...) and, for one
+// in SAMPLE_INTERVAL instructions, how many cycle-counter ticks the whole
+// execute() took, in power-of-two buckets per opcode family. Instructions
+// run as translated JIT code are only counted in bulk.
+class OpcodeProfiler {
+public:
+  static constexpr uint32_t SAMPLE_INTERVAL = 64;
+  static constexpr std::size_t NUM_BUCKETS = 32;
+
+  using Ticks = uint64_t;
+
+  // Reads a monotonic cycle counter: TSC on x86, the virtual counter on
+  // arm64, steady_clock nanoseconds elsewhere.
+  [[nodiscard]] static Ticks now() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return static_cast<Ticks>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+  }
+
+  // Operands masked out: the sub-op is the low nibble for 8xyN, the low
+  // byte for ExNN and FxNN, and 00E0/00EE are told apart from 0nnn.
+  [[nodiscard]] static constexpr uint16_t pattern(uint16_t opcode) noexcept {
+    switch (opcode >> 12) {
+    case 0x0:
+      return opcode == 0x00E0 || opcode == 0x00EE ? opcode : 0x0000;
+    case 0x8:
+      return opcode & 0xF00F;
+    case 0xE:
+    case 0xF:
+      return opcode & 0xF0FF;
+    default:
+      return opcode & 0xF000;
+    }
+  }
+
+  // "8xy4", "Fx33", "Dxyn", "1nnn", "00EE".
+  [[nodiscard]] static std::string pattern_name(uint16_t pattern) {
+    char digits[5];
+    std::snprintf(digits, sizeof(digits), "%04X", pattern);
+    std::string name{digits};
+    switch (pattern >> 12) {
+    case 0x0:
+      if (pattern == 0x0000) {
+        name = "0nnn";
+      }
+      break;
+    case 0x1:
+    case 0x2:
+    case 0xA:
+    case 0xB:
+      name.replace(1, 3, "nnn");
+      break;
+    case 0x3:
+    case 0x4:
+    case 0x6:
+    case 0x7:
+    case 0xC:
+      name.replace(1, 3, "xkk");
+      break;
+    case 0x5:
+    case 0x8:
+    case 0x9:
+      name.replace(1, 2, "xy");
+      break;
+    case 0xD:
+      name.replace(1, 3, "xyn");
+      break;
+    default: // E, F
+      name[1] = 'x';
+      break;
+    }
+    return name;
+  }
+
+  // Returns the start time if this instruction is sampled, 0 otherwise.
+  [[nodiscard]] Ticks begin(uint16_t opcode) noexcept {
+    ++counts_[index(pattern(opcode))];
+    if (++until_sample_ < SAMPLE_INTERVAL) {
+      return 0;
+    }
+    until_sample_ = 0;
+    sampled_family_ = opcode >> 12;
+    return now();
+  }
+
+  void end(Ticks start) noexcept {
+    if (start == 0) {
+      return;
+    }
+    const Ticks elapsed = now() - start;
+    const auto bucket = std::min<std::size_t>(
+        static_cast<std::size_t>(std::bit_width(elapsed)), NUM_BUCKETS - 1);
+    ++timings_[sampled_family_][bucket];
+  }
+
+  void count_native(uint64_t instructions) noexcept {
+    native_ += instructions;
+  }
+
+  [[nodiscard]] uint64_t count(uint16_t pattern) const noexcept {
+    return counts_[index(pattern)];
+  }
+  [[nodiscard]] uint64_t native() const noexcept { return native_; }
+  [[nodiscard]] uint64_t total() const noexcept {
+    uint64_t sum = native_;
+    for (const uint64_t count : counts_) {
+      sum += count;
+    }
+    return sum;
+  }
+
+  void merge(const OpcodeProfiler &other) noexcept {
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    for (std::size_t f = 0; f < timings_.size(); ++f) {
+      for (std::size_t b = 0; b < NUM_BUCKETS; ++b) {
+        timings_[f][b] += other.timings_[f][b];
+      }
+    }
+    native_ += other.native_;
+  }
+
+  // Patterns by descending count, then per family the sampled median and
+  // 90th percentile as the upper bound of their bucket.
+  void report(std::ostream &out) const {
+    struct Row {
+      std::string name;
+      uint16_t pattern;
+      uint64_t count;
+    };
+    std::vector<Row> rows;
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+      if (counts_[i] != 0) {
+        rows.push_back(
+            {pattern_name(pattern_at(i)), pattern_at(i), counts_[i]});
+      }
+    }
+    if (native_ != 0) {
+      rows.push_back({"jit", 0xFFFF, native_});
+    }
+    std::ranges::sort(rows, [](const Row &a, const Row &b) {
+      return a.count != b.count ? a.count > b.count : a.pattern < b.pattern;
+    });
+
+    const uint64_t all = total();
+    out << "opcode        count      share\n";
+    char line[64];
+    for (const Row &row : rows) {
+      std::snprintf(line, sizeof(line), "%-6s %12llu %9.2f%%\n",
+                    row.name.c_str(),
+                    static_cast<unsigned long long>(row.count),
+                    100.0 * static_cast<double>(row.count) /
+                        static_cast<double>(all));
+      out << line;
+    }
+
+    out << "family  samples  median_ticks  p90_ticks\n";
+    for (std::size_t family = 0; family < timings_.size(); ++family) {
+      const auto &buckets = timings_[family];
+      uint64_t samples = 0;
+      for (const uint64_t n : buckets) {
+        samples += n;
+      }
+      if (samples == 0) {
+        continue;
+      }
+      std::snprintf(line, sizeof(line), "%Xxxx    %7llu  <%11llu  <%8llu\n",
+                    static_cast<unsigned>(family),
+                    static_cast<unsigned long long>(samples),
+                    static_cast<unsigned long long>(
+                        percentile_bound(buckets, samples, 50)),
+                    static_cast<unsigned long long>(
+                        percentile_bound(buckets, samples, 90)));
+      out << line;
+    }
+  }
+
+private:
+  // Families 0-F times 256 sub-ops covers every pattern().
+  [[nodiscard]] static constexpr std::size_t index(uint16_t pattern) noexcept {
+    return std::size_t{pattern} >> 12 << 8 | (pattern & 0xFF);
+  }
+  [[nodiscard]] static constexpr uint16_t pattern_at(std::size_t i) noexcept {
+    return static_cast<uint16_t>((i >> 8) << 12 | (i & 0xFF));
+  }
+
+  [[nodiscard]] static uint64_t
+  percentile_bound(const std::array<uint64_t, NUM_BUCKETS> &buckets,
+                   uint64_t samples, uint64_t percent) noexcept {
+    uint64_t seen = 0;
+    for (std::size_t b = 0; b < NUM_BUCKETS; ++b) {
+      seen += buckets[b];
+      if (seen * 100 >= samples * percent) {
+        return uint64_t{1} << b;
+      }
+    }
+    return uint64_t{1} << (NUM_BUCKETS - 1);
+  }
+
+  std::array<uint64_t, 16 * 256> counts_{};
+  std::array<std::array<uint64_t, NUM_BUCKETS>, 16> timings_{};
+  uint64_t native_{};
+  uint32_t until_sample_{};
+  uint32_t sampled_family_{};
+};
+
+// Profiles of every Cpu destroyed so far, printed to stderr at exit.
+class ProcessProfile {
+public:
+  static ProcessProfile &instance() {
+    static ProcessProfile profile;
+    return profile;
+  }
+
+  void add(const OpcodeProfiler &profiler) {
+    std::lock_guard lock{mutex_};
+    merged_.merge(profiler);
+  }
+
+  [[nodiscard]] OpcodeProfiler snapshot() const {
+    std::lock_guard lock{mutex_};
+    return merged_;
+  }
+
+  ProcessProfile(const ProcessProfile &) = delete;
+  ProcessProfile &operator=(const ProcessProfile &) = delete;
+
+  ~ProcessProfile() {
+    if (merged_.total() != 0) {
+      merged_.report(std::cerr);
+    }
+  }
+
+private:
+  ProcessProfile() = default;
+
+  mutable std::mutex mutex_;
+  OpcodeProfiler merged_;
+};
+
+} // namespace chip8
@@ -5,8 +5,11 @@
 
 namespace chip8 {
 
-class PcgRandom : public RandomGenerator {
+// Final, so a call through PcgRandom& is direct; see BasicCpu.
+class PcgRandom final : public RandomGenerator {
 public:
+  using Engine = std::mt19937_64;
+
   explicit PcgRandom(uint64_t seed = std::random_device{}()) noexcept
       : engine_(seed), dist_(0, 255) {}
 
@@ -16,8 +19,12 @@ public:
 
   void reseed(uint64_t seed) { engine_.seed(seed); }
 
+  // The distribution is stateless, so the engine is the whole RNG state.
+  [[nodiscard]] Engine &engine() noexcept { return engine_; }
+  [[nodiscard]] const Engine &engine() const noexcept { return engine_; }
+
 private:
-  std::mt19937_64 engine_;
+  Engine engine_;
   std::uniform_int_distribution<int> dist_;
 };
 
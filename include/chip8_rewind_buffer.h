@@ -0,0 +1,291 @@
+#pragma once
+#include "chip8_save_state.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace chip8 {
+
+// Frame history in a fixed block of bytes. Every `keyframe_interval`-th
+// state is stored whole; the ones in between only as the XOR against their
+// predecessor. Both kinds are run-length encoded, so unchanged bytes cost
+// nothing and a typical frame takes a few dozen bytes. Going back one frame
+// undoes the newest delta; reading an arbitrary frame replays at most one
+// keyframe interval. When the block is full, the oldest keyframe is dropped
+// together with the deltas that depend on it. Nothing is allocated after
+// construction.
+class RewindBuffer {
+public:
+  static constexpr std::size_t DEFAULT_CAPACITY = 8u << 20;
+  static constexpr uint32_t DEFAULT_KEYFRAME_INTERVAL = 60;
+
+  explicit RewindBuffer(
+      std::size_t capacity_bytes = DEFAULT_CAPACITY,
+      uint32_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL)
+      : ring_(capacity_bytes), scratch_(MAX_RECORD),
+        keyframe_interval_{keyframe_interval} {
+    if (capacity_bytes < MAX_RECORD) {
+      throw std::invalid_argument("Rewind buffer cannot hold one state.");
+    }
+    if (keyframe_interval == 0) {
+      throw std::invalid_argument("Keyframe interval must be positive.");
+    }
+  }
+
+  // Appends the state of the frame that just finished.
+  void push(const SaveState &state) {
+    const bool key = count_ == 0 || since_keyframe_ + 1 >= keyframe_interval_;
+    std::size_t size = encode(state, key ? nullptr : &newest_);
+    if (!reserve(size) && !key) {
+      // The whole history had to go, including the frame this delta was
+      // against; start over from a keyframe.
+      size = encode(state, nullptr);
+      reserve(size);
+    }
+    std::memcpy(ring_.data() + head_, scratch_.data(), size);
+    head_ += size;
+    ++count_;
+    since_keyframe_ = is_key(scratch_.data()) ? 0 : since_keyframe_ + 1;
+    newest_ = state;
+  }
+
+  // The most recently pushed state that has not been popped.
+  [[nodiscard]] const SaveState &newest() const {
+    if (count_ == 0) {
+      throw std::out_of_range("Rewind buffer is empty.");
+    }
+    return newest_;
+  }
+
+  // Drops the newest state; newest() becomes the one pushed before it.
+  void pop() {
+    if (count_ == 0) {
+      throw std::out_of_range("Rewind buffer is empty.");
+    }
+    const std::size_t start = record_before(head_);
+    const bool key = is_key(ring_.data() + start);
+    if (!key) {
+      apply(start, bytes_of(newest_));
+    }
+    head_ = start;
+    if (wrapped_ && head_ == 0) {
+      head_ = wrap_;
+      wrapped_ = false;
+    }
+    if (--count_ == 0) {
+      clear();
+    } else if (key) {
+      since_keyframe_ = decode(head_, 0, newest_);
+    } else {
+      --since_keyframe_;
+    }
+  }
+
+  // Reconstructs the state pushed `age` pushes ago; 0 is newest().
+  void read(std::size_t age, SaveState &out) const {
+    if (age >= count_) {
+      throw std::out_of_range("Rewind buffer does not reach that far back.");
+    }
+    decode(head_, age, out);
+  }
+
+  void clear() noexcept {
+    head_ = tail_ = wrap_ = 0;
+    wrapped_ = false;
+    count_ = 0;
+    since_keyframe_ = 0;
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return count_; }
+  [[nodiscard]] std::size_t capacity() const noexcept { return ring_.size(); }
+  [[nodiscard]] std::size_t bytes_used() const noexcept {
+    return wrapped_ ? wrap_ - tail_ + head_ : head_ - tail_;
+  }
+
+private:
+  // A record is [tag][payload][tag], tag = payload size << 1 | keyframe. The
+  // trailing copy lets the newest records be walked backwards. The payload
+  // is a list of (zero run, literal count, literals) tokens over the XOR of
+  // the state with its base; bytes past the last token are unchanged.
+  using Tag = uint32_t;
+  using Count = uint16_t;
+
+  static constexpr std::size_t STATE_SIZE = sizeof(SaveState);
+  static_assert(STATE_SIZE <= UINT16_MAX, "token counts are 16 bits");
+  // Zero runs shorter than a token header are cheaper kept as literals.
+  static constexpr std::size_t MIN_ZERO_RUN = 2 * sizeof(Count) + 1;
+  static constexpr std::size_t MAX_RECORD =
+      2 * sizeof(Tag) + STATE_SIZE +
+      2 * sizeof(Count) * (STATE_SIZE / MIN_ZERO_RUN + 2);
+
+  static const uint8_t *bytes_of(const SaveState &state) noexcept {
+    return reinterpret_cast<const uint8_t *>(&state);
+  }
+  static uint8_t *bytes_of(SaveState &state) noexcept {
+    return reinterpret_cast<uint8_t *>(&state);
+  }
+
+  static Tag load_tag(const uint8_t *at) noexcept {
+    Tag tag;
+    std::memcpy(&tag, at, sizeof(tag));
+    return tag;
+  }
+  static bool is_key(const uint8_t *record) noexcept {
+    return (load_tag(record) & 1u) != 0;
+  }
+
+  // Writes the record for `state` against `base` (all zeros if null) into
+  // scratch_ and returns its size.
+  std::size_t encode(const SaveState &state, const SaveState *base) noexcept {
+    const uint8_t *cur = bytes_of(state);
+    const uint8_t *prev = base != nullptr ? bytes_of(*base) : nullptr;
+    auto diff = [&](std::size_t i) {
+      return static_cast<uint8_t>(cur[i] ^ (prev != nullptr ? prev[i] : 0));
+    };
+    auto put_count = [&](uint8_t *at, std::size_t value) {
+      const auto count = static_cast<Count>(value);
+      std::memcpy(at, &count, sizeof(count));
+    };
+
+    uint8_t *out = scratch_.data() + sizeof(Tag);
+    std::size_t i = 0;
+    while (i < STATE_SIZE) {
+      const std::size_t zeros_start = i;
+      while (i < STATE_SIZE && diff(i) == 0) {
+        ++i;
+      }
+      if (i == STATE_SIZE) {
+        break;
+      }
+      const std::size_t literal_start = i;
+      while (i < STATE_SIZE) {
+        std::size_t run = 0;
+        while (i + run < STATE_SIZE && diff(i + run) == 0 &&
+               run < MIN_ZERO_RUN) {
+          ++run;
+        }
+        if (run == MIN_ZERO_RUN || i + run == STATE_SIZE) {
+          break;
+        }
+        i += run + 1;
+      }
+      put_count(out, literal_start - zeros_start);
+      put_count(out + sizeof(Count), i - literal_start);
+      out += 2 * sizeof(Count);
+      for (std::size_t j = literal_start; j < i; ++j) {
+        *out++ = diff(j);
+      }
+    }
+
+    const auto payload = static_cast<std::size_t>(
+        out - scratch_.data() - static_cast<std::ptrdiff_t>(sizeof(Tag)));
+    const Tag tag = static_cast<Tag>(payload << 1 | (base == nullptr));
+    std::memcpy(scratch_.data(), &tag, sizeof(tag));
+    std::memcpy(out, &tag, sizeof(tag));
+    return payload + 2 * sizeof(Tag);
+  }
+
+  // XORs the payload of the record at `start` into `state`.
+  void apply(std::size_t start, uint8_t *state) const noexcept {
+    const uint8_t *in = ring_.data() + start + sizeof(Tag);
+    const uint8_t *end = in + (load_tag(ring_.data() + start) >> 1);
+    std::size_t pos = 0;
+    while (in < end) {
+      Count zeros;
+      Count literals;
+      std::memcpy(&zeros, in, sizeof(Count));
+      std::memcpy(&literals, in + sizeof(Count), sizeof(Count));
+      in += 2 * sizeof(Count);
+      pos += zeros;
+      for (Count j = 0; j < literals; ++j) {
+        state[pos++] ^= *in++;
+      }
+    }
+  }
+
+  // Rebuilds the state `age` records before the one ending at `end` by
+  // replaying forward from its keyframe. Returns how many deltas followed
+  // that keyframe.
+  uint32_t decode(std::size_t end, std::size_t age, SaveState &out) const {
+    std::size_t target = record_before(end);
+    for (std::size_t i = 0; i < age; ++i) {
+      target = record_before(target);
+    }
+    std::size_t key = target;
+    uint32_t deltas = 0;
+    while (!is_key(ring_.data() + key)) {
+      key = record_before(key);
+      ++deltas;
+    }
+
+    std::memset(bytes_of(out), 0, STATE_SIZE);
+    for (std::size_t at = key;; at = record_after(at)) {
+      apply(at, bytes_of(out));
+      if (at == target) {
+        return deltas;
+      }
+    }
+  }
+
+  [[nodiscard]] std::size_t record_before(std::size_t end) const noexcept {
+    if (end == 0 && wrapped_) {
+      end = wrap_;
+    }
+    const Tag tag = load_tag(ring_.data() + end - sizeof(Tag));
+    return end - (tag >> 1) - 2 * sizeof(Tag);
+  }
+
+  [[nodiscard]] std::size_t record_after(std::size_t start) const noexcept {
+    const std::size_t next =
+        start + (load_tag(ring_.data() + start) >> 1) + 2 * sizeof(Tag);
+    return wrapped_ && next == wrap_ ? 0 : next;
+  }
+
+  // Makes room for `size` contiguous bytes at head_, evicting the oldest
+  // keyframe groups as needed. Returns false if everything was evicted.
+  bool reserve(std::size_t size) {
+    const bool had_history = count_ > 0;
+    while (count_ > 0) {
+      if (!wrapped_) {
+        if (head_ + size <= ring_.size()) {
+          return true;
+        }
+        wrap_ = head_;
+        head_ = 0;
+        wrapped_ = true;
+      }
+      if (head_ + size <= tail_) {
+        return true;
+      }
+      evict_oldest_group();
+    }
+    clear();
+    return !had_history;
+  }
+
+  void evict_oldest_group() noexcept {
+    do {
+      tail_ = record_after(tail_);
+      if (wrapped_ && tail_ == 0) {
+        wrapped_ = false;
+      }
+      --count_;
+    } while (count_ > 0 && !is_key(ring_.data() + tail_));
+  }
+
+  std::vector<uint8_t> ring_;
+  std::vector<uint8_t> scratch_;
+  SaveState newest_{};
+  uint32_t keyframe_interval_;
+
+  std::size_t head_{};    // where the next record goes
+  std::size_t tail_{};    // oldest record
+  std::size_t wrap_{};    // end of the records above head_ while wrapped_
+  bool wrapped_{false};
+  std::size_t count_{};
+  uint32_t since_keyframe_{};
+};
+
+} // namespace chip8
@@ -0,0 +1,51 @@
+#pragma once
+#include "chip8_pcg_rand.h"
+#include "constants.h"
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+namespace chip8 {
+
+// Everything a running ROM can observe, in one fixed-layout block: saving
+// and restoring are straight copies, and the struct itself is the binary
+// format (see Emulator::save_state()). The layout follows the host's byte
+// order and standard library, so snapshots are meant to be restored by the
+// same build, not exchanged between platforms.
+struct SaveState {
+  using RngEngine = PcgRandom::Engine;
+
+  static constexpr uint32_t MAGIC = 0x53385043; // "C8PS" read little-endian
+  static constexpr uint32_t VERSION = 1;
+  static constexpr uint8_t NO_KEY = 0xFF;
+
+  uint32_t magic{MAGIC};
+  uint32_t version{VERSION};
+
+  uint16_t pc{};
+  uint16_t index{};
+  uint16_t keys{}; // bit k set while key k is held
+  uint8_t sp{};
+  uint8_t delay{};
+
+  uint8_t sound{};
+  uint8_t last_pressed{NO_KEY};
+  uint8_t run_state{}; // EmulatorState
+  std::array<uint8_t, 5> reserved{};
+
+  std::array<uint8_t, NUM_CPU_REGISTERS> v{};
+  std::array<uint16_t, NUM_CPU_STACK> stack{};
+  std::array<uint64_t, SCREEN_HEIGHT> display{};
+  std::array<uint8_t, MEMORY_SIZE> memory{};
+
+  // Raw bytes of the engine, padded so the struct has no hidden padding.
+  std::array<uint8_t, (sizeof(RngEngine) + 7) / 8 * 8> rng{};
+};
+
+static_assert(std::is_trivially_copyable_v<SaveState::RngEngine>,
+              "the RNG engine is snapshotted with memcpy");
+static_assert(std::is_trivially_copyable_v<SaveState>);
+static_assert(std::has_unique_object_representations_v<SaveState>,
+              "no padding, so equal states have equal bytes");
+
+} // namespace chip8
@@ -8,6 +8,22 @@ enum class EmulatorState { Stopped, Running, Paused };
 struct RunFrameResult {
   bool frame_complete{false};
   bool sound_active{false};
+  // The CPU stopped at Fx0A with no key to take and skipped the rest of the
+  // frame; it stays parked until a key goes down.
+  bool waiting_for_key{false};
+};
+
+// Hears the buzzer from Emulator::run_frame(), timed to the instruction;
+// see Emulator::set_beep_sink().
+class BeepSink {
+public:
+  virtual ~BeepSink() = default;
+
+  // The buzzer turned on or off `offset` of the way through the current
+  // frame, 0 <= offset < 1.
+  virtual void beep(float offset, bool on) = 0;
+  // The current frame is over; the next one starts.
+  virtual void end_frame() = 0;
 };
 
 } // namespace chip8
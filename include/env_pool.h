@@ -0,0 +1,257 @@
+#pragma once
+#include "mpmc_queue.h"
+#include "vector_env.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace chip8 {
+
+// Asynchronous front end to a VectorEnv. send() hands actions for any
+// subset of idle instances to the worker threads and returns at once;
+// recv() collects whichever instances finish first, so the workers keep
+// stepping while the learner is busy with the previous batch. Sending
+// every instance and receiving all of them is plain synchronous stepping.
+//
+// Frames take a few microseconds, so the hand-off is kept off the kernel:
+// actions and results travel through lock-free MpmcQueues, workers spin
+// briefly before sleeping, send() wakes sleepers once per call rather than
+// once per action, and recv() is only woken once enough results for the
+// whole batch are in.
+//
+// send() and recv() are meant to be called from one learner thread. The
+// reward and done hooks run on the workers, concurrently for distinct
+// instances.
+class EnvPool {
+public:
+  EnvPool(std::span<const uint8_t> rom, std::size_t count,
+          std::size_t threads = WorkStealingPool::default_thread_count(),
+          ObservationFormat format = ObservationFormat::Bytes,
+          uint32_t cycles_per_frame = 10,
+          uint64_t seed = Emulator::DEFAULT_SEED)
+      : env_{rom, count, format, cycles_per_frame, seed}, actions_{count},
+        results_{count}, observations_(count * env_.observation_size()),
+        errors_(count), in_flight_(count) {
+    const std::size_t worker_count = std::max<std::size_t>(threads, 1);
+    workers_.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i) {
+      workers_.emplace_back([this] { worker_loop(); });
+    }
+  }
+
+  EnvPool(const EnvPool &) = delete;
+  EnvPool &operator=(const EnvPool &) = delete;
+
+  ~EnvPool() {
+    stopping_.store(true);
+    work_epoch_.fetch_add(1);
+    work_epoch_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  // Only while nothing is in flight.
+  void set_reward_hook(VectorEnv::RewardHook hook) {
+    env_.set_reward_hook(std::move(hook));
+  }
+  void set_done_hook(VectorEnv::DoneHook hook) {
+    env_.set_done_hook(std::move(hook));
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return env_.size(); }
+  [[nodiscard]] std::size_t thread_count() const noexcept {
+    return workers_.size();
+  }
+  [[nodiscard]] std::size_t observation_size() const noexcept {
+    return env_.observation_size();
+  }
+  // Instances sent but not yet received.
+  [[nodiscard]] std::size_t in_flight() const noexcept { return pending_; }
+
+  // Reloads every instance and writes the first observations, like
+  // VectorEnv::reset(). Only while nothing is in flight.
+  void reset(std::span<uint8_t> observations) {
+    if (pending_ != 0) {
+      throw std::logic_error("Cannot reset while instances are stepping.");
+    }
+    env_.reset(observations);
+  }
+
+  // Queues one frame with key mask actions[i] for instance indices[i].
+  // Throws std::logic_error if an instance is still in flight.
+  void send(std::span<const std::size_t> indices,
+            std::span<const uint16_t> actions) {
+    if (indices.size() != actions.size()) {
+      throw std::invalid_argument("Need one action per instance.");
+    }
+    for (const std::size_t index : indices) {
+      if (index >= size()) {
+        throw std::out_of_range("No such instance.");
+      }
+      if (in_flight_[index]) {
+        throw std::logic_error("Instance is already stepping.");
+      }
+    }
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+      in_flight_[indices[i]] = true;
+      // Never full: each instance holds at most one slot.
+      actions_.try_push({indices[i], actions[i]});
+    }
+    pending_ += indices.size();
+
+    work_epoch_.fetch_add(1);
+    if (sleeping_.load() > 0) {
+      work_epoch_.notify_all();
+    }
+  }
+
+  // Blocks until ids.size() instances have finished their frame and writes
+  // them in completion order: ids[j] is the instance, the j-th slices of
+  // the other buffers its observation, reward and done flag. Rethrows the
+  // first exception an instance raised.
+  void recv(std::span<std::size_t> ids, std::span<uint8_t> observations,
+            std::span<float> rewards, std::span<uint8_t> dones) {
+    const std::size_t batch = ids.size();
+    if (rewards.size() != batch || dones.size() != batch ||
+        observations.size() != batch * observation_size()) {
+      throw std::invalid_argument("Receive buffers must match the batch.");
+    }
+    if (batch > pending_) {
+      throw std::logic_error("Waiting for more instances than were sent.");
+    }
+
+    std::exception_ptr error;
+    for (std::size_t got = 0; got < batch;) {
+      Result result;
+      if (!results_.try_pop(result)) {
+        wait_for_results(batch - got);
+        continue;
+      }
+      ++received_;
+      --pending_;
+      in_flight_[result.index] = false;
+      if (errors_[result.index] && !error) {
+        error = std::exchange(errors_[result.index], nullptr);
+      }
+      ids[got] = result.index;
+      rewards[got] = result.reward;
+      dones[got] = result.done;
+      std::memcpy(observations.data() + got * observation_size(),
+                  observations_.data() + result.index * observation_size(),
+                  observation_size());
+      ++got;
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+private:
+  struct Action {
+    std::size_t index;
+    uint16_t keys;
+  };
+
+  struct Result {
+    std::size_t index;
+    float reward;
+    bool done;
+  };
+
+  static constexpr int SPIN_LIMIT = 256;
+
+  void worker_loop() {
+    while (true) {
+      Action action{};
+      int spins = 0;
+      while (!actions_.try_pop(action)) {
+        if (++spins < SPIN_LIMIT) {
+          std::this_thread::yield();
+          continue;
+        }
+        // The epoch is read before the final look at the queue: a send()
+        // after that look bumps it, so wait() returns at once.
+        const uint32_t seen = work_epoch_.load();
+        sleeping_.fetch_add(1);
+        if (!actions_.try_pop(action) && !stopping_.load()) {
+          work_epoch_.wait(seen);
+          sleeping_.fetch_sub(1);
+          spins = 0;
+          continue;
+        }
+        sleeping_.fetch_sub(1);
+        break;
+      }
+      if (stopping_.load()) {
+        return;
+      }
+      run(action);
+    }
+  }
+
+  void run(const Action &action) {
+    Result result{action.index, 0.0f, false};
+    try {
+      const auto step = env_.step_at(
+          action.index, action.keys,
+          std::span<uint8_t>(observations_).subspan(
+              action.index * observation_size(), observation_size()));
+      result.reward = step.reward;
+      result.done = step.done;
+    } catch (...) {
+      errors_[action.index] = std::current_exception();
+    }
+    results_.try_push(result);
+
+    // Only wake the learner once its whole batch is in.
+    const uint64_t published = published_.fetch_add(1) + 1;
+    if (published >= wake_at_.load()) {
+      published_.notify_all();
+    }
+  }
+
+  void wait_for_results(std::size_t missing) {
+    const uint64_t target = received_ + missing;
+    for (int spins = 0; spins < SPIN_LIMIT; ++spins) {
+      if (published_.load() >= target) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    wake_at_.store(target);
+    const uint64_t seen = published_.load();
+    if (seen < target) {
+      published_.wait(seen);
+    }
+    wake_at_.store(UINT64_MAX);
+  }
+
+  VectorEnv env_;
+  MpmcQueue<Action> actions_;
+  MpmcQueue<Result> results_;
+  std::vector<uint8_t> observations_; // one slot per instance
+  std::vector<std::exception_ptr> errors_;
+  std::vector<bool> in_flight_;       // learner thread only
+  std::size_t pending_{};
+  uint64_t received_{};
+
+  std::atomic<uint32_t> work_epoch_{0};
+  std::atomic<uint32_t> sleeping_{0};
+  std::atomic<uint64_t> published_{0};
+  std::atomic<uint64_t> wake_at_{UINT64_MAX};
+  std::atomic<bool> stopping_{false};
+  std::vector<std::thread> workers_;
+};
+
+} // namespace chip8
@@ -0,0 +1,105 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace chip8 {
+
+// Fast-forward for interactive frontends: while active, each displayed frame
+// runs `multiplier` emulated frames, or as many as fit before a deadline when
+// the multiplier is UNLIMITED. Only the last of them needs rendering.
+class FastForward {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr uint32_t UNLIMITED = 0;
+  // Keeps one displayed frame from running away if the deadline is far off.
+  static constexpr uint32_t MAX_FRAMES_PER_STEP = 10000;
+
+  explicit FastForward(uint32_t multiplier = UNLIMITED,
+                       bool active = false) noexcept
+      : multiplier_{multiplier}, active_{active} {}
+
+  void set_active(bool active) noexcept { active_ = active; }
+  void toggle() noexcept { active_ = !active_; }
+  [[nodiscard]] constexpr bool active() const noexcept { return active_; }
+  [[nodiscard]] constexpr uint32_t multiplier() const noexcept {
+    return multiplier_;
+  }
+
+  // Calls `run_frame` once, or, while active, multiplier() times or until
+  // `now()` passes `deadline`. Returns how many times it was called.
+  template <typename RunFrame, typename Now = decltype(&Clock::now)>
+  uint32_t step(RunFrame &&run_frame, Clock::time_point deadline,
+                Now now = &Clock::now) {
+    if (!active_) {
+      run_frame();
+      return 1;
+    }
+    if (multiplier_ != UNLIMITED) {
+      for (uint32_t i = 0; i < multiplier_; ++i) {
+        run_frame();
+      }
+      return multiplier_;
+    }
+    uint32_t frames = 0;
+    do {
+      run_frame();
+      ++frames;
+    } while (frames < MAX_FRAMES_PER_STEP && now() < deadline);
+    return frames;
+  }
+
+private:
+  uint32_t multiplier_;
+  bool active_;
+};
+
+// Emulated speed relative to real time, averaged over windows of `window`.
+class SpeedMeter {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit SpeedMeter(double frames_per_second = 60.0,
+                      Clock::duration window = std::chrono::milliseconds(500))
+      : frames_per_second_{frames_per_second}, window_{window} {}
+
+  // Returns true when a window closed and speed() changed.
+  bool count(uint32_t frames, Clock::time_point now) noexcept {
+    if (!started_) {
+      started_ = true;
+      window_start_ = now;
+    }
+    frames_ += frames;
+    const auto elapsed = now - window_start_;
+    if (elapsed < window_) {
+      return false;
+    }
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    speed_ = static_cast<double>(frames_) / seconds / frames_per_second_;
+    frames_ = 0;
+    window_start_ = now;
+    return true;
+  }
+
+  // Restarts measuring, e.g. after the frontend changed speed.
+  void restart() noexcept {
+    started_ = false;
+    frames_ = 0;
+  }
+
+  // 1.0 is real time; empty until the first window closed.
+  [[nodiscard]] std::optional<double> speed() const noexcept {
+    return speed_;
+  }
+
+private:
+  double frames_per_second_;
+  Clock::duration window_;
+  Clock::time_point window_start_{};
+  uint64_t frames_{};
+  bool started_{false};
+  std::optional<double> speed_;
+};
+
+} // namespace chip8
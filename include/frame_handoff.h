@@ -0,0 +1,111 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace chip8 {
+
+// Hands the newest value from one producer thread to one consumer thread
+// without either ever waiting. Each side owns one of three slots; the third
+// sits in the middle. publish() swaps the producer's slot with the middle
+// one, update() swaps the consumer's slot with it if it holds something
+// new. A value published twice before the consumer looks is simply
+// replaced, which is what a renderer wants from a faster producer.
+template <typename T> class TripleBuffer {
+public:
+  TripleBuffer() = default;
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+  // Producer: the slot to fill in; it is not seen until publish().
+  [[nodiscard]] T &back() noexcept { return slots_[back_].value; }
+
+  // Producer: makes back() the newest value and hands out a free slot.
+  void publish() noexcept {
+    back_ = middle_.exchange(static_cast<uint8_t>(back_ | FRESH),
+                             std::memory_order_acq_rel) &
+            INDEX;
+  }
+
+  // Consumer: moves the newest published value to front(). Returns false,
+  // leaving front() alone, if nothing was published since the last call.
+  bool update() noexcept {
+    if ((middle_.load(std::memory_order_relaxed) & FRESH) == 0) {
+      return false;
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+
+  // Consumer: the value taken by the last successful update().
+  [[nodiscard]] const T &front() const noexcept {
+    return slots_[front_].value;
+  }
+
+private:
+  static constexpr std::size_t CACHE_LINE = 64;
+  static constexpr uint8_t INDEX = 0x3;
+  static constexpr uint8_t FRESH = 0x4; // middle slot not yet consumed
+
+  // Slots on separate lines, so filling one does not disturb the reader.
+  struct alignas(CACHE_LINE) Slot {
+    T value{};
+  };
+
+  std::array<Slot, 3> slots_{};
+  alignas(CACHE_LINE) uint8_t back_{0}; // producer only
+  alignas(CACHE_LINE) std::atomic<uint8_t> middle_{1};
+  alignas(CACHE_LINE) uint8_t front_{2}; // consumer only
+};
+
+// Distribution of emulation-to-present latencies: fixed buckets, so
+// recording a sample is an increment and never allocates.
+class LatencyHistogram {
+public:
+  using Duration = std::chrono::nanoseconds;
+
+  static constexpr Duration BUCKET_WIDTH = std::chrono::microseconds(250);
+  static constexpr std::size_t BUCKETS = 400; // up to 100 ms
+
+  void record(Duration latency) noexcept {
+    latency = std::max(latency, Duration{});
+    const auto bucket = static_cast<std::size_t>(latency / BUCKET_WIDTH);
+    ++buckets_[std::min(bucket, BUCKETS)];
+    ++count_;
+    total_ += latency;
+    max_ = std::max(max_, latency);
+  }
+
+  [[nodiscard]] uint64_t count() const noexcept { return count_; }
+  [[nodiscard]] Duration max() const noexcept { return max_; }
+  [[nodiscard]] Duration mean() const noexcept {
+    return count_ == 0 ? Duration{} : total_ / static_cast<int64_t>(count_);
+  }
+
+  // Upper edge of the bucket holding the given fraction of samples, e.g.
+  // 0.99 for the 99th percentile; max() beyond the last bucket.
+  [[nodiscard]] Duration percentile(double fraction) const noexcept {
+    const auto rank = static_cast<uint64_t>(
+        std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count_));
+    uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < BUCKETS; ++bucket) {
+      seen += buckets_[bucket];
+      if (seen > rank || (seen == count_ && seen != 0)) {
+        return std::min(BUCKET_WIDTH * static_cast<int64_t>(bucket + 1),
+                        max_);
+      }
+    }
+    return max_;
+  }
+
+private:
+  std::array<uint64_t, BUCKETS + 1> buckets_{}; // the last one overflows
+  uint64_t count_{};
+  Duration total_{};
+  Duration max_{};
+};
+
+} // namespace chip8
@@ -0,0 +1,141 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+
+namespace chip8 {
+
+// Time source of a FramePacer; tests substitute one that only pretends to
+// sleep.
+class PacerClock {
+public:
+  using Duration = std::chrono::nanoseconds;
+  using TimePoint = std::chrono::time_point<std::chrono::steady_clock,
+                                            Duration>;
+
+  virtual ~PacerClock() = default;
+  virtual TimePoint now() = 0;
+  virtual void sleep_for(Duration duration) = 0;
+};
+
+class SteadyPacerClock final : public PacerClock {
+public:
+  TimePoint now() override {
+    return std::chrono::time_point_cast<Duration>(
+        std::chrono::steady_clock::now());
+  }
+  void sleep_for(Duration duration) override {
+    std::this_thread::sleep_for(duration);
+  }
+};
+
+// What to do about deadlines that passed while a frame was late: run the
+// missed frames to stay in step with real time, or drop them.
+enum class LatePolicy { CatchUp, Skip };
+
+struct PacerConfig {
+  double frames_per_second{60.0};
+  LatePolicy late_policy{LatePolicy::CatchUp};
+  // The OS wakes threads up to a scheduler quantum late, so the last
+  // stretch before a deadline is spun rather than slept.
+  PacerClock::Duration spin_threshold{std::chrono::microseconds(1500)};
+  // Frames run in one go to catch up; any further backlog is dropped.
+  uint32_t max_catch_up{4};
+};
+
+// How far wake-ups landed from their deadlines.
+struct PacerStats {
+  uint64_t frames{};
+  uint64_t late_frames{};    // woke more than a spin threshold late
+  uint64_t skipped_frames{}; // deadlines dropped instead of run
+  PacerClock::Duration max_lateness{};
+  PacerClock::Duration total_lateness{};
+
+  [[nodiscard]] PacerClock::Duration mean_lateness() const noexcept {
+    return frames == 0 ? PacerClock::Duration{}
+                       : total_lateness / static_cast<int64_t>(frames);
+  }
+};
+
+// Paces a frame loop to an absolute schedule: frame k is due at
+// start + k / frames_per_second, computed from k rather than by adding up
+// periods, so neither rounding nor late wake-ups accumulate into drift.
+class FramePacer {
+public:
+  explicit FramePacer(PacerClock &clock, PacerConfig config = {})
+      : clock_{clock}, config_{config} {
+    restart();
+  }
+
+  // Makes the next deadline one period from now, e.g. after a pause.
+  void restart() {
+    start_ = clock_.now();
+    next_frame_ = 1;
+  }
+
+  [[nodiscard]] PacerClock::TimePoint next_deadline() const noexcept {
+    return deadline(next_frame_);
+  }
+  [[nodiscard]] PacerClock::Duration period() const noexcept {
+    return deadline(1) - deadline(0);
+  }
+  [[nodiscard]] const PacerConfig &config() const noexcept { return config_; }
+  [[nodiscard]] const PacerStats &stats() const noexcept { return stats_; }
+
+  // Waits for the next deadline and returns how many frames are due now: 1
+  // on time, more when catching up.
+  uint32_t wait() {
+    const auto target = next_deadline();
+    const auto early = target - clock_.now();
+    if (early > config_.spin_threshold) {
+      clock_.sleep_for(early - config_.spin_threshold);
+    }
+    while (clock_.now() < target) {
+    }
+
+    const auto now = clock_.now();
+    const auto lateness = std::max(now - target, PacerClock::Duration{});
+    ++stats_.frames;
+    stats_.total_lateness += lateness;
+    stats_.max_lateness = std::max(stats_.max_lateness, lateness);
+    if (lateness > config_.spin_threshold) {
+      ++stats_.late_frames;
+    }
+
+    // Every deadline up to now is due.
+    const auto passed = static_cast<uint64_t>(
+        std::chrono::duration<double>(now - start_).count() *
+        config_.frames_per_second);
+    uint64_t due = passed > next_frame_ ? passed - next_frame_ + 1 : 1;
+    while (due > 1 && deadline(next_frame_ + due - 1) > now) {
+      --due; // rounding
+    }
+    while (deadline(next_frame_ + due) <= now) {
+      ++due;
+    }
+    const uint64_t run =
+        config_.late_policy == LatePolicy::CatchUp
+            ? std::min<uint64_t>(due, std::max(config_.max_catch_up, 1u))
+            : 1;
+    stats_.skipped_frames += due - run;
+    next_frame_ += due;
+    return static_cast<uint32_t>(run);
+  }
+
+private:
+  [[nodiscard]] PacerClock::TimePoint deadline(uint64_t frame) const noexcept {
+    return start_ +
+           PacerClock::Duration{static_cast<int64_t>(std::llround(
+               static_cast<double>(frame) * 1e9 / config_.frames_per_second))};
+  }
+
+  PacerClock &clock_;
+  PacerConfig config_;
+  PacerStats stats_;
+  PacerClock::TimePoint start_{};
+  uint64_t next_frame_{1};
+};
+
+} // namespace chip8
@@ -0,0 +1,80 @@
+#pragma once
+#include "constants.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHIP8_EXPAND_SSE2 1
+#endif
+
+namespace chip8 {
+
+// Turns packed framebuffer rows (see Display::rows()) into 32-bit texels:
+// `foreground` where a bit is set, `background` elsewhere. The colours are
+// opaque values in whatever pixel format the destination uses.
+
+inline void expand_row_scalar(uint64_t bits, uint32_t *dst,
+                              uint32_t foreground,
+                              uint32_t background) noexcept {
+  const uint32_t diff = foreground ^ background;
+  for (int x = 0; x < SCREEN_WIDTH; ++x) {
+    const auto on = static_cast<uint32_t>(bits >> (SCREEN_WIDTH - 1 - x)) & 1u;
+    dst[x] = background ^ (diff & (0u - on));
+  }
+}
+
+inline void expand_row(uint64_t bits, uint32_t *dst, uint32_t foreground,
+                       uint32_t background) noexcept {
+#if defined(__AVX2__)
+  // 8 pixels per store: broadcast one sprite byte, test one bit per lane.
+  const __m256i lane_bits = _mm256_setr_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+  const __m256i fg = _mm256_set1_epi32(static_cast<int>(foreground));
+  const __m256i bg = _mm256_set1_epi32(static_cast<int>(background));
+  for (int byte = 0; byte < 8; ++byte) {
+    const auto value = static_cast<int>((bits >> (56 - 8 * byte)) & 0xFF);
+    const __m256i set = _mm256_cmpeq_epi32(
+        _mm256_and_si256(_mm256_set1_epi32(value), lane_bits), lane_bits);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 8 * byte),
+                        _mm256_blendv_epi8(bg, fg, set));
+  }
+#elif defined(CHIP8_EXPAND_SSE2)
+  const __m128i high_bits = _mm_setr_epi32(128, 64, 32, 16);
+  const __m128i low_bits = _mm_setr_epi32(8, 4, 2, 1);
+  const __m128i fg = _mm_set1_epi32(static_cast<int>(foreground));
+  const __m128i bg = _mm_set1_epi32(static_cast<int>(background));
+  auto select = [&](__m128i value, __m128i lane_bits) {
+    const __m128i set =
+        _mm_cmpeq_epi32(_mm_and_si128(value, lane_bits), lane_bits);
+    return _mm_or_si128(_mm_and_si128(set, fg), _mm_andnot_si128(set, bg));
+  };
+  for (int byte = 0; byte < 8; ++byte) {
+    const auto value = static_cast<int>((bits >> (56 - 8 * byte)) & 0xFF);
+    const __m128i broadcast = _mm_set1_epi32(value);
+    auto *out = reinterpret_cast<__m128i *>(dst + 8 * byte);
+    _mm_storeu_si128(out, select(broadcast, high_bits));
+    _mm_storeu_si128(out + 1, select(broadcast, low_bits));
+  }
+#else
+  expand_row_scalar(bits, dst, foreground, background);
+#endif
+}
+
+// Expands every row into `dst`, whose rows are `pitch` bytes apart (as
+// returned by SDL_LockTexture).
+inline void expand_rows(std::span<const uint64_t> rows,
+                        void *dst, std::size_t pitch, uint32_t foreground,
+                        uint32_t background) noexcept {
+  auto *line = static_cast<unsigned char *>(dst);
+  for (const uint64_t bits : rows) {
+    expand_row(bits, reinterpret_cast<uint32_t *>(line), foreground,
+               background);
+    line += pitch;
+  }
+}
+
+} // namespace chip8
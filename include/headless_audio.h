@@ -0,0 +1,131 @@
+#pragma once
+#include "beep_synth.h"
+#include "emulator_types.h"
+#include "spsc_queue.h"
+#include "wav_writer.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <ostream>
+#include <span>
+#include <thread>
+
+namespace chip8 {
+
+// Records the buzzer of an emulator without a sound device: attached with
+// Emulator::set_beep_sink(), it queues each change stamped with its frame
+// and position in it, and a background thread synthesizes them into a WAV
+// stream. Samples depend on nothing but the emulated timeline, so the same
+// run always produces the same bytes, however fast it ran.
+class HeadlessAudio final : public BeepSink {
+public:
+  static constexpr std::size_t EVENT_CAPACITY = 4096;
+
+  explicit HeadlessAudio(std::ostream &out, SynthConfig config = {})
+      : out_{out}, config_{config},
+        samples_per_frame_{config.sample_rate / config.frames_per_second},
+        synthesizer_{[this] { synthesize(); }} {}
+
+  HeadlessAudio(const HeadlessAudio &) = delete;
+  HeadlessAudio &operator=(const HeadlessAudio &) = delete;
+
+  ~HeadlessAudio() override {
+    try {
+      finish();
+    } catch (...) {
+      // Nobody asked for the recording, so nobody needs to hear it failed.
+    }
+  }
+
+  void beep(float offset, bool on) override {
+    // Only waits if synthesis fell a whole ring behind.
+    while (!events_.try_push(BeepEvent{frame_, offset, on}) &&
+           !failed_.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+
+  void end_frame() override { ++frame_; }
+
+  // For callers that fast-forward the emulator without run_frame() while
+  // the buzzer cannot change, e.g. with the ROM parked on Fx0A.
+  void skip_frames(uint64_t frames) noexcept { frame_ += frames; }
+
+  [[nodiscard]] uint64_t frames() const noexcept { return frame_; }
+
+  // Renders up to the end of the last frame, completes the WAV and stops
+  // the background thread. Rethrows what went wrong while writing.
+  void finish() {
+    if (!synthesizer_.joinable()) {
+      return;
+    }
+    end_frame_.store(frame_, std::memory_order_relaxed);
+    finishing_.store(true, std::memory_order_release);
+    synthesizer_.join();
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+private:
+  void synthesize() noexcept {
+    try {
+      BeepSynth synth{config_};
+      WavWriter wav{out_, static_cast<uint32_t>(config_.sample_rate)};
+      std::array<float, 1024> block;
+      const auto render_until = [&](uint64_t sample) {
+        while (wav.samples_written() < sample) {
+          const auto count = static_cast<std::size_t>(std::min<uint64_t>(
+              block.size(), sample - wav.samples_written()));
+          synth.generate(std::span{block}.first(count));
+          wav.write(std::span{block}.first(count));
+        }
+      };
+
+      BeepEvent event;
+      while (true) {
+        if (events_.try_pop(event)) {
+          render_until(sample_at(static_cast<double>(event.frame) +
+                                 event.offset));
+          synth.set_on(event.on);
+          continue;
+        }
+        // Everything pushed before finish() is visible once it is seen.
+        if (finishing_.load(std::memory_order_acquire)) {
+          if (events_.front()) {
+            continue;
+          }
+          render_until(sample_at(static_cast<double>(
+              end_frame_.load(std::memory_order_relaxed))));
+          wav.finish();
+          return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    } catch (...) {
+      error_ = std::current_exception();
+      failed_.store(true, std::memory_order_release);
+    }
+  }
+
+  [[nodiscard]] uint64_t sample_at(double frame) const noexcept {
+    return static_cast<uint64_t>(std::llround(frame * samples_per_frame_));
+  }
+
+  std::ostream &out_;
+  SynthConfig config_;
+  double samples_per_frame_;
+  SpscQueue<BeepEvent> events_{EVENT_CAPACITY};
+  uint64_t frame_{}; // emulator thread only
+  std::atomic<uint64_t> end_frame_{0};
+  std::atomic<bool> finishing_{false};
+  std::atomic<bool> failed_{false};
+  std::exception_ptr error_;
+  std::thread synthesizer_; // last, so it starts after everything above
+};
+
+} // namespace chip8
@@ -0,0 +1,253 @@
+#pragma once
+#include "chip8_emulator.h"
+#include "constants.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace chip8 {
+
+// Everything the keypad contributed to one or more consecutive frames: the
+// held keys and the pending Fx0A key, as seen right before the frame ran.
+struct MovieInput {
+  uint16_t keys{};
+  uint8_t last_pressed{NO_LAST_PRESSED};
+  uint32_t frames{1};
+
+  static constexpr uint8_t NO_LAST_PRESSED = 0xFF;
+};
+
+// A recorded session: replaying `inputs` on a fresh emulator with the same
+// ROM, seed and cycles per frame reproduces it bit for bit, ending in
+// `final_hash`.
+struct InputMovie {
+  static constexpr std::array<char, 4> MAGIC{'C', '8', 'M', 'V'};
+  static constexpr uint32_t VERSION = 1;
+
+  uint64_t seed{Emulator::DEFAULT_SEED};
+  uint32_t cycles_per_frame{10};
+  uint64_t rom_hash{};
+  uint32_t frames{};
+  uint64_t final_hash{};
+  std::vector<MovieInput> inputs; // run-length encoded
+};
+
+namespace movie_detail {
+
+inline constexpr uint64_t FNV_OFFSET = 0xCBF29CE484222325ull;
+inline constexpr uint64_t FNV_PRIME = 0x100000001B3ull;
+
+constexpr void fnv(uint64_t &hash, uint64_t value, int bytes) noexcept {
+  for (int i = 0; i < bytes; ++i) {
+    hash ^= (value >> (8 * i)) & 0xFF;
+    hash *= FNV_PRIME;
+  }
+}
+
+template <typename T> void put(std::ostream &out, T value) {
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    out.put(static_cast<char>(static_cast<uint64_t>(value) >> (8 * i)));
+  }
+}
+
+template <typename T> T get(std::istream &in) {
+  uint64_t value = 0;
+  for (std::size_t i = 0; i < sizeof(T); ++i) {
+    const int byte = in.get();
+    if (byte == std::char_traits<char>::eof()) {
+      throw std::runtime_error("Movie file is truncated.");
+    }
+    value |= static_cast<uint64_t>(byte) << (8 * i);
+  }
+  return static_cast<T>(value);
+}
+
+} // namespace movie_detail
+
+// FNV-1a over the ROM image, so a movie is not replayed against another.
+[[nodiscard]] inline uint64_t hash_rom(std::span<const uint8_t> rom) noexcept {
+  uint64_t hash = movie_detail::FNV_OFFSET;
+  for (const uint8_t byte : rom) {
+    movie_detail::fnv(hash, byte, 1);
+  }
+  return hash;
+}
+
+// FNV-1a over framebuffer, memory, registers, stack and timers. Unlike the
+// raw SaveState bytes it does not depend on the host, so a movie recorded
+// on one platform verifies on another.
+[[nodiscard]] inline uint64_t hash_state(const Emulator &emulator) noexcept {
+  using movie_detail::fnv;
+  const SaveState state = emulator.save_state();
+  uint64_t hash = movie_detail::FNV_OFFSET;
+  for (const uint64_t row : state.display) {
+    fnv(hash, row, 8);
+  }
+  for (const uint8_t byte : state.memory) {
+    fnv(hash, byte, 1);
+  }
+  for (const uint8_t v : state.v) {
+    fnv(hash, v, 1);
+  }
+  for (const uint16_t entry : state.stack) {
+    fnv(hash, entry, 2);
+  }
+  fnv(hash, state.pc, 2);
+  fnv(hash, state.index, 2);
+  fnv(hash, state.sp, 1);
+  fnv(hash, state.delay, 1);
+  fnv(hash, state.sound, 1);
+  return hash;
+}
+
+// Captures the keypad once per frame, right before Emulator::run_frame().
+class MovieRecorder {
+public:
+  // Starts a movie of `emulator`, which must have `rom` freshly loaded.
+  MovieRecorder(const Emulator &emulator, std::span<const uint8_t> rom) {
+    movie_.seed = emulator.seed();
+    movie_.cycles_per_frame = emulator.cycles_per_frame();
+    movie_.rom_hash = hash_rom(rom);
+  }
+
+  void record(const Keyboard &keyboard) {
+    const MovieInput input{
+        keyboard.key_mask(),
+        keyboard.last_pressed().value_or(MovieInput::NO_LAST_PRESSED)};
+    auto &inputs = movie_.inputs;
+    if (!inputs.empty() && inputs.back().keys == input.keys &&
+        inputs.back().last_pressed == input.last_pressed) {
+      ++inputs.back().frames;
+    } else {
+      inputs.push_back(input);
+    }
+    ++movie_.frames;
+  }
+
+  // Forgets the newest `frames` frames, e.g. after Emulator::rewind().
+  void drop_last(uint32_t frames) noexcept {
+    auto &inputs = movie_.inputs;
+    while (frames > 0 && !inputs.empty()) {
+      const uint32_t dropped = std::min(frames, inputs.back().frames);
+      inputs.back().frames -= dropped;
+      movie_.frames -= dropped;
+      frames -= dropped;
+      if (inputs.back().frames == 0) {
+        inputs.pop_back();
+      }
+    }
+  }
+
+  // Seals the movie with the hash of the state the session ended in.
+  [[nodiscard]] InputMovie finish(const Emulator &emulator) const {
+    InputMovie movie = movie_;
+    movie.final_hash = hash_state(emulator);
+    return movie;
+  }
+
+private:
+  InputMovie movie_;
+};
+
+struct MoviePlayback {
+  uint32_t frames{};
+  uint64_t state_hash{};
+  bool verified{false}; // state_hash matches the recorded final hash
+};
+
+// Replays `movie` from a fresh load of `rom`. Throws std::invalid_argument
+// if the movie was recorded with a different ROM.
+inline MoviePlayback play_movie(Emulator &emulator, const InputMovie &movie,
+                                std::span<const uint8_t> rom) {
+  if (hash_rom(rom) != movie.rom_hash) {
+    throw std::invalid_argument("Movie was recorded with a different ROM.");
+  }
+  emulator.set_seed(movie.seed);
+  emulator.set_cycles_per_frame(movie.cycles_per_frame);
+  emulator.load_rom(rom);
+
+  MoviePlayback playback;
+  for (const MovieInput &input : movie.inputs) {
+    std::optional<uint8_t> last_pressed;
+    if (input.last_pressed != MovieInput::NO_LAST_PRESSED) {
+      last_pressed = input.last_pressed;
+    }
+    for (uint32_t i = 0; i < input.frames; ++i) {
+      emulator.keyboard().restore(input.keys, last_pressed);
+      emulator.run_frame();
+    }
+    playback.frames += input.frames;
+  }
+  playback.state_hash = hash_state(emulator);
+  playback.verified = playback.frames == movie.frames &&
+                      playback.state_hash == movie.final_hash;
+  return playback;
+}
+
+// Little-endian, independent of the host.
+inline void write_movie(std::ostream &out, const InputMovie &movie) {
+  using movie_detail::put;
+  out.write(InputMovie::MAGIC.data(), InputMovie::MAGIC.size());
+  put(out, InputMovie::VERSION);
+  put(out, movie.seed);
+  put(out, movie.cycles_per_frame);
+  put(out, movie.rom_hash);
+  put(out, movie.frames);
+  put(out, movie.final_hash);
+  put(out, static_cast<uint32_t>(movie.inputs.size()));
+  for (const MovieInput &input : movie.inputs) {
+    put(out, input.keys);
+    put(out, input.last_pressed);
+    put(out, input.frames);
+  }
+  if (!out) {
+    throw std::runtime_error("Failed to write movie.");
+  }
+}
+
+inline InputMovie read_movie(std::istream &in) {
+  using movie_detail::get;
+  std::array<char, 4> magic{};
+  if (!in.read(magic.data(), magic.size()) || magic != InputMovie::MAGIC) {
+    throw std::runtime_error("Not a CHIP-8 input movie.");
+  }
+  if (get<uint32_t>(in) != InputMovie::VERSION) {
+    throw std::runtime_error("Unsupported movie version.");
+  }
+
+  InputMovie movie;
+  movie.seed = get<uint64_t>(in);
+  movie.cycles_per_frame = get<uint32_t>(in);
+  movie.rom_hash = get<uint64_t>(in);
+  movie.frames = get<uint32_t>(in);
+  movie.final_hash = get<uint64_t>(in);
+  const auto count = get<uint32_t>(in);
+  uint64_t frames = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    MovieInput input;
+    input.keys = get<uint16_t>(in);
+    input.last_pressed = get<uint8_t>(in);
+    input.frames = get<uint32_t>(in);
+    const bool valid_key = input.last_pressed < NUM_KEYS ||
+                           input.last_pressed == MovieInput::NO_LAST_PRESSED;
+    if (input.frames == 0 || !valid_key) {
+      throw std::runtime_error("Corrupt movie input.");
+    }
+    frames += input.frames;
+    movie.inputs.push_back(input);
+  }
+  if (frames != movie.frames) {
+    throw std::runtime_error("Movie frame count does not match its inputs.");
+  }
+  return movie;
+}
+
+} // namespace chip8
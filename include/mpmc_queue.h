@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace chip8 {
+
+// Bounded lock-free queue for any number of producers and consumers
+// (Dmitry Vyukov's design). Each cell carries a sequence number that tells
+// a producer whether the cell is free for its ticket and a consumer whether
+// it has been filled, so a push or pop is one CAS on the shared position
+// plus plain stores to the cell. Neither call blocks or allocates.
+template <typename T> class MpmcQueue {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "cells are reused without destruction");
+
+public:
+  // Rounded up to a power of two.
+  explicit MpmcQueue(std::size_t capacity)
+      : cells_{std::make_unique<Cell[]>(
+            std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity))},
+        mask_{std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1} {
+    for (std::size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpmcQueue(const MpmcQueue &) = delete;
+  MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask_ + 1; }
+
+  // Returns false if the queue is full.
+  bool try_push(const T &value) noexcept {
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell &cell = cells_[pos & mask_];
+      const std::size_t sequence =
+          cell.sequence.load(std::memory_order_acquire);
+      const auto lag = static_cast<std::ptrdiff_t>(sequence - pos);
+      if (lag == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          cell.value = value;
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lag < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns false if the queue is empty.
+  bool try_pop(T &value) noexcept {
+    std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell &cell = cells_[pos & mask_];
+      const std::size_t sequence =
+          cell.sequence.load(std::memory_order_acquire);
+      const auto lag = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+      if (lag == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          value = cell.value;
+          cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lag < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+private:
+  static constexpr std::size_t CACHE_LINE = 64;
+
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  std::size_t mask_;
+  // Producers and consumers each hammer their own line.
+  alignas(CACHE_LINE) std::atomic<std::size_t> enqueue_pos_{0};
+  alignas(CACHE_LINE) std::atomic<std::size_t> dequeue_pos_{0};
+};
+
+} // namespace chip8
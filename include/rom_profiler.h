@@ -0,0 +1,235 @@
+#pragma once
+#include "chip8_disassembler.h"
+#include "chip8_memory.h"
+#include "constants.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <numeric>
+#include <ostream>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace chip8 {
+
+// Per-address data accesses. Instruction fetches are not data reads and are
+// left out.
+struct MemoryAccessCounts {
+  std::array<uint64_t, MEMORY_SIZE> reads{};
+  std::array<uint64_t, MEMORY_SIZE> writes{};
+};
+
+// Where a ROM spends its cycles: how often each address was executed, how
+// often each byte was read or written as data, and how many instructions
+// ran under each call stack. Emulator feeds it with sample() before every
+// instruction once enable_profiling() is called.
+//
+// Only Fx33, Fx55, Fx65 and Dxyn touch data memory, so their accesses are
+// derived from the opcode and I rather than counted inside Memory, which
+// keeps read_byte() and write_byte() free of profiling branches.
+class RomProfiler {
+public:
+  RomProfiler() = default;
+  RomProfiler(const RomProfiler &) = delete;
+  RomProfiler &operator=(const RomProfiler &) = delete;
+
+  // Records `opcode` about to run at `pc` with index register `index` and
+  // `call_stack` as pushed by 2nnn, outermost return address first.
+  void sample(uint16_t pc, uint16_t opcode, uint16_t index,
+              std::span<const uint16_t> call_stack) {
+    ++executions_[MaskedAccess::address(pc)];
+    ++instructions_;
+    count_accesses(opcode, index);
+    if (last_ == nullptr || !same_stack(call_stack)) {
+      StackKey key{};
+      key.depth = static_cast<uint8_t>(
+          std::min<std::size_t>(call_stack.size(), NUM_CPU_STACK));
+      std::copy_n(call_stack.begin(), key.depth, key.returns.begin());
+      last_key_ = key;
+      last_ = &stacks_[key];
+    }
+    ++*last_;
+  }
+
+  [[nodiscard]] const MemoryAccessCounts &memory_counts() const noexcept {
+    return accesses_;
+  }
+  [[nodiscard]] uint64_t executions(uint16_t address) const noexcept {
+    return executions_[MaskedAccess::address(address)];
+  }
+  [[nodiscard]] uint64_t instructions() const noexcept {
+    return instructions_;
+  }
+
+  void clear() noexcept {
+    executions_ = {};
+    accesses_ = MemoryAccessCounts{};
+    stacks_.clear();
+    last_ = nullptr;
+    instructions_ = 0;
+  }
+
+  // The `limit` most executed addresses, disassembled from `memory`, with
+  // their share of all instructions and the data accesses to them (hot
+  // code that is also written to is self-modifying), followed by the most
+  // accessed data addresses.
+  void write_hot_listing(std::ostream &out,
+                         std::span<const uint8_t, MEMORY_SIZE> memory,
+                         std::size_t limit = 32) const {
+    char line[96];
+    out << "addr   opcode  instruction          executions    share"
+           "      reads     writes\n";
+    for (const uint16_t address : top(executions_, limit)) {
+      const auto opcode = address < MEMORY_SIZE - 1
+                              ? static_cast<uint16_t>(memory[address] << 8 |
+                                                      memory[address + 1])
+                              : uint16_t{0};
+      std::snprintf(line, sizeof(line),
+                    "0x%03X  %04X    %-18s %12llu %7.2f%% %10llu %10llu\n",
+                    address, opcode, disassemble(opcode).c_str(),
+                    count(executions_[address]),
+                    100.0 * static_cast<double>(executions_[address]) /
+                        static_cast<double>(std::max<uint64_t>(
+                            instructions_, 1)),
+                    count(accesses_.reads[address]),
+                    count(accesses_.writes[address]));
+      out << line;
+    }
+
+    std::array<uint64_t, MEMORY_SIZE> data{};
+    for (std::size_t i = 0; i < MEMORY_SIZE; ++i) {
+      data[i] = accesses_.reads[i] + accesses_.writes[i];
+    }
+    out << "addr        reads     writes\n";
+    for (const uint16_t address : top(data, limit)) {
+      std::snprintf(line, sizeof(line), "0x%03X  %10llu %10llu\n", address,
+                    count(accesses_.reads[address]),
+                    count(accesses_.writes[address]));
+      out << line;
+    }
+  }
+
+  // One "main;sub_0x2A4;sub_0x310 <instructions>" line per call stack, the
+  // folded format flamegraph.pl and speedscope read. A subroutine is named
+  // after the 2nnn in front of its return address in `memory`.
+  void write_collapsed_stacks(
+      std::ostream &out, std::span<const uint8_t, MEMORY_SIZE> memory) const {
+    std::map<std::string, uint64_t> folded;
+    for (const auto &[key, instructions] : stacks_) {
+      std::string frames{"main"};
+      for (std::size_t i = 0; i < key.depth; ++i) {
+        frames += ';';
+        frames += subroutine_name(key.returns[i], memory);
+      }
+      folded[frames] += instructions;
+    }
+    for (const auto &[frames, instructions] : folded) {
+      out << frames << ' ' << instructions << '\n';
+    }
+  }
+
+private:
+  struct StackKey {
+    std::array<uint16_t, NUM_CPU_STACK> returns{};
+    uint8_t depth{};
+
+    bool operator==(const StackKey &) const = default;
+  };
+
+  struct StackHash {
+    std::size_t operator()(const StackKey &key) const noexcept {
+      std::size_t hash = key.depth;
+      for (std::size_t i = 0; i < key.depth; ++i) {
+        hash = hash * 0x9E3779B97F4A7C15ull + key.returns[i];
+      }
+      return hash;
+    }
+  };
+
+  void count_accesses(uint16_t opcode, uint16_t index) noexcept {
+    const unsigned x = (opcode >> 8) & 0x0F;
+    switch (opcode & 0xF0FF) {
+    case 0xF033:
+      add(accesses_.writes, index, 3);
+      return;
+    case 0xF055:
+      add(accesses_.writes, index, x + 1);
+      return;
+    case 0xF065:
+      add(accesses_.reads, index, x + 1);
+      return;
+    default:
+      // Dxyn draws only the part of the sprite that lies in memory.
+      if ((opcode >> 12) == 0xD && index < MEMORY_SIZE) {
+        add(accesses_.reads, index,
+            std::min<unsigned>(opcode & 0x000F, MEMORY_SIZE - index));
+      }
+      return;
+    }
+  }
+
+  // Wraps past 0xFFF as the CPU's accesses do.
+  static void add(std::array<uint64_t, MEMORY_SIZE> &counts, uint16_t first,
+                  unsigned length) noexcept {
+    for (unsigned i = 0; i < length; ++i) {
+      ++counts[MaskedAccess::address(static_cast<uint16_t>(first + i))];
+    }
+  }
+
+  [[nodiscard]] bool
+  same_stack(std::span<const uint16_t> call_stack) const noexcept {
+    return call_stack.size() == last_key_.depth &&
+           std::equal(call_stack.begin(), call_stack.end(),
+                      last_key_.returns.begin());
+  }
+
+  [[nodiscard]] static std::string
+  subroutine_name(uint16_t return_address,
+                  std::span<const uint8_t, MEMORY_SIZE> memory) {
+    char name[16];
+    const auto call = static_cast<uint16_t>(return_address - 2);
+    if (call < MEMORY_SIZE - 1 && (memory[call] >> 4) == 0x2) {
+      std::snprintf(name, sizeof(name), "sub_0x%03X",
+                    (memory[call] & 0x0F) << 8 | memory[call + 1]);
+    } else {
+      std::snprintf(name, sizeof(name), "ret_0x%03X", return_address);
+    }
+    return name;
+  }
+
+  // Addresses with non-zero counts, highest first, ties by address.
+  [[nodiscard]] static std::vector<uint16_t>
+  top(const std::array<uint64_t, MEMORY_SIZE> &counts, std::size_t limit) {
+    std::vector<uint16_t> addresses(MEMORY_SIZE);
+    std::iota(addresses.begin(), addresses.end(), uint16_t{0});
+    std::erase_if(addresses, [&](uint16_t a) { return counts[a] == 0; });
+    const auto end =
+        addresses.begin() +
+        static_cast<std::ptrdiff_t>(std::min(limit, addresses.size()));
+    std::partial_sort(addresses.begin(), end, addresses.end(),
+                      [&](uint16_t a, uint16_t b) {
+                        return counts[a] != counts[b] ? counts[a] > counts[b]
+                                                      : a < b;
+                      });
+    addresses.erase(end, addresses.end());
+    return addresses;
+  }
+
+  [[nodiscard]] static unsigned long long count(uint64_t value) noexcept {
+    return static_cast<unsigned long long>(value);
+  }
+
+  std::array<uint64_t, MEMORY_SIZE> executions_{};
+  MemoryAccessCounts accesses_;
+  std::unordered_map<StackKey, uint64_t, StackHash> stacks_;
+  StackKey last_key_{};
+  uint64_t *last_{nullptr}; // counter of last_key_ in stacks_
+  uint64_t instructions_{};
+};
+
+} // namespace chip8
@@ -1,19 +1,35 @@
 #pragma once
 #include "SDL2/SDL.h"
-#include <atomic>
-#include <cmath>
+#include "beep_synth.h"
+#include "spsc_queue.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <stdexcept>
 
 namespace chip8 {
 
+struct AudioConfig {
+  int sample_rate{44100};
+  // Samples per device buffer; 512 at 44.1 kHz is under 12 ms, so a beep
+  // is heard within a frame or two of the emulator starting it.
+  uint16_t buffer_samples{512};
+  double frequency{440.0};
+  float volume{0.2f};
+};
+
+// Plays the buzzer through SDL. The emulator thread reports changes with
+// beep(); they cross to SDL's audio thread through a lock-free ring, and the
+// callback renders them with a BeepSynth. The device runs continuously, so
+// starting a beep never waits for it to be unpaused.
 class SdlAudio {
 public:
-  SdlAudio() {
+  explicit SdlAudio(AudioConfig config = {}) {
     SDL_AudioSpec desired{};
-    desired.freq = 44100;
+    desired.freq = config.sample_rate;
     desired.format = AUDIO_F32SYS;
     desired.channels = 1;
-    desired.samples = 4096;
+    desired.samples = config.buffer_samples;
     desired.userdata = this;
     desired.callback = [](void *userdata, Uint8 *stream, int len) {
       auto *self = static_cast<SdlAudio *>(userdata);
@@ -23,34 +39,55 @@ public:
     device_ = SDL_OpenAudioDevice(nullptr, 0, &desired, &obtained_, 0);
     if (!device_)
       throw std::runtime_error(SDL_GetError());
+    // The synth needs the rate the device actually runs at.
+    synth_ = BeepSynth{SynthConfig{.sample_rate = obtained_.freq,
+                                   .frequency = config.frequency,
+                                   .volume = config.volume}};
+    SDL_PauseAudioDevice(device_, 0);
   }
 
+  SdlAudio(const SdlAudio &) = delete;
+  SdlAudio &operator=(const SdlAudio &) = delete;
+
   ~SdlAudio() {
     if (device_)
       SDL_CloseAudioDevice(device_);
   }
 
-  void play() noexcept { SDL_PauseAudioDevice(device_, 0); }
-  void stop() noexcept { SDL_PauseAudioDevice(device_, 1); }
+  // Emulator thread: the buzzer is `on` during emulated frame `frame`, from
+  // `offset` into it. Repeats of the current state are not queued. Returns
+  // false if the ring was full and the change was dropped.
+  bool beep(uint64_t frame, bool on, float offset = 0.0f) noexcept {
+    if (on == queued_on_) {
+      return true;
+    }
+    if (!events_.try_push(BeepEvent{frame, offset, on})) {
+      return false;
+    }
+    queued_on_ = on;
+    return true;
+  }
+
+  // Device buffer size actually granted, in samples.
+  [[nodiscard]] uint16_t buffer_samples() const noexcept {
+    return obtained_.samples;
+  }
 
 private:
+  static constexpr std::size_t EVENT_CAPACITY = 256;
+
   void audio_callback(Uint8 *stream, int len) noexcept {
-    float *buf = reinterpret_cast<float *>(stream);
-    int samples = len / sizeof(float);
-    static float phase = 0.0f;
-    float freq = 440.0f;
-
-    for (int i = 0; i < samples; ++i) {
-      buf[i] = playing_ ? std::sin(phase) * 0.2f : 0.0f;
-      phase += 2.0f * float(M_PI) * freq / obtained_.freq;
-      if (phase >= 2.0f * float(M_PI))
-        phase -= 2.0f * float(M_PI);
-    }
+    synth_.render(std::span<float>{reinterpret_cast<float *>(stream),
+                                   static_cast<std::size_t>(len) /
+                                       sizeof(float)},
+                  events_);
   }
 
   SDL_AudioDeviceID device_{};
   SDL_AudioSpec obtained_{};
-  bool playing_{true};
+  SpscQueue<BeepEvent> events_{EVENT_CAPACITY};
+  BeepSynth synth_; // audio thread only, once the device runs
+  bool queued_on_{false}; // emulator thread only
 };
 
-} // namespace chip8
\ No newline at end of file
+} // namespace chip8
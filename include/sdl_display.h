@@ -2,16 +2,22 @@
 #include "SDL2/SDL.h"
 #include "chip8_display.h"
 #include "constants.h"
-#include <array>
+#include "framebuffer_expand.h"
+#include <bit>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <span>
 #include <stdexcept>
 
 namespace chip8 {
 
 class SdlDisplay {
 public:
-  explicit SdlDisplay(int scale = 10) : scale_(scale) {
+  // With `vsync`, render() blocks until the display refreshes. That only
+  // holds up presenting: the emulator paces itself with a FramePacer on its
+  // own thread.
+  explicit SdlDisplay(int scale = 10, bool vsync = true) : scale_(scale) {
     if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0) {
       throw std::runtime_error(SDL_GetError());
     }
@@ -30,7 +36,7 @@ public:
     std::unique_ptr<SDL_Renderer, decltype(&SDL_DestroyRenderer)> rend(
         SDL_CreateRenderer(win.get(), -1,
                            SDL_RENDERER_ACCELERATED |
-                               SDL_RENDERER_PRESENTVSYNC),
+                               (vsync ? SDL_RENDERER_PRESENTVSYNC : 0u)),
         SDL_DestroyRenderer);
     if (!rend) {
       throw std::runtime_error(SDL_GetError());
@@ -53,22 +59,27 @@ public:
     SDL_SetRenderDrawColor(renderer_.get(), 0, 0, 0, SDL_ALPHA_OPAQUE);
   }
 
-  void render(const Display &display) {
-    for (int y = 0; y < SCREEN_HEIGHT; ++y) {
-      for (int x = 0; x < SCREEN_WIDTH; ++x) {
-        bool pixel_on = display.is_pixel_set(x, y);
-        pixel_buffer_[y * SCREEN_WIDTH + x] =
-            pixel_on ? 0xFFFFFFFFu : 0xFF000000u;
-      }
-    }
+  void set_title(const char *title) noexcept {
+    SDL_SetWindowTitle(window_.get(), title);
+  }
 
-    const int pitch =
-        static_cast<int>(SCREEN_WIDTH) * static_cast<int>(sizeof(uint32_t));
+  // Colours are RGBA8888 texels, i.e. 0xRRGGBBAA.
+  void set_palette(uint32_t foreground, uint32_t background) noexcept {
+    foreground_ = foreground;
+    background_ = background;
+    uploaded_from_ = nullptr;
+  }
 
-    if (SDL_UpdateTexture(texture_.get(), nullptr, pixel_buffer_.data(),
-                          pitch) != 0) {
-      throw std::runtime_error(SDL_GetError());
+  // Only rows that changed since the previous call are uploaded; nothing is
+  // when the ROM did not draw.
+  void render(const Display &display) {
+    uint32_t dirty = display.dirty_rows(uploaded_generation_);
+    if (&display != uploaded_from_) {
+      dirty = ALL_ROWS;
     }
+    upload_rows(display.rows(), dirty);
+    uploaded_from_ = &display;
+    uploaded_generation_ = display.generation();
 
     SDL_Rect dst{0, 0, static_cast<int>(SCREEN_WIDTH) * scale_,
                  static_cast<int>(SCREEN_HEIGHT) * scale_};
@@ -85,6 +96,30 @@ public:
   }
 
 private:
+  static constexpr uint32_t ALL_ROWS =
+      SCREEN_HEIGHT == 32 ? ~0u : (1u << SCREEN_HEIGHT) - 1;
+
+  // Locks and fills one texture rectangle per run of consecutive dirty rows.
+  void upload_rows(std::span<const uint64_t, SCREEN_HEIGHT> rows,
+                   uint32_t dirty) {
+    while (dirty != 0) {
+      const int first = std::countr_zero(dirty);
+      const int count = std::countr_one(dirty >> first);
+      const SDL_Rect rect{0, first, SCREEN_WIDTH, count};
+
+      void *pixels = nullptr;
+      int pitch = 0;
+      if (SDL_LockTexture(texture_.get(), &rect, &pixels, &pitch) != 0) {
+        throw std::runtime_error(SDL_GetError());
+      }
+      expand_rows(rows.subspan(first, count), pixels,
+                  static_cast<std::size_t>(pitch), foreground_, background_);
+      SDL_UnlockTexture(texture_.get());
+
+      dirty &= count == 32 ? 0u : ~(((1u << count) - 1) << first);
+    }
+  }
+
   std::unique_ptr<SDL_Window, decltype(&SDL_DestroyWindow)> window_{
       nullptr, SDL_DestroyWindow};
   std::unique_ptr<SDL_Renderer, decltype(&SDL_DestroyRenderer)> renderer_{
@@ -92,7 +127,10 @@ private:
   std::unique_ptr<SDL_Texture, decltype(&SDL_DestroyTexture)> texture_{
       nullptr, SDL_DestroyTexture};
 
-  std::array<uint32_t, SCREEN_HEIGHT * SCREEN_WIDTH> pixel_buffer_{};
+  uint32_t foreground_{0xFFFFFFFFu};
+  uint32_t background_{0x000000FFu};
+  const Display *uploaded_from_{nullptr};
+  uint64_t uploaded_generation_{};
   int scale_;
 };
 
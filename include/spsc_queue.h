@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+namespace chip8 {
+
+// Bounded lock-free ring for exactly one producer and one consumer thread,
+// e.g. the emulator feeding a real-time audio callback. Each side only
+// stores its own position and loads the other's, so a push or pop is a
+// couple of plain memory operations: no CAS, no locks, no allocation.
+template <typename T> class SpscQueue {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "slots are reused without destruction");
+
+public:
+  // Rounded up to a power of two.
+  explicit SpscQueue(std::size_t capacity)
+      : slots_{std::make_unique<T[]>(
+            std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity))},
+        mask_{std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1} {}
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask_ + 1; }
+
+  // Producer only. Returns false if the queue is full.
+  bool try_push(const T &value) noexcept {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ > mask_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ > mask_) {
+        return false;
+      }
+    }
+    slots_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. The oldest value, left queued; empty if there is none.
+  [[nodiscard]] std::optional<T> front() noexcept {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) {
+        return std::nullopt;
+      }
+    }
+    return slots_[head & mask_];
+  }
+
+  // Consumer only. Returns false if the queue is empty.
+  bool try_pop(T &value) noexcept {
+    const auto oldest = front();
+    if (!oldest) {
+      return false;
+    }
+    value = *oldest;
+    head_.store(head_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+    return true;
+  }
+
+private:
+  static constexpr std::size_t CACHE_LINE = 64;
+
+  std::unique_ptr<T[]> slots_;
+  std::size_t mask_;
+  // Each side's position and its cached copy of the other's share a line,
+  // so the other side's line is only fetched when the cache runs out.
+  alignas(CACHE_LINE) std::atomic<std::size_t> tail_{0};
+  std::size_t head_cache_{0}; // producer only
+  alignas(CACHE_LINE) std::atomic<std::size_t> head_{0};
+  std::size_t tail_cache_{0}; // consumer only
+};
+
+} // namespace chip8
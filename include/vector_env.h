@@ -0,0 +1,187 @@
+#pragma once
+#include "batch_runner.h"
+#include "chip8_emulator.h"
+#include "constants.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace chip8 {
+
+// How VectorEnv lays out one instance's framebuffer.
+enum class ObservationFormat {
+  Bytes,      // 32 x 64 bytes, 0 or 1, row-major
+  PackedBits, // 32 x 8 bytes, MSB first: bit 7 of byte 0 is x = 0
+};
+
+[[nodiscard]] constexpr std::size_t
+observation_size(ObservationFormat format) noexcept {
+  return format == ObservationFormat::Bytes
+             ? std::size_t{SCREEN_WIDTH} * SCREEN_HEIGHT
+             : std::size_t{SCREEN_WIDTH / 8} * SCREEN_HEIGHT;
+}
+
+// Writes `display` into `out`, which holds observation_size(format) bytes.
+inline void write_observation(const Display &display, ObservationFormat format,
+                              uint8_t *out) noexcept {
+  for (const uint64_t row : display.rows()) {
+    if (format == ObservationFormat::Bytes) {
+      for (int x = 0; x < SCREEN_WIDTH; ++x) {
+        out[x] = static_cast<uint8_t>((row >> (SCREEN_WIDTH - 1 - x)) & 1);
+      }
+      out += SCREEN_WIDTH;
+    } else {
+      const uint64_t big_endian =
+          std::endian::native == std::endian::little ? std::byteswap(row)
+                                                     : row;
+      std::memcpy(out, &big_endian, sizeof(big_endian));
+      out += sizeof(big_endian);
+    }
+  }
+}
+
+// N copies of one ROM stepped together for reinforcement learning. step()
+// takes one key mask per instance, runs every instance for a frame and
+// writes all framebuffers, rewards and done flags straight into arrays the
+// caller owns, e.g. the storage of a NumPy array, so nothing is gathered
+// per instance afterwards.
+//
+// An instance is done when the done hook says so, by default once the ROM
+// halts (see is_halted()). It is then reloaded on the spot and its
+// observation shows the first frame of the new episode. Instance i starts
+// with seed `seed + i`; every reload, by done or by reset() after the
+// first frame, moves it on by the instance count, so no two episodes share
+// a seed.
+class VectorEnv {
+public:
+  // Called after instance `index` ran a frame.
+  using RewardHook = std::function<float(std::size_t index, const Emulator &)>;
+  using DoneHook = std::function<bool(std::size_t index, const Emulator &)>;
+
+  struct StepResult {
+    float reward{};
+    bool done{false};
+  };
+
+  VectorEnv(std::span<const uint8_t> rom, std::size_t count,
+            ObservationFormat format = ObservationFormat::Bytes,
+            uint32_t cycles_per_frame = 10,
+            uint64_t seed = Emulator::DEFAULT_SEED)
+      : rom_(rom.begin(), rom.end()), format_{format},
+        done_hook_{[](std::size_t, const Emulator &emulator) {
+          return is_halted(emulator);
+        }} {
+    if (count == 0) {
+      throw std::invalid_argument("VectorEnv needs at least one instance.");
+    }
+    instances_.reserve(count);
+    fresh_.assign(count, 1);
+    for (std::size_t i = 0; i < count; ++i) {
+      instances_.push_back(
+          std::make_unique<Emulator>(cycles_per_frame, seed + i));
+      instances_.back()->load_rom(std::span<const uint8_t>(rom_));
+    }
+  }
+
+  void set_reward_hook(RewardHook hook) { reward_hook_ = std::move(hook); }
+  void set_done_hook(DoneHook hook) { done_hook_ = std::move(hook); }
+
+  [[nodiscard]] std::size_t size() const noexcept { return instances_.size(); }
+  [[nodiscard]] ObservationFormat format() const noexcept { return format_; }
+  // Bytes one instance takes in an observation buffer.
+  [[nodiscard]] std::size_t observation_size() const noexcept {
+    return chip8::observation_size(format_);
+  }
+
+  // Reloads every instance and writes the first observations. A reset()
+  // before any step keeps the constructor's seeds.
+  void reset(std::span<uint8_t> observations) {
+    check_observations(observations);
+    for (std::size_t i = 0; i < size(); ++i) {
+      if (!fresh_[i]) {
+        instances_[i]->set_seed(instances_[i]->seed() + size());
+      }
+      fresh_[i] = 0;
+      restart(i);
+      write_observation(instances_[i]->display(), format_,
+                        observations.data() + i * observation_size());
+    }
+  }
+
+  // Presses actions[i] on instance i (bit k = key k) and runs one frame
+  // everywhere. Buffers hold size() entries, observations size() times
+  // observation_size() bytes; dones are 0 or 1.
+  void step(std::span<const uint16_t> actions, std::span<uint8_t> observations,
+            std::span<float> rewards, std::span<uint8_t> dones) {
+    if (actions.size() != size() || rewards.size() != size() ||
+        dones.size() != size()) {
+      throw std::invalid_argument("Step buffers must match the env size.");
+    }
+    check_observations(observations);
+    for (std::size_t i = 0; i < size(); ++i) {
+      const StepResult result = step_at(
+          i, actions[i],
+          observations.subspan(i * observation_size(), observation_size()));
+      rewards[i] = result.reward;
+      dones[i] = result.done;
+    }
+  }
+
+  // Steps instance `index` alone. Distinct instances may be stepped from
+  // different threads at once as long as the hooks allow it.
+  StepResult step_at(std::size_t index, uint16_t action,
+                     std::span<uint8_t> observation) {
+    if (observation.size() != observation_size()) {
+      throw std::invalid_argument("Observation buffer has the wrong size.");
+    }
+    Emulator &emulator = *instances_[index];
+    fresh_[index] = 0;
+    emulator.keyboard().set_key_mask(action);
+    emulator.run_frame();
+
+    StepResult result;
+    if (reward_hook_) {
+      result.reward = reward_hook_(index, emulator);
+    }
+    result.done = done_hook_ && done_hook_(index, emulator);
+    if (result.done) {
+      emulator.set_seed(emulator.seed() + size());
+      restart(index);
+    }
+    write_observation(emulator.display(), format_, observation.data());
+    return result;
+  }
+
+  [[nodiscard]] const Emulator &instance(std::size_t index) const noexcept {
+    return *instances_[index];
+  }
+
+private:
+  void check_observations(std::span<const uint8_t> observations) const {
+    if (observations.size() != size() * observation_size()) {
+      throw std::invalid_argument("Observation buffer has the wrong size.");
+    }
+  }
+
+  void restart(std::size_t index) {
+    instances_[index]->load_rom(std::span<const uint8_t>(rom_));
+  }
+
+  std::vector<uint8_t> rom_;
+  ObservationFormat format_;
+  std::vector<std::unique_ptr<Emulator>> instances_;
+  // Per instance, so step_at() on different threads never shares one:
+  // nonzero until its first reset() or frame.
+  std::vector<uint8_t> fresh_;
+  RewardHook reward_hook_;
+  DoneHook done_hook_;
+};
+
+} // namespace chip8
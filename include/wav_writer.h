@@ -0,0 +1,120 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+
+namespace chip8 {
+
+// Streams mono 16-bit PCM to a RIFF/WAVE file. The header goes out first
+// with placeholder sizes that finish() patches, so nothing but one block of
+// samples is ever held in memory; the stream must be seekable.
+//
+// RIFF sizes are 32-bit, which caps a plain WAV at a little over 13 hours
+// at 44.1 kHz. A longer recording is finished as RF64 (EBU Tech 3306): the
+// JUNK chunk reserved after the RIFF header becomes a ds64 chunk holding
+// the 64-bit sizes, and the 32-bit ones are set to 0xFFFFFFFF.
+class WavWriter {
+public:
+  static constexpr std::size_t HEADER_SIZE = 80;
+  // Largest RIFF size a plain WAV can state.
+  static constexpr uint64_t RIFF_LIMIT = UINT32_MAX;
+
+  // `riff_limit` is only lowered to test the RF64 switch without writing
+  // gigabytes.
+  WavWriter(std::ostream &out, uint32_t sample_rate,
+            uint64_t riff_limit = RIFF_LIMIT)
+      : out_{out}, riff_limit_{riff_limit} {
+    start_ = out_.tellp();
+    write_header(sample_rate, 0);
+    check();
+  }
+
+  WavWriter(const WavWriter &) = delete;
+  WavWriter &operator=(const WavWriter &) = delete;
+
+  // Samples outside [-1, 1] are clipped.
+  void write(std::span<const float> samples) {
+    std::array<char, BLOCK * 2> bytes;
+    while (!samples.empty()) {
+      const std::size_t count = std::min(samples.size(), BLOCK);
+      for (std::size_t i = 0; i < count; ++i) {
+        const auto value = static_cast<int16_t>(
+            std::lrint(std::clamp(samples[i], -1.0f, 1.0f) * 32767.0f));
+        bytes[2 * i] = static_cast<char>(value & 0xFF);
+        bytes[2 * i + 1] = static_cast<char>((value >> 8) & 0xFF);
+      }
+      out_.write(bytes.data(), static_cast<std::streamsize>(count * 2));
+      samples_ += count;
+      samples = samples.subspan(count);
+    }
+    check();
+  }
+
+  // Fills in the sizes, switching to RF64 if they do not fit in 32 bits.
+  void finish() {
+    const auto end = out_.tellp();
+    out_.seekp(start_);
+    write_header(sample_rate_, samples_ * 2);
+    out_.seekp(end);
+    out_.flush();
+    check();
+  }
+
+  [[nodiscard]] uint64_t samples_written() const noexcept { return samples_; }
+
+private:
+  static constexpr std::size_t BLOCK = 2048;
+  static constexpr uint32_t DS64_SIZE = 28;
+
+  void write_header(uint32_t sample_rate, uint64_t data_bytes) {
+    sample_rate_ = sample_rate;
+    const auto le = [&](uint64_t value, int bytes) {
+      for (int i = 0; i < bytes; ++i) {
+        out_.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+      }
+    };
+    const auto u64 = [&](uint64_t value) { le(value, 8); };
+    const auto u32 = [&](uint32_t value) { le(value, 4); };
+    const auto u16 = [&](uint16_t value) { le(value, 2); };
+    const uint64_t riff_bytes = HEADER_SIZE - 8 + data_bytes;
+    const bool rf64 = riff_bytes > riff_limit_;
+    out_.write(rf64 ? "RF64" : "RIFF", 4);
+    u32(rf64 ? UINT32_MAX : static_cast<uint32_t>(riff_bytes));
+    out_.write("WAVE", 4);
+    out_.write(rf64 ? "ds64" : "JUNK", 4);
+    u32(DS64_SIZE);
+    u64(rf64 ? riff_bytes : 0);
+    u64(rf64 ? data_bytes : 0);
+    u64(rf64 ? data_bytes / 2 : 0); // sample frames
+    u32(0);                         // no table entries
+    out_.write("fmt ", 4);
+    u32(16); // fmt chunk size
+    u16(1);  // PCM
+    u16(1);  // mono
+    u32(sample_rate);
+    u32(sample_rate * 2); // bytes per second
+    u16(2);               // bytes per sample frame
+    u16(16);              // bits per sample
+    out_.write("data", 4);
+    u32(rf64 ? UINT32_MAX : static_cast<uint32_t>(data_bytes));
+  }
+
+  void check() const {
+    if (!out_) {
+      throw std::runtime_error("Failed to write WAV output.");
+    }
+  }
+
+  std::ostream &out_;
+  uint64_t riff_limit_;
+  std::ostream::pos_type start_{};
+  uint32_t sample_rate_{};
+  uint64_t samples_{};
+};
+
+} // namespace chip8
@@ -0,0 +1,165 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace chip8 {
+
+// Fixed set of worker threads, each owning a deque of task indices. A worker
+// pops from the back of its own deque and steals from the front of the
+// others once it runs dry, so long-running instances do not leave the rest
+// of the pool idle.
+class WorkStealingPool {
+public:
+  explicit WorkStealingPool(std::size_t thread_count = default_thread_count())
+      : queues_(std::max<std::size_t>(thread_count, 1)) {
+    for (auto &queue : queues_) {
+      queue = std::make_unique<TaskQueue>();
+    }
+    workers_.reserve(queues_.size());
+    for (std::size_t id = 0; id < queues_.size(); ++id) {
+      workers_.emplace_back([this, id] { worker_loop(id); });
+    }
+  }
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard lock{mutex_};
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  [[nodiscard]] std::size_t thread_count() const noexcept {
+    return workers_.size();
+  }
+
+  [[nodiscard]] static std::size_t default_thread_count() noexcept {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Runs fn(i) for every i in [0, count) and blocks until all calls returned.
+  // The first exception thrown by fn is rethrown here once the batch drained.
+  void parallel_for(std::size_t count, std::function<void(std::size_t)> fn) {
+    if (count == 0) {
+      return;
+    }
+
+    {
+      std::lock_guard lock{mutex_};
+      job_ = std::move(fn);
+      pending_ = count;
+      error_ = nullptr;
+    }
+
+    // Publish the job before the tasks: a worker still draining the previous
+    // batch may pick these up without waiting for the epoch change.
+    for (std::size_t i = 0; i < count; ++i) {
+      auto &queue = *queues_[i % queues_.size()];
+      std::lock_guard lock{queue.mutex};
+      queue.tasks.push_back(i);
+    }
+
+    {
+      std::lock_guard lock{mutex_};
+      ++epoch_;
+    }
+    wake_.notify_all();
+
+    std::unique_lock lock{mutex_};
+    done_.wait(lock, [this] { return pending_ == 0; });
+    job_ = nullptr;
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+private:
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<std::size_t> tasks;
+  };
+
+  void worker_loop(std::size_t id) {
+    uint64_t seen_epoch = 0;
+    while (true) {
+      {
+        std::unique_lock lock{mutex_};
+        wake_.wait(lock, [&] { return stopping_ || epoch_ != seen_epoch; });
+        if (stopping_) {
+          return;
+        }
+        seen_epoch = epoch_;
+      }
+
+      while (auto task = next_task(id)) {
+        try {
+          job_(*task);
+        } catch (...) {
+          std::lock_guard lock{mutex_};
+          if (!error_) {
+            error_ = std::current_exception();
+          }
+        }
+
+        std::lock_guard lock{mutex_};
+        if (--pending_ == 0) {
+          done_.notify_all();
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] std::optional<std::size_t> next_task(std::size_t id) {
+    {
+      auto &own = *queues_[id];
+      std::lock_guard lock{own.mutex};
+      if (!own.tasks.empty()) {
+        auto task = own.tasks.back();
+        own.tasks.pop_back();
+        return task;
+      }
+    }
+
+    for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+      auto &victim = *queues_[(id + offset) % queues_.size()];
+      std::lock_guard lock{victim.mutex};
+      if (!victim.tasks.empty()) {
+        auto task = victim.tasks.front();
+        victim.tasks.pop_front();
+        return task;
+      }
+    }
+    return std::nullopt;
+  }
+
+  std::vector<std::unique_ptr<TaskQueue>> queues_;
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  std::function<void(std::size_t)> job_;
+  std::size_t pending_{};
+  uint64_t epoch_{};
+  bool stopping_{false};
+  std::exception_ptr error_;
+};
+
+} // namespace chip8
@@ -0,0 +1,275 @@
+#include "batch_runner.h"
+#include "input_movie.h"
+#include "work_stealing_pool.h"
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Options {
+  std::vector<std::string> roms;
+  std::string manifest;
+  std::string movie;
+  std::string profile;
+  std::string audio;
+  std::size_t threads = chip8::WorkStealingPool::default_thread_count();
+  uint32_t frames = 600;
+  uint32_t cycles_per_frame = 10;
+  uint32_t repeat = 1;
+  chip8::DispatchMode dispatch_mode = chip8::DispatchMode::Switch;
+};
+
+void print_usage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " [--threads N] [--frames N] [--cycles N] [--repeat N]"
+               " [--dispatch switch|table|cached|jit] [--manifest FILE]"
+               " [--movie FILE] [--profile PREFIX] [--audio PREFIX]"
+               " [rom...]\n"
+               "Manifest lines: <rom-path> [frames] [cycles_per_frame]\n"
+               "--movie replays recorded input on every ROM and verifies the"
+               " final state\n"
+               "--profile writes PREFIX<index>.hot.txt (hottest addresses,"
+               " disassembled)\n"
+               "and PREFIX<index>.folded (collapsed call stacks for"
+               " flamegraph.pl) per ROM\n"
+               "--audio renders each ROM's buzzer to PREFIX<index>.wav\n";
+}
+
+// Accepts plain decimal digits up to UINT32_MAX, unlike std::stoul, which
+// also takes a sign, leading blanks and trailing junk.
+uint32_t parse_count(const std::string &value, const char *flag) {
+  uint32_t parsed = 0;
+  const char *end = value.data() + value.size();
+  const auto [ptr, ec] = std::from_chars(value.data(), end, parsed);
+  if (value.empty() || ec != std::errc{} || ptr != end) {
+    throw std::invalid_argument(std::string{"Invalid value for "} + flag +
+                                ": " + value);
+  }
+  return parsed;
+}
+
+chip8::DispatchMode parse_dispatch_mode(const std::string &value) {
+  if (value == "switch") {
+    return chip8::DispatchMode::Switch;
+  }
+  if (value == "table") {
+    return chip8::DispatchMode::Table;
+  }
+  if (value == "jit") {
+    return chip8::DispatchMode::Jit;
+  }
+  if (value == "cached") {
+    return chip8::DispatchMode::Cached;
+  }
+  throw std::invalid_argument("Invalid value for --dispatch: " + value);
+}
+
+Options parse_options(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg{argv[i]};
+    auto next_value = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("Missing value for " + arg);
+      }
+      return argv[++i];
+    };
+
+    if (arg == "--threads") {
+      options.threads = parse_count(next_value(), "--threads");
+    } else if (arg == "--frames") {
+      options.frames = parse_count(next_value(), "--frames");
+    } else if (arg == "--cycles") {
+      options.cycles_per_frame = parse_count(next_value(), "--cycles");
+    } else if (arg == "--repeat") {
+      options.repeat = parse_count(next_value(), "--repeat");
+    } else if (arg == "--dispatch") {
+      options.dispatch_mode = parse_dispatch_mode(next_value());
+    } else if (arg == "--manifest") {
+      options.manifest = next_value();
+    } else if (arg == "--movie") {
+      options.movie = next_value();
+    } else if (arg == "--profile") {
+      options.profile = next_value();
+    } else if (arg == "--audio") {
+      options.audio = next_value();
+    } else if (arg.starts_with("--")) {
+      throw std::invalid_argument("Unknown option: " + arg);
+    } else {
+      options.roms.push_back(arg);
+    }
+  }
+  return options;
+}
+
+class RomCache {
+public:
+  std::shared_ptr<const std::vector<uint8_t>>
+  load(const std::filesystem::path &path) {
+    auto [it, inserted] = roms_.try_emplace(path.string());
+    if (inserted) {
+      std::ifstream file(path, std::ios::binary);
+      if (!file) {
+        throw std::runtime_error("Failed to open ROM file: " + path.string());
+      }
+      it->second = std::make_shared<const std::vector<uint8_t>>(
+          std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>());
+    }
+    return it->second;
+  }
+
+private:
+  std::map<std::string, std::shared_ptr<const std::vector<uint8_t>>> roms_;
+};
+
+std::vector<chip8::BatchJob> build_jobs(const Options &options) {
+  RomCache cache;
+  std::vector<chip8::BatchJob> jobs;
+
+  std::shared_ptr<const chip8::InputMovie> movie;
+  if (!options.movie.empty()) {
+    std::ifstream file(options.movie, std::ios::binary);
+    if (!file) {
+      throw std::runtime_error("Failed to open movie: " + options.movie);
+    }
+    movie = std::make_shared<const chip8::InputMovie>(chip8::read_movie(file));
+  }
+
+  auto add_job = [&](const std::string &path, uint32_t frames,
+                     uint32_t cycles) {
+    auto rom = cache.load(path);
+    for (uint32_t i = 0; i < options.repeat; ++i) {
+      jobs.push_back({path, rom, frames, cycles, options.dispatch_mode, movie,
+                      !options.profile.empty()});
+      if (!options.audio.empty()) {
+        jobs.back().audio =
+            options.audio + std::to_string(jobs.size() - 1) + ".wav";
+      }
+    }
+  };
+
+  if (!options.manifest.empty()) {
+    std::ifstream manifest(options.manifest);
+    if (!manifest) {
+      throw std::runtime_error("Failed to open manifest: " + options.manifest);
+    }
+    std::string line;
+    while (std::getline(manifest, line)) {
+      if (line.empty() || line.front() == '#') {
+        continue;
+      }
+      std::istringstream fields(line);
+      std::string path;
+      std::string frames;
+      std::string cycles;
+      std::string extra;
+      fields >> path >> frames >> cycles;
+      if (path.empty()) {
+        continue;
+      }
+      if (fields >> extra) {
+        throw std::invalid_argument("Unexpected field in manifest: " + line);
+      }
+      add_job(path,
+              frames.empty() ? options.frames
+                             : parse_count(frames, "manifest frames"),
+              cycles.empty() ? options.cycles_per_frame
+                             : parse_count(cycles, "manifest cycles"));
+    }
+  }
+
+  for (const auto &rom : options.roms) {
+    add_job(rom, options.frames, options.cycles_per_frame);
+  }
+  return jobs;
+}
+
+void write_profile(const std::string &prefix, std::size_t index,
+                   const chip8::BatchResult &result) {
+  const std::string base = prefix + std::to_string(index);
+  for (const auto &[suffix, text] :
+       {std::pair{".hot.txt", &result.hot_listing},
+        std::pair{".folded", &result.collapsed_stacks}}) {
+    std::ofstream file(base + suffix);
+    if (!file) {
+      throw std::runtime_error("Failed to write profile: " + base + suffix);
+    }
+    file << *text;
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    const auto options = parse_options(argc, argv);
+    const auto jobs = build_jobs(options);
+    if (jobs.empty()) {
+      print_usage(argv[0]);
+      return 1;
+    }
+
+    chip8::WorkStealingPool pool{options.threads};
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto results = chip8::run_batch(jobs, pool);
+    const auto elapsed = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+    uint64_t total_frames = 0;
+    uint64_t total_cycles = 0;
+    bool movies_verified = true;
+    std::cout << "index,rom,stop,frames,cycles,pc,display_hash,movie,error\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      const auto &result = results[i];
+      total_frames += result.frames_run;
+      total_cycles += result.cycles_run;
+      std::cout << i << ',' << jobs[i].name << ','
+                << chip8::to_string(result.stop_reason) << ','
+                << result.frames_run << ',' << result.cycles_run << ",0x"
+                << std::hex << result.program_counter << ",0x"
+                << result.display_hash << std::dec << ','
+                << (result.movie_verified.has_value()
+                        ? (*result.movie_verified ? "verified" : "mismatch")
+                        : "")
+                << ',' << result.error << '\n';
+      movies_verified = movies_verified && result.movie_verified != false;
+      if (!options.profile.empty()) {
+        write_profile(options.profile, i, result);
+      }
+    }
+
+    std::cerr << "instances: " << results.size()
+              << ", threads: " << pool.thread_count()
+              << ", frames: " << total_frames << ", seconds: " << elapsed
+              << ", frames/sec: "
+              << (elapsed > 0.0 ? total_frames / elapsed : 0.0)
+              // Nominal cycles, including those skipped in idle loops
+              // and parked frames rather than executed.
+              << ", emulated MIPS: "
+              << (elapsed > 0.0 ? total_cycles / elapsed / 1e6 : 0.0) << '\n';
+    if (!movies_verified) {
+      std::cerr << "Movie playback diverged from the recording.\n";
+      return 1;
+    }
+  } catch (const std::exception &ex) {
+    std::cerr << "Fatal error: " << ex.what() << '\n';
+    print_usage(argv[0]);
+    return 1;
+  }
+  return 0;
+}
@@ -1,12 +1,448 @@
 #include "chip8_cpu.h"
 #include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
 namespace chip8 {
 
-void Cpu::execute() {
+namespace {
+
+// Touches nothing but V, I and the program counter, and depends on nothing
+// but those, memory, the keys and the delay timer.
+constexpr bool is_idle_safe(uint16_t opcode) noexcept {
+  switch (opcode >> 12) {
+  case 0x1:
+  case 0x3:
+  case 0x4:
+  case 0x6:
+  case 0x7:
+  case 0xA:
+  case 0xB:
+    return true;
+  case 0x5:
+  case 0x9:
+    return (opcode & 0x000F) == 0;
+  case 0x8:
+    return (opcode & 0x000F) <= 0x7 || (opcode & 0x000F) == 0xE;
+  case 0xE:
+    return (opcode & 0x00FF) == 0x9E || (opcode & 0x00FF) == 0xA1;
+  case 0xF:
+    switch (opcode & 0x00FF) {
+    case 0x07:
+    case 0x1E:
+    case 0x29:
+    case 0x65:
+      return true;
+    default:
+      return false;
+    }
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+template <typename Access, typename Random>
+struct BasicCpu<Access, Random>::Ops {
+  static void nop(BasicCpu &, uint16_t) noexcept {}
+
+  static void cls(BasicCpu &cpu, uint16_t) noexcept {
+    cpu.display_.get().clear();
+  }
+
+  static void ret(BasicCpu &cpu, uint16_t) noexcept(NOEXCEPT) {
+    cpu.pc_ = cpu.pop();
+  }
+
+  static void sys(BasicCpu &, uint16_t) noexcept {
+    std::cerr << "[Warning] 0nnn - SYS addr is ignored." << std::endl;
+  }
+
+  static void jp(BasicCpu &cpu, uint16_t opcode) noexcept {
+    cpu.pc_ = opcode & 0x0FFF;
+  }
+
+  static void call(BasicCpu &cpu, uint16_t opcode) noexcept(NOEXCEPT) {
+    cpu.push(cpu.pc_);
+    cpu.pc_ = opcode & 0x0FFF;
+  }
+
+  template <std::size_t X>
+  static void se_byte(BasicCpu &cpu, uint16_t opcode) noexcept {
+    if (cpu.v_[X] == (opcode & 0x00FF)) {
+      cpu.pc_ += 2;
+    }
+  }
+
+  template <std::size_t X>
+  static void sne_byte(BasicCpu &cpu, uint16_t opcode) noexcept {
+    if (cpu.v_[X] != (opcode & 0x00FF)) {
+      cpu.pc_ += 2;
+    }
+  }
+
+  template <std::size_t X, std::size_t Y>
+  static void se_reg(BasicCpu &cpu, uint16_t) noexcept {
+    if (cpu.v_[X] == cpu.v_[Y]) {
+      cpu.pc_ += 2;
+    }
+  }
+
+  template <std::size_t X>
+  static void ld_byte(BasicCpu &cpu, uint16_t opcode) noexcept {
+    cpu.v_[X] = static_cast<uint8_t>(opcode & 0x00FF);
+  }
+
+  template <std::size_t X>
+  static void add_byte(BasicCpu &cpu, uint16_t opcode) noexcept {
+    cpu.v_[X] += static_cast<uint8_t>(opcode & 0x00FF);
+  }
+
+  template <std::size_t N, std::size_t X, std::size_t Y>
+  static void alu(BasicCpu &cpu, uint16_t) noexcept {
+    auto &v = cpu.v_;
+    if constexpr (N == 0x0) {
+      v[X] = v[Y];
+    } else if constexpr (N == 0x1) {
+      v[X] |= v[Y];
+    } else if constexpr (N == 0x2) {
+      v[X] &= v[Y];
+    } else if constexpr (N == 0x3) {
+      v[X] ^= v[Y];
+    } else if constexpr (N == 0x4) {
+      const uint16_t sum = v[X] + v[Y];
+      v[0x0F] = sum > 0xFFu ? 0x01u : 0x00u;
+      v[X] = static_cast<uint8_t>(sum);
+    } else if constexpr (N == 0x5) {
+      v[0x0F] = v[X] >= v[Y] ? 0x01u : 0x00u;
+      v[X] = static_cast<uint8_t>(v[X] - v[Y]);
+    } else if constexpr (N == 0x6) {
+      v[0x0F] = v[X] & 0b00000001u;
+      v[X] >>= 1;
+    } else if constexpr (N == 0x7) {
+      const uint8_t vx = v[X];
+      const uint8_t vy = v[Y];
+      v[0x0F] = vy >= vx ? 0x01u : 0x00u;
+      v[X] = static_cast<uint8_t>(vy - vx);
+    } else if constexpr (N == 0xE) {
+      v[0x0F] = (v[X] & 0b10000000u) != 0x00u ? 0x01u : 0x00u;
+      v[X] <<= 1;
+    }
+  }
+
+  template <std::size_t X, std::size_t Y>
+  static void sne_reg(BasicCpu &cpu, uint16_t) noexcept {
+    if (cpu.v_[X] != cpu.v_[Y]) {
+      cpu.pc_ += 2;
+    }
+  }
+
+  static void ld_i(BasicCpu &cpu, uint16_t opcode) noexcept {
+    cpu.I_ = opcode & 0x0FFF;
+  }
+
+  static void jp_v0(BasicCpu &cpu, uint16_t opcode) noexcept {
+    cpu.pc_ = cpu.v_[0x00] + (opcode & 0x0FFF);
+  }
+
+  template <std::size_t X>
+  static void rnd(BasicCpu &cpu, uint16_t opcode) noexcept {
+    cpu.v_[X] = cpu.rng_.get().next(static_cast<uint8_t>(opcode & 0x00FF));
+  }
+
+  template <std::size_t X, std::size_t Y>
+  static void drw(BasicCpu &cpu, uint16_t opcode) noexcept {
+    auto memory_span = cpu.memory_.get().span();
+    const std::size_t n = opcode & 0x000F;
+    if (cpu.I_ >= memory_span.size()) {
+      cpu.v_[0x0F] = 0;
+      return;
+    }
+
+    const auto available =
+        std::min<std::size_t>(n, memory_span.size() - cpu.I_);
+    if (available == 0) {
+      cpu.v_[0x0F] = 0;
+      return;
+    }
+
+    auto sprite = memory_span.subspan(cpu.I_, available);
+    cpu.v_[0x0F] =
+        cpu.display_.get().draw_sprite(cpu.v_[X], cpu.v_[Y], sprite) ? 1 : 0;
+  }
+
+  template <std::size_t X>
+  static void skp(BasicCpu &cpu, uint16_t) noexcept(NOEXCEPT) {
+    if (cpu.key_pressed(cpu.v_[X])) {
+      cpu.pc_ += 2;
+    }
+  }
+
+  template <std::size_t X>
+  static void sknp(BasicCpu &cpu, uint16_t) noexcept(NOEXCEPT) {
+    if (!cpu.key_pressed(cpu.v_[X])) {
+      cpu.pc_ += 2;
+    }
+  }
+
+  template <std::size_t KK, std::size_t X>
+  static void misc(BasicCpu &cpu, uint16_t) noexcept(NOEXCEPT) {
+    auto &v = cpu.v_;
+    if constexpr (KK == 0x07) {
+      v[X] = cpu.timer_.get().delay();
+    } else if constexpr (KK == 0x0A) {
+      auto key = cpu.keyboard_.get().last_pressed();
+      if (key.has_value()) {
+        v[X] = key.value();
+        cpu.keyboard_.get().clear_last_pressed();
+      } else {
+        cpu.pc_ -= 2;
+        cpu.waiting_for_key_ = true;
+        cpu.stop_run_ = true;
+      }
+    } else if constexpr (KK == 0x15) {
+      cpu.timer_.get().set_delay(v[X]);
+    } else if constexpr (KK == 0x18) {
+      cpu.timer_.get().set_sound(v[X]);
+      cpu.stop_run_ = cpu.stop_run_ || cpu.stop_on_sound_write_;
+    } else if constexpr (KK == 0x1E) {
+      cpu.I_ += v[X];
+    } else if constexpr (KK == 0x29) {
+      cpu.I_ = v[X] * 5;
+    } else if constexpr (KK == 0x33) {
+      auto &memory = cpu.memory_.get();
+      const uint8_t value = v[X];
+      memory.write_byte(cpu.I_, value / 100);
+      memory.write_byte(cpu.I_ + 1, (value / 10) % 10);
+      memory.write_byte(cpu.I_ + 2, value % 10);
+    } else if constexpr (KK == 0x55) {
+      auto &memory = cpu.memory_.get();
+      for (std::size_t i = 0; i <= X; ++i) {
+        memory.write_byte(cpu.I_ + i, v[i]);
+      }
+      cpu.I_ = static_cast<uint16_t>(cpu.I_ + X + 1);
+    } else if constexpr (KK == 0x65) {
+      auto &memory = cpu.memory_.get();
+      for (std::size_t i = 0; i <= X; ++i) {
+        v[i] = memory.read_byte(cpu.I_ + i);
+      }
+      cpu.I_ = static_cast<uint16_t>(cpu.I_ + X + 1);
+    }
+  }
+
+  // Expands make.operator()<I>() for every I in the sequence into an array,
+  // one handler per operand value.
+  template <typename Make, std::size_t... I>
+  static constexpr std::array<Handler, sizeof...(I)>
+  expand(Make make, std::index_sequence<I...>) {
+    return {make.template operator()<I>()...};
+  }
+
+  template <typename Make> static constexpr auto by_x(Make make) {
+    return expand(make, std::make_index_sequence<NUM_CPU_REGISTERS>{});
+  }
+
+  template <typename Make> static constexpr auto by_xy(Make make) {
+    return expand(make, std::make_index_sequence<NUM_CPU_REGISTERS *
+                                                 NUM_CPU_REGISTERS>{});
+  }
+
+  template <std::size_t N> static constexpr auto alu_by_xy() {
+    return by_xy([]<std::size_t XY>() { return &alu<N, XY / 16, XY % 16>; });
+  }
+
+  template <std::size_t KK> static constexpr auto misc_by_x() {
+    return by_x([]<std::size_t X>() { return &misc<KK, X>; });
+  }
+
+  static constexpr std::array<Handler, 0x10000> make_table() {
+    constexpr auto se_byte_x =
+        by_x([]<std::size_t X>() { return &se_byte<X>; });
+    constexpr auto sne_byte_x =
+        by_x([]<std::size_t X>() { return &sne_byte<X>; });
+    constexpr auto ld_byte_x =
+        by_x([]<std::size_t X>() { return &ld_byte<X>; });
+    constexpr auto add_byte_x =
+        by_x([]<std::size_t X>() { return &add_byte<X>; });
+    constexpr auto rnd_x = by_x([]<std::size_t X>() { return &rnd<X>; });
+    constexpr auto skp_x = by_x([]<std::size_t X>() { return &skp<X>; });
+    constexpr auto sknp_x = by_x([]<std::size_t X>() { return &sknp<X>; });
+    constexpr auto se_reg_xy =
+        by_xy([]<std::size_t XY>() { return &se_reg<XY / 16, XY % 16>; });
+    constexpr auto sne_reg_xy =
+        by_xy([]<std::size_t XY>() { return &sne_reg<XY / 16, XY % 16>; });
+    constexpr auto drw_xy =
+        by_xy([]<std::size_t XY>() { return &drw<XY / 16, XY % 16>; });
+    constexpr std::array<std::array<Handler, 256>, 16> alu_xy{
+        alu_by_xy<0x0>(), alu_by_xy<0x1>(), alu_by_xy<0x2>(),
+        alu_by_xy<0x3>(), alu_by_xy<0x4>(), alu_by_xy<0x5>(),
+        alu_by_xy<0x6>(), alu_by_xy<0x7>(), {},
+        {},               {},               {},
+        {},               {},               alu_by_xy<0xE>(),
+        {}};
+    constexpr std::array<std::pair<uint8_t, std::array<Handler, 16>>, 9>
+        misc_x{{{0x07, misc_by_x<0x07>()},
+                {0x0A, misc_by_x<0x0A>()},
+                {0x15, misc_by_x<0x15>()},
+                {0x18, misc_by_x<0x18>()},
+                {0x1E, misc_by_x<0x1E>()},
+                {0x29, misc_by_x<0x29>()},
+                {0x33, misc_by_x<0x33>()},
+                {0x55, misc_by_x<0x55>()},
+                {0x65, misc_by_x<0x65>()}}};
+
+    std::array<Handler, 0x10000> table{};
+    for (std::size_t opcode = 0; opcode < table.size(); ++opcode) {
+      const std::size_t x = (opcode >> 8) & 0x0F;
+      const std::size_t xy = (opcode >> 4) & 0xFF;
+      const std::size_t n = opcode & 0x000F;
+      const std::size_t kk = opcode & 0x00FF;
+      Handler handler = &nop;
+
+      switch (opcode & 0xF000) {
+      case 0x0000:
+        handler = opcode == 0x00E0 ? &cls : opcode == 0x00EE ? &ret : &sys;
+        break;
+      case 0x1000:
+        handler = &jp;
+        break;
+      case 0x2000:
+        handler = &call;
+        break;
+      case 0x3000:
+        handler = se_byte_x[x];
+        break;
+      case 0x4000:
+        handler = sne_byte_x[x];
+        break;
+      case 0x5000:
+        handler = se_reg_xy[xy];
+        break;
+      case 0x6000:
+        handler = ld_byte_x[x];
+        break;
+      case 0x7000:
+        handler = add_byte_x[x];
+        break;
+      case 0x8000:
+        handler = alu_xy[n][xy] != nullptr ? alu_xy[n][xy] : &nop;
+        break;
+      case 0x9000:
+        handler = sne_reg_xy[xy];
+        break;
+      case 0xA000:
+        handler = &ld_i;
+        break;
+      case 0xB000:
+        handler = &jp_v0;
+        break;
+      case 0xC000:
+        handler = rnd_x[x];
+        break;
+      case 0xD000:
+        handler = drw_xy[xy];
+        break;
+      case 0xE000:
+        handler = kk == 0x9E ? skp_x[x] : kk == 0xA1 ? sknp_x[x] : &nop;
+        break;
+      case 0xF000:
+        for (const auto &[code, handlers] : misc_x) {
+          if (code == kk) {
+            handler = handlers[x];
+          }
+        }
+        break;
+      }
+      table[opcode] = handler;
+    }
+    return table;
+  }
+
+  static const std::array<Handler, 0x10000> table;
+};
+
+template <typename Access, typename Random>
+constexpr std::array<typename BasicCpu<Access, Random>::Handler, 0x10000>
+    BasicCpu<Access, Random>::Ops::table =
+        BasicCpu<Access, Random>::Ops::make_table();
+
+template <typename Access, typename Random>
+BasicCpu<Access, Random>::~BasicCpu() {
+  if (decode_cache_ || jit_) {
+    memory_.get().set_observer(nullptr);
+  }
+#if CHIP8_ENABLE_INSTRUMENTATION
+  ProcessProfile::instance().add(*profiler_);
+#endif
+}
+
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::set_dispatch_mode(DispatchMode mode) {
+  if (mode == DispatchMode::Jit && !Jit::supported()) {
+    throw std::runtime_error("JIT dispatch is not supported on this host.");
+  }
+
+  // Allocate first so a failure leaves the current mode intact.
+  auto decode_cache = mode == DispatchMode::Cached
+                          ? std::make_unique<DecodeCache<Handler>>()
+                          : nullptr;
+  auto jit = mode == DispatchMode::Jit ? std::make_unique<Jit>() : nullptr;
+
+  dispatch_mode_ = mode;
+  decode_cache_ = std::move(decode_cache);
+  jit_ = std::move(jit);
+  memory_.get().set_observer(nullptr);
+  attach_memory_observer();
+}
+
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::attach_memory_observer() noexcept {
+  if (decode_cache_) {
+    decode_cache_->invalidate_all();
+    memory_.get().set_observer(decode_cache_.get());
+  } else if (jit_) {
+    jit_->invalidate_all();
+    memory_.get().set_observer(jit_.get());
+  }
+}
+
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute() {
+  if (dispatch_mode_ == DispatchMode::Cached) {
+    if (pc_ < MEMORY_SIZE) {
+      const auto &entry = decode_cache_->at(pc_);
+      if (entry.handler != nullptr) {
+        pc_ += 2;
+        entry.handler(*this, entry.opcode);
+        return;
+      }
+    }
+
+    const auto opcode = memory_.get().read_two_bytes(pc_);
+    const auto handler = Ops::table[opcode];
+    if (pc_ < MEMORY_SIZE) { // a masked PC may have run off the end
+      decode_cache_->fill(pc_, handler, opcode);
+    }
+    pc_ += 2;
+    handler(*this, opcode);
+    return;
+  }
+
+  if (dispatch_mode_ == DispatchMode::Jit && run_jit(1) != 0) {
+    return;
+  }
+
   const auto opcode = memory_.get().read_two_bytes(pc_);
   pc_ += 2;
 
+  // Table mode, and whatever the JIT hands back to the interpreter.
+  if (dispatch_mode_ != DispatchMode::Switch) {
+    Ops::table[opcode](*this, opcode);
+    return;
+  }
+
   switch (opcode & 0xF000) {
   case 0x0000:
     execute_0(opcode);
@@ -61,22 +497,170 @@ void Cpu::execute() {
   }
 }
 
-void Cpu::reset() noexcept {
+template <typename Access, typename Random>
+uint32_t BasicCpu<Access, Random>::run(uint32_t cycles) {
+  waiting_for_key_ = false;
+  stop_run_ = false;
+  if (dispatch_mode_ != DispatchMode::Jit) {
+    for (uint32_t i = 0; i < cycles; ++i) {
+      step();
+      if (stop_run_) [[unlikely]] {
+        return i + 1;
+      }
+    }
+    return cycles;
+  }
+
+  // Translated blocks contain neither Fx0A nor Fx18.
+  uint32_t done = 0;
+  while (done < cycles) {
+    auto executed = run_jit(cycles - done);
+    if (executed == 0) {
+      const auto opcode = memory_.get().read_two_bytes(pc_);
+#if CHIP8_ENABLE_INSTRUMENTATION
+      const auto start = profiler_->begin(opcode);
+#endif
+      pc_ += 2;
+      Ops::table[opcode](*this, opcode);
+#if CHIP8_ENABLE_INSTRUMENTATION
+      profiler_->end(start);
+#endif
+      if (stop_run_) {
+        return done + 1;
+      }
+      executed = 1;
+    }
+#if CHIP8_ENABLE_INSTRUMENTATION
+    else {
+      profiler_->count_native(executed);
+    }
+#endif
+    done += executed;
+  }
+  return done;
+}
+
+template <typename Access, typename Random>
+uint32_t BasicCpu<Access, Random>::run_skipping_idle(uint32_t cycles) {
+  // Code that keeps turning out busy is probed less and less often.
+  uint32_t interval = IDLE_PROBE_INTERVAL;
+  uint32_t done = 0;
+  while (done < cycles) {
+    const uint32_t chunk = std::min(cycles - done, interval);
+    done += run(chunk);
+    if (stop_run_) {
+      return done;
+    }
+    if (done < cycles) {
+      const uint32_t skipped = skip_idle_loop(cycles - done);
+      done += skipped;
+      if (skipped <= MAX_IDLE_LOOP) { // nothing skipped
+        interval = std::min(interval * 2, MAX_IDLE_PROBE_INTERVAL);
+      }
+    }
+  }
+  return done;
+}
+
+template <typename Access, typename Random>
+uint32_t BasicCpu<Access, Random>::skip_idle_loop(uint32_t cycles) {
+  // Without side effects an iteration is a pure function of the registers,
+  // and the keys and timers are fixed, so one that ends where it started
+  // repeats forever.
+  const uint16_t start = pc_;
+  const auto v = v_;
+  const uint16_t index = I_;
+  const auto memory = memory_.get().span();
+  uint32_t executed = 0;
+  while (executed < cycles && executed < MAX_IDLE_LOOP) {
+    if (pc_ >= MEMORY_SIZE - 1 ||
+        !is_idle_safe(static_cast<uint16_t>(memory[pc_] << 8 |
+                                            memory[pc_ + 1]))) {
+      return executed;
+    }
+    step();
+    ++executed;
+    if (pc_ == start) {
+      break;
+    }
+  }
+  if (pc_ != start || v_ != v || I_ != index) {
+    return executed;
+  }
+  const uint32_t skipped = (cycles - executed) / executed * executed;
+  idle_cycles_skipped_ += skipped;
+  return executed + skipped;
+}
+
+template <typename Access, typename Random>
+uint32_t BasicCpu<Access, Random>::run_jit(uint32_t budget) {
+  Jit::Frame frame{v_.data(), &I_, pc_, budget, 0};
+  if (!jit_->run(memory_.get().span(), frame)) {
+    return 0;
+  }
+  pc_ = frame.pc;
+  return frame.executed;
+}
+
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::reset() noexcept {
   stack_.fill(0);
   v_.fill(0);
   I_ = 0;
   sp_ = 0;
   pc_ = START_ADDRESS;
+  idle_cycles_skipped_ = 0;
+  waiting_for_key_ = false;
+  stop_run_ = false;
+
+  // The owner may have swapped the Memory contents wholesale.
+  attach_memory_observer();
 }
 
-void Cpu::execute_0(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+bool BasicCpu<Access, Random>::key_pressed(uint8_t key) const
+    noexcept(NOEXCEPT) {
+  if constexpr (Access::THROWS) {
+    return keyboard_.get().is_pressed(key);
+  } else {
+    return keyboard_.get().is_pressed(key & (NUM_KEYS - 1));
+  }
+}
+
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::push(uint16_t addr) noexcept(NOEXCEPT) {
+  if constexpr (Access::THROWS) {
+    if (sp_ >= NUM_CPU_STACK) {
+      throw std::out_of_range("Call with a full stack");
+    }
+    stack_[sp_++] = addr;
+  } else {
+    stack_[sp_ & (NUM_CPU_STACK - 1)] = addr;
+    sp_ = (sp_ + 1) & (NUM_CPU_STACK - 1);
+  }
+}
+
+template <typename Access, typename Random>
+uint16_t BasicCpu<Access, Random>::pop() noexcept(NOEXCEPT) {
+  if constexpr (Access::THROWS) {
+    if (sp_ == 0) {
+      throw std::out_of_range("Return with an empty stack");
+    }
+    return stack_[--sp_];
+  } else {
+    sp_ = (sp_ - 1) & (NUM_CPU_STACK - 1);
+    return stack_[sp_];
+  }
+}
+
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_0(uint16_t opcode) noexcept(NOEXCEPT) {
   switch (opcode) {
   case 0x00E0:
     display_.get().clear();
     break;
   case 0x00EE:
-    --sp_;
-    pc_ = stack_[sp_];
+    pc_ = pop();
     break;
   default:
     std::cerr << "[Warning] 0nnn - SYS addr is ignored." << std::endl;
@@ -84,16 +668,20 @@ void Cpu::execute_0(uint16_t opcode) noexcept {
   }
 }
 
-void Cpu::execute_1(uint16_t opcode) noexcept { pc_ = opcode & 0x0FFF; }
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_1(uint16_t opcode) noexcept {
+  pc_ = opcode & 0x0FFF;
+}
 
-void Cpu::execute_2(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_2(uint16_t opcode) noexcept(NOEXCEPT) {
   uint16_t nnn = opcode & 0x0FFF;
-  stack_[sp_] = pc_;
-  ++sp_;
+  push(pc_);
   pc_ = nnn;
 }
 
-void Cpu::execute_3(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_3(uint16_t opcode) noexcept {
   uint8_t x = (opcode >> 8) & 0x0F;
   uint8_t kk = opcode & 0x00FF;
   if (v_[x] == kk) {
@@ -101,7 +689,8 @@ void Cpu::execute_3(uint16_t opcode) noexcept {
   }
 }
 
-void Cpu::execute_4(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_4(uint16_t opcode) noexcept {
   uint8_t x = (opcode >> 8) & 0x0F;
   uint8_t kk = opcode & 0x00FF;
   if (v_[x] != kk) {
@@ -109,7 +698,8 @@ void Cpu::execute_4(uint16_t opcode) noexcept {
   }
 }
 
-void Cpu::execute_5(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_5(uint16_t opcode) noexcept {
   uint8_t x = (opcode >> 8) & 0x0F;
   uint8_t y = (opcode & 0x00F0) >> 4;
   if (v_[x] == v_[y]) {
@@ -117,19 +707,22 @@ void Cpu::execute_5(uint16_t opcode) noexcept {
   }
 }
 
-void Cpu::execute_6(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_6(uint16_t opcode) noexcept {
   uint8_t x = (opcode >> 8) & 0x0F;
   uint8_t kk = opcode & 0x00FF;
   v_[x] = kk;
 }
 
-void Cpu::execute_7(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_7(uint16_t opcode) noexcept {
   uint8_t x = (opcode >> 8) & 0x0F;
   uint8_t kk = opcode & 0x00FF;
   v_[x] += kk;
 }
 
-void Cpu::execute_8(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_8(uint16_t opcode) noexcept {
   uint8_t x = (opcode >> 8) & 0x0F;
   uint8_t y = (opcode & 0x00F0) >> 4;
   uint8_t n = opcode & 0x000F;
@@ -177,7 +770,8 @@ void Cpu::execute_8(uint16_t opcode) noexcept {
   }
 }
 
-void Cpu::execute_9(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_9(uint16_t opcode) noexcept {
   uint8_t x = (opcode >> 8) & 0x0F;
   uint8_t y = (opcode & 0x00F0) >> 4;
   if (v_[x] != v_[y]) {
@@ -185,23 +779,27 @@ void Cpu::execute_9(uint16_t opcode) noexcept {
   }
 }
 
-void Cpu::execute_A(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_A(uint16_t opcode) noexcept {
   uint16_t nnn = opcode & 0x0FFF;
   I_ = nnn;
 }
 
-void Cpu::execute_B(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_B(uint16_t opcode) noexcept {
   uint16_t nnn = opcode & 0x0FFF;
   pc_ = v_[0x00] + nnn;
 }
 
-void Cpu::execute_C(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_C(uint16_t opcode) noexcept {
   uint8_t x = (opcode >> 8) & 0x0F;
   uint8_t kk = opcode & 0x00FF;
   v_[x] = rng_.get().next(kk);
 }
 
-void Cpu::execute_D(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_D(uint16_t opcode) noexcept {
   uint8_t x = (opcode >> 8) & 0x0F;
   uint8_t y = (opcode & 0x00F0) >> 4;
   uint8_t n = opcode & 0x000F;
@@ -222,19 +820,20 @@ void Cpu::execute_D(uint16_t opcode) noexcept {
   v_[0x0F] = display_.get().draw_sprite(v_[x], v_[y], sprite) ? 1 : 0;
 }
 
-void Cpu::execute_E(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_E(uint16_t opcode) noexcept(NOEXCEPT) {
   uint8_t x = (opcode >> 8) & 0x0F;
   uint8_t kk = opcode & 0x00FF;
 
   switch (kk) {
   case 0x9E:
-    if (keyboard_.get().is_pressed(v_[x])) {
+    if (key_pressed(v_[x])) {
       pc_ += 2;
     }
     break;
 
   case 0xA1:
-    if (!keyboard_.get().is_pressed(v_[x])) {
+    if (!key_pressed(v_[x])) {
       pc_ += 2;
     }
     break;
@@ -243,7 +842,8 @@ void Cpu::execute_E(uint16_t opcode) noexcept {
   }
 }
 
-void Cpu::execute_F(uint16_t opcode) noexcept {
+template <typename Access, typename Random>
+void BasicCpu<Access, Random>::execute_F(uint16_t opcode) noexcept(NOEXCEPT) {
   uint8_t x = (opcode >> 8) & 0x0F;
   uint8_t kk = opcode & 0x00FF;
 
@@ -258,6 +858,8 @@ void Cpu::execute_F(uint16_t opcode) noexcept {
       keyboard_.get().clear_last_pressed();
     } else {
       pc_ -= 2;
+      waiting_for_key_ = true;
+      stop_run_ = true;
     }
     break;
   }
@@ -266,6 +868,7 @@ void Cpu::execute_F(uint16_t opcode) noexcept {
     break;
   case 0x18:
     timer_.get().set_sound(v_[x]);
+    stop_run_ = stop_run_ || stop_on_sound_write_;
     break;
   case 0x1E:
     I_ += v_[x];
@@ -300,4 +903,15 @@ void Cpu::execute_F(uint16_t opcode) noexcept {
   }
 }
 
+// Each instantiation carries its own 512 KiB dispatch table, so the
+// RandomGenerator ones, which only tests use, are compiled from this file
+// into chip8_test_cpu instead of chip8_core.
+#if CHIP8_GENERIC_RANDOM_CPU
+template class BasicCpu<CheckedAccess>;
+template class BasicCpu<MaskedAccess>;
+#else
+template class BasicCpu<CheckedAccess, PcgRandom>;
+template class BasicCpu<MaskedAccess, PcgRandom>;
+#endif
+
 } // namespace chip8
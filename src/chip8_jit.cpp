@@ -0,0 +1,442 @@
+#include "chip8_jit.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace chip8 {
+
+namespace {
+
+// Host register assignment inside a block. All of them are caller-saved in
+// both the System V and the Windows x64 ABI, so blocks need no spills:
+//   r8  = Frame*          r9  = &v[0]
+//   r10d = I (cached)     r11d = remaining instruction budget
+//   eax, ecx, edx = scratch
+class Emitter {
+public:
+  void bytes(std::initializer_list<uint8_t> values) {
+    code_.insert(code_.end(), values);
+  }
+
+  void u16(uint16_t value) {
+    bytes({static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8)});
+  }
+
+  void u32(uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+      code_.push_back(static_cast<uint8_t>(value >> shift));
+    }
+  }
+
+  // Emits a rel32 placeholder and returns its position for patch().
+  [[nodiscard]] std::size_t rel32() {
+    const auto pos = code_.size();
+    u32(0);
+    return pos;
+  }
+
+  void patch(std::size_t pos, std::size_t target) {
+    const auto rel = static_cast<int32_t>(static_cast<int64_t>(target) -
+                                          static_cast<int64_t>(pos + 4));
+    std::memcpy(code_.data() + pos, &rel, sizeof(rel));
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return code_.size(); }
+  [[nodiscard]] const std::vector<uint8_t> &code() const noexcept {
+    return code_;
+  }
+
+  // --- Block framing ---
+
+  void prologue() {
+#if defined(_WIN32)
+    bytes({0x49, 0x89, 0xC8}); // mov r8, rcx
+#else
+    bytes({0x49, 0x89, 0xF8}); // mov r8, rdi
+#endif
+    bytes({0x4D, 0x8B, 0x08});       // mov r9, [r8]
+    bytes({0x49, 0x8B, 0x40, 0x08}); // mov rax, [r8 + 8]
+    bytes({0x44, 0x0F, 0xB7, 0x10}); // movzx r10d, word [rax]
+    bytes({0x45, 0x8B, 0x58, 0x14}); // mov r11d, [r8 + 20]
+  }
+
+  void epilogue() {
+    bytes({0x49, 0x8B, 0x40, 0x08}); // mov rax, [r8 + 8]
+    bytes({0x66, 0x44, 0x89, 0x10}); // mov [rax], r10w
+    bytes({0x41, 0x8B, 0x40, 0x14}); // mov eax, [r8 + 20]
+    bytes({0x44, 0x29, 0xD8});       // sub eax, r11d
+    bytes({0x41, 0x89, 0x40, 0x18}); // mov [r8 + 24], eax
+    bytes({0xC3});                   // ret
+  }
+
+  void store_pc(uint16_t pc) {
+    bytes({0x66, 0x41, 0xC7, 0x40, 0x10}); // mov word [r8 + 16], imm16
+    u16(pc);
+  }
+
+  // Exits through the returned patch slot when the budget is exhausted,
+  // otherwise consumes one instruction.
+  [[nodiscard]] std::size_t budget_check() {
+    bytes({0x45, 0x85, 0xDB}); // test r11d, r11d
+    bytes({0x0F, 0x84});       // jz rel32
+    const auto slot = rel32();
+    bytes({0x41, 0xFF, 0xCB}); // dec r11d
+    return slot;
+  }
+
+  [[nodiscard]] std::size_t jmp() {
+    bytes({0xE9});
+    return rel32();
+  }
+
+  [[nodiscard]] std::size_t je() {
+    bytes({0x0F, 0x84});
+    return rel32();
+  }
+
+  [[nodiscard]] std::size_t jne() {
+    bytes({0x0F, 0x85});
+    return rel32();
+  }
+
+  // --- Register file access: [r9 + reg] ---
+
+  void load_al(uint8_t reg) { bytes({0x41, 0x8A, 0x41, reg}); }
+  void store_al(uint8_t reg) { bytes({0x41, 0x88, 0x41, reg}); }
+  void store_cl(uint8_t reg) { bytes({0x41, 0x88, 0x49, reg}); }
+  void store_dl(uint8_t reg) { bytes({0x41, 0x88, 0x51, reg}); }
+  void movzx_eax(uint8_t reg) { bytes({0x41, 0x0F, 0xB6, 0x41, reg}); }
+  void movzx_ecx(uint8_t reg) { bytes({0x41, 0x0F, 0xB6, 0x49, reg}); }
+
+private:
+  std::vector<uint8_t> code_;
+};
+
+[[nodiscard]] bool is_translatable(uint16_t opcode) noexcept {
+  switch (opcode & 0xF000) {
+  case 0x1000:
+  case 0x3000:
+  case 0x4000:
+  case 0x5000:
+  case 0x6000:
+  case 0x7000:
+  case 0x8000:
+  case 0x9000:
+  case 0xA000:
+    return true;
+  case 0xF000:
+    return (opcode & 0x00FF) == 0x1E || (opcode & 0x00FF) == 0x29;
+  default:
+    return false;
+  }
+}
+
+// x86-64 pages, the only kind the JIT runs on.
+constexpr std::size_t CODE_PAGE_SIZE = 4096;
+
+// The buffer starts out writable and never executable; protect_code()
+// flips the pages a block lands on to executable once it is written, so no
+// page is writable and executable at the same time.
+void *allocate_code(std::size_t size) {
+#if defined(_WIN32)
+  return VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+  void *code = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return code == MAP_FAILED ? nullptr : code;
+#endif
+}
+
+// Makes the pages covering [offset, offset + size) of the buffer either
+// writable or executable.
+bool protect_code(uint8_t *code, std::size_t offset, std::size_t size,
+                  bool executable) noexcept {
+  const std::size_t first = offset / CODE_PAGE_SIZE * CODE_PAGE_SIZE;
+  const std::size_t end =
+      (offset + size + CODE_PAGE_SIZE - 1) / CODE_PAGE_SIZE * CODE_PAGE_SIZE;
+#if defined(_WIN32)
+  DWORD previous = 0;
+  if (!VirtualProtect(code + first, end - first,
+                      executable ? PAGE_EXECUTE_READ : PAGE_READWRITE,
+                      &previous)) {
+    return false;
+  }
+  return !executable || FlushInstructionCache(GetCurrentProcess(),
+                                              code + first, end - first);
+#else
+  return mprotect(code + first, end - first,
+                  executable ? PROT_READ | PROT_EXEC
+                             : PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+void free_code(void *code, std::size_t size) noexcept {
+#if defined(_WIN32)
+  (void)size;
+  VirtualFree(code, 0, MEM_RELEASE);
+#else
+  munmap(code, size);
+#endif
+}
+
+} // namespace
+
+Jit::Jit() {
+  if (!supported()) {
+    throw std::runtime_error("JIT is only available on x86-64 hosts.");
+  }
+  code_ = static_cast<uint8_t *>(allocate_code(CODE_SIZE));
+  if (code_ == nullptr) {
+    throw std::runtime_error("Failed to allocate executable memory for JIT.");
+  }
+}
+
+Jit::~Jit() { free_code(code_, CODE_SIZE); }
+
+bool Jit::run(std::span<const uint8_t, MEMORY_SIZE> memory, Frame &frame) {
+  if (frame.pc >= MEMORY_SIZE) {
+    return false;
+  }
+
+  auto &block = blocks_[frame.pc];
+  if (block.state == BlockState::Unknown) {
+    compile(memory, frame.pc);
+  }
+  if (block.state != BlockState::Compiled) {
+    return false;
+  }
+
+  block.fn(&frame);
+  return true;
+}
+
+void Jit::invalidate_all() noexcept {
+  blocks_.fill({});
+  invalidations_.fill(0);
+  code_used_ = 0;
+}
+
+void Jit::on_write(uint16_t addr) noexcept {
+  constexpr uint16_t max_block_bytes = 2 * MAX_BLOCK_INSTRUCTIONS;
+  const uint16_t first = addr > max_block_bytes ? addr - max_block_bytes : 0;
+  for (uint16_t start = first; start <= addr; ++start) {
+    auto &block = blocks_[start];
+    if (block.state == BlockState::Unknown || addr >= block.end) {
+      continue;
+    }
+    // Code stays in the buffer until the next flush; only the entry goes.
+    block = {};
+    if (++invalidations_[start] >= MAX_INVALIDATIONS) {
+      block.state = BlockState::Interpreted;
+      block.end = start; // covers nothing, so it is never revived
+    }
+  }
+}
+
+void Jit::compile(std::span<const uint8_t, MEMORY_SIZE> memory,
+                  uint16_t start) {
+  auto &block = blocks_[start];
+
+  struct Exit {
+    std::size_t slot;
+    uint16_t pc;
+  };
+  std::vector<Exit> exits;
+  Emitter e;
+
+  e.prologue();
+  const auto body = e.size();
+
+  uint16_t pc = start;
+  uint16_t count = 0;
+  while (true) {
+    if (count == MAX_BLOCK_INSTRUCTIONS || pc + 1 >= MEMORY_SIZE) {
+      exits.push_back({e.jmp(), pc});
+      break;
+    }
+
+    const auto opcode =
+        static_cast<uint16_t>(memory[pc] << 8 | memory[pc + 1]);
+    if (!is_translatable(opcode)) {
+      if (count == 0) {
+        block = {nullptr, static_cast<uint16_t>(start + 2),
+                 BlockState::Interpreted};
+        return;
+      }
+      exits.push_back({e.jmp(), pc});
+      break;
+    }
+
+    const uint8_t x = (opcode >> 8) & 0x0F;
+    const uint8_t y = (opcode >> 4) & 0x0F;
+    const uint8_t kk = opcode & 0x00FF;
+    const uint16_t nnn = opcode & 0x0FFF;
+
+    exits.push_back({e.budget_check(), pc});
+    ++count;
+    pc += 2;
+
+    switch (opcode & 0xF000) {
+    case 0x1000:
+      if (nnn == start) {
+        e.patch(e.jmp(), body);
+      } else {
+        exits.push_back({e.jmp(), nnn});
+      }
+      break;
+    case 0x3000:
+      e.bytes({0x41, 0x80, 0x79, x, kk}); // cmp byte [r9 + x], kk
+      exits.push_back({e.je(), static_cast<uint16_t>(pc + 2)});
+      continue;
+    case 0x4000:
+      e.bytes({0x41, 0x80, 0x79, x, kk}); // cmp byte [r9 + x], kk
+      exits.push_back({e.jne(), static_cast<uint16_t>(pc + 2)});
+      continue;
+    case 0x5000:
+    case 0x9000:
+      e.load_al(x);
+      e.bytes({0x41, 0x3A, 0x41, y}); // cmp al, [r9 + y]
+      exits.push_back({(opcode & 0xF000) == 0x5000 ? e.je() : e.jne(),
+                       static_cast<uint16_t>(pc + 2)});
+      continue;
+    case 0x6000:
+      e.bytes({0x41, 0xC6, 0x41, x, kk}); // mov byte [r9 + x], kk
+      continue;
+    case 0x7000:
+      e.bytes({0x41, 0x80, 0x41, x, kk}); // add byte [r9 + x], kk
+      continue;
+    case 0x8000:
+      // Each case mirrors the interpreter's order of reads and writes so
+      // x == F or y == F behave identically.
+      switch (opcode & 0x000F) {
+      case 0x0:
+        e.load_al(y);
+        e.store_al(x);
+        break;
+      case 0x1:
+        e.load_al(y);
+        e.bytes({0x41, 0x08, 0x41, x}); // or [r9 + x], al
+        break;
+      case 0x2:
+        e.load_al(y);
+        e.bytes({0x41, 0x20, 0x41, x}); // and [r9 + x], al
+        break;
+      case 0x3:
+        e.load_al(y);
+        e.bytes({0x41, 0x30, 0x41, x}); // xor [r9 + x], al
+        break;
+      case 0x4:
+        e.movzx_eax(x);
+        e.movzx_ecx(y);
+        e.bytes({0x01, 0xC8});       // add eax, ecx
+        e.bytes({0x89, 0xC2});       // mov edx, eax
+        e.bytes({0xC1, 0xEA, 0x08}); // shr edx, 8
+        e.store_dl(0x0F);
+        e.store_al(x);
+        break;
+      case 0x5:
+        e.movzx_eax(x);
+        e.movzx_ecx(y);
+        e.bytes({0x39, 0xC8});       // cmp eax, ecx
+        e.bytes({0x0F, 0x93, 0xC2}); // setae dl
+        e.store_dl(0x0F);
+        e.load_al(x);
+        e.bytes({0x41, 0x2A, 0x41, y}); // sub al, [r9 + y]
+        e.store_al(x);
+        break;
+      case 0x6:
+        e.load_al(x);
+        e.bytes({0x24, 0x01}); // and al, 1
+        e.store_al(0x0F);
+        e.bytes({0x41, 0xD0, 0x69, x}); // shr byte [r9 + x], 1
+        break;
+      case 0x7:
+        e.movzx_eax(x);
+        e.movzx_ecx(y);
+        e.bytes({0x39, 0xC1});       // cmp ecx, eax
+        e.bytes({0x0F, 0x93, 0xC2}); // setae dl
+        e.store_dl(0x0F);
+        e.bytes({0x29, 0xC1}); // sub ecx, eax
+        e.store_cl(x);
+        break;
+      case 0xE:
+        e.load_al(x);
+        e.bytes({0xC0, 0xE8, 0x07}); // shr al, 7
+        e.store_al(0x0F);
+        e.bytes({0x41, 0xD0, 0x61, x}); // shl byte [r9 + x], 1
+        break;
+      default:
+        break;
+      }
+      continue;
+    case 0xA000:
+      e.bytes({0x41, 0xBA}); // mov r10d, imm32
+      e.u32(nnn);
+      continue;
+    case 0xF000:
+      e.movzx_eax(x);
+      if (kk == 0x1E) {
+        e.bytes({0x41, 0x01, 0xC2}); // add r10d, eax
+        e.bytes({0x41, 0x81, 0xE2}); // and r10d, 0xFFFF
+        e.u32(0xFFFF);
+      } else {
+        e.bytes({0x44, 0x8D, 0x14, 0x80}); // lea r10d, [rax + rax * 4]
+      }
+      continue;
+    default:
+      break;
+    }
+    break; // 1nnn ends the block
+  }
+
+  // One stub per distinct exit address, then the shared epilogue.
+  std::vector<std::pair<uint16_t, std::size_t>> stubs;
+  std::vector<std::size_t> epilogue_jumps;
+  for (const auto &exit : exits) {
+    auto stub = std::ranges::find(stubs, exit.pc,
+                                  &std::pair<uint16_t, std::size_t>::first);
+    if (stub == stubs.end()) {
+      stubs.emplace_back(exit.pc, e.size());
+      e.store_pc(exit.pc);
+      epilogue_jumps.push_back(e.jmp());
+      stub = std::prev(stubs.end());
+    }
+    e.patch(exit.slot, stub->second);
+  }
+  const auto epilogue = e.size();
+  e.epilogue();
+  for (auto jump : epilogue_jumps) {
+    e.patch(jump, epilogue);
+  }
+
+  if (code_used_ + e.size() > CODE_SIZE) {
+    // Out of space: start over. Invalidation counters survive the flush.
+    blocks_.fill({});
+    code_used_ = 0;
+  }
+
+  auto *code = code_ + code_used_;
+  if (!protect_code(code_, code_used_, e.size(), false)) {
+    throw std::runtime_error("Failed to make JIT code writable.");
+  }
+  std::memcpy(code, e.code().data(), e.size());
+  if (!protect_code(code_, code_used_, e.size(), true)) {
+    throw std::runtime_error("Failed to make JIT code executable.");
+  }
+  code_used_ += e.size();
+
+  block = {reinterpret_cast<BlockFn>(code), pc, BlockState::Compiled};
+}
+
+} // namespace chip8
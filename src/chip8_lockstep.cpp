@@ -0,0 +1,426 @@
+#include "chip8_lockstep.h"
+#include "chip8_memory.h"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace chip8 {
+
+LockstepEngine::LockstepEngine(std::size_t lanes, uint32_t cycles_per_frame)
+    : lanes_{lanes}, cycles_per_frame_{cycles_per_frame},
+      v_(NUM_CPU_REGISTERS * lanes), I_(lanes), pc_(lanes, START_ADDRESS),
+      sp_(lanes), stack_(NUM_CPU_STACK * lanes), delay_(lanes), sound_(lanes),
+      keys_(lanes), last_pressed_(lanes, NO_KEY),
+      rows_(SCREEN_HEIGHT * lanes), memory_(MEMORY_SIZE * lanes) {
+  if (lanes == 0) {
+    throw std::invalid_argument("LockstepEngine needs at least one lane.");
+  }
+}
+
+void LockstepEngine::load_rom(std::span<const uint8_t> rom,
+                              std::span<const uint64_t> seeds) {
+  if (rom.empty()) {
+    throw std::invalid_argument("ROM data is empty.");
+  }
+  if (rom.size() > MEMORY_SIZE - START_ADDRESS) {
+    throw std::runtime_error("ROM size exceeds memory capacity.");
+  }
+  if (seeds.size() != lanes_) {
+    throw std::invalid_argument("Need exactly one seed per lane.");
+  }
+
+  std::array<uint8_t, MEMORY_SIZE> image{};
+  std::ranges::copy(DEFAULT_CHAR_SET, image.begin());
+  std::ranges::copy(rom, image.begin() + START_ADDRESS);
+  for (std::size_t lane = 0; lane < lanes_; ++lane) {
+    std::ranges::copy(image, memory_.begin() + lane * MEMORY_SIZE);
+  }
+
+  std::ranges::fill(v_, 0);
+  std::ranges::fill(I_, 0);
+  std::ranges::fill(pc_, START_ADDRESS);
+  std::ranges::fill(sp_, 0);
+  std::ranges::fill(stack_, 0);
+  std::ranges::fill(delay_, 0);
+  std::ranges::fill(sound_, 0);
+  std::ranges::fill(keys_, 0);
+  std::ranges::fill(last_pressed_, NO_KEY);
+  std::ranges::fill(rows_, 0);
+  written_.fill(false);
+  stats_ = {};
+
+  rng_.clear();
+  rng_.reserve(lanes_);
+  for (const uint64_t seed : seeds) {
+    rng_.emplace_back(seed);
+  }
+}
+
+void LockstepEngine::set_key_mask(std::size_t lane, uint16_t mask) noexcept {
+  // Mirrors Keyboard::set_key_mask(): changed keys in ascending order, a
+  // press becomes the pending key, releasing the pending key clears it.
+  const uint16_t changed = keys_[lane] ^ mask;
+  for (uint8_t key = 0; key < NUM_KEYS; ++key) {
+    if ((changed >> key & 1u) == 0) {
+      continue;
+    }
+    if ((mask >> key & 1u) != 0) {
+      last_pressed_[lane] = key;
+    } else if (last_pressed_[lane] == key) {
+      last_pressed_[lane] = NO_KEY;
+    }
+  }
+  keys_[lane] = mask;
+}
+
+void LockstepEngine::run_frame() {
+  if (rng_.empty()) {
+    return; // nothing loaded, like a stopped Emulator
+  }
+  for (uint32_t cycle = 0; cycle < cycles_per_frame_; ++cycle) {
+    step();
+  }
+  for (std::size_t lane = 0; lane < lanes_; ++lane) {
+    delay_[lane] -= delay_[lane] > 0;
+    sound_[lane] -= sound_[lane] > 0;
+  }
+}
+
+std::array<uint8_t, NUM_CPU_REGISTERS>
+LockstepEngine::registers(std::size_t lane) const noexcept {
+  std::array<uint8_t, NUM_CPU_REGISTERS> v{};
+  for (std::size_t x = 0; x < NUM_CPU_REGISTERS; ++x) {
+    v[x] = v_[x * lanes_ + lane];
+  }
+  return v;
+}
+
+std::optional<uint8_t>
+LockstepEngine::last_pressed(std::size_t lane) const noexcept {
+  if (last_pressed_[lane] == NO_KEY) {
+    return std::nullopt;
+  }
+  return last_pressed_[lane];
+}
+
+void LockstepEngine::step() {
+  std::size_t begin = 0;
+  while (begin < lanes_) {
+    const uint16_t pc = pc_[begin];
+    const uint16_t opcode = fetch(begin, pc);
+    const bool shared_code = !written_[DefaultAccess::address(pc)] &&
+                             !written_[DefaultAccess::address(pc + 1)];
+
+    std::size_t end = begin + 1;
+    while (end < lanes_ && pc_[end] == pc &&
+           (shared_code || fetch(end, pc) == opcode)) {
+      ++end;
+    }
+
+    const auto next = static_cast<uint16_t>(pc + 2);
+    std::fill(pc_.begin() + begin, pc_.begin() + end, next);
+    execute(opcode, begin, end);
+
+    if (begin == 0 && end == lanes_) {
+      ++stats_.lockstep_cycles;
+    } else if (begin == 0) {
+      ++stats_.divergent_cycles;
+    }
+    begin = end;
+  }
+}
+
+uint16_t LockstepEngine::fetch(std::size_t lane, uint16_t pc) const {
+  const uint8_t *memory = memory_.data() + lane * MEMORY_SIZE;
+  return static_cast<uint16_t>(memory[DefaultAccess::address(pc)] << 8 |
+                               memory[DefaultAccess::address(pc + 1)]);
+}
+
+void LockstepEngine::write_memory(std::size_t lane, uint16_t addr,
+                                  uint8_t value) {
+  addr = DefaultAccess::address(addr);
+  memory_[lane * MEMORY_SIZE + addr] = value;
+  written_[addr] = true;
+}
+
+void LockstepEngine::execute(uint16_t opcode, std::size_t begin,
+                             std::size_t end) {
+  const std::size_t x = (opcode >> 8) & 0x0F;
+  const std::size_t y = (opcode >> 4) & 0x0F;
+  const auto kk = static_cast<uint8_t>(opcode & 0x00FF);
+  const auto nnn = static_cast<uint16_t>(opcode & 0x0FFF);
+  uint8_t *vx = reg(x);
+  uint8_t *vy = reg(y);
+  uint16_t *pc = pc_.data();
+
+  switch (opcode >> 12) {
+  case 0x0:
+    if (opcode == 0x00E0) {
+      std::fill(rows_.begin() + begin * SCREEN_HEIGHT,
+                rows_.begin() + end * SCREEN_HEIGHT, 0);
+    } else if (opcode == 0x00EE) {
+      for (std::size_t lane = begin; lane < end; ++lane) {
+        if constexpr (DefaultAccess::THROWS) {
+          if (sp_[lane] == 0) {
+            throw std::out_of_range("Return with an empty stack");
+          }
+          --sp_[lane];
+        } else {
+          sp_[lane] = (sp_[lane] - 1) & (NUM_CPU_STACK - 1);
+        }
+        pc[lane] = stack_[lane * NUM_CPU_STACK + sp_[lane]];
+      }
+    }
+    break; // 0nnn is ignored
+  case 0x1:
+    std::fill(pc_.begin() + begin, pc_.begin() + end, nnn);
+    break;
+  case 0x2:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      if constexpr (DefaultAccess::THROWS) {
+        if (sp_[lane] == NUM_CPU_STACK) {
+          throw std::out_of_range("Call with a full stack");
+        }
+        stack_[lane * NUM_CPU_STACK + sp_[lane]++] = pc[lane];
+      } else {
+        stack_[lane * NUM_CPU_STACK + sp_[lane]] = pc[lane];
+        sp_[lane] = (sp_[lane] + 1) & (NUM_CPU_STACK - 1);
+      }
+      pc[lane] = nnn;
+    }
+    break;
+  case 0x3:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      pc[lane] += vx[lane] == kk ? 2 : 0;
+    }
+    break;
+  case 0x4:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      pc[lane] += vx[lane] != kk ? 2 : 0;
+    }
+    break;
+  case 0x5:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      pc[lane] += vx[lane] == vy[lane] ? 2 : 0;
+    }
+    break;
+  case 0x6:
+    std::fill(vx + begin, vx + end, kk);
+    break;
+  case 0x7:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      vx[lane] = static_cast<uint8_t>(vx[lane] + kk);
+    }
+    break;
+  case 0x8:
+    execute_8(opcode, begin, end);
+    break;
+  case 0x9:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      pc[lane] += vx[lane] != vy[lane] ? 2 : 0;
+    }
+    break;
+  case 0xA:
+    std::fill(I_.begin() + begin, I_.begin() + end, nnn);
+    break;
+  case 0xB: {
+    const uint8_t *v0 = reg(0);
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      pc[lane] = static_cast<uint16_t>(v0[lane] + nnn);
+    }
+    break;
+  }
+  case 0xC:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      vx[lane] = rng_[lane].next(kk);
+    }
+    break;
+  case 0xD:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      draw(opcode, lane);
+    }
+    break;
+  case 0xE:
+    if (kk != 0x9E && kk != 0xA1) {
+      break;
+    }
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      if (DefaultAccess::THROWS && vx[lane] >= NUM_KEYS) {
+        throw std::out_of_range("Keyboard key out of range\n");
+      }
+      const auto key = vx[lane] & (NUM_KEYS - 1);
+      const bool pressed = (keys_[lane] >> key & 1u) != 0;
+      pc[lane] += pressed == (kk == 0x9E) ? 2 : 0;
+    }
+    break;
+  case 0xF:
+    execute_F(opcode, begin, end);
+    break;
+  default:
+    break;
+  }
+}
+
+void LockstepEngine::execute_8(uint16_t opcode, std::size_t begin,
+                               std::size_t end) {
+  // Statement order follows Cpu::execute_8 exactly: when x or y is 0xF the
+  // flag write is visible to, or overwritten by, the result.
+  uint8_t *vx = reg((opcode >> 8) & 0x0F);
+  const uint8_t *vy = reg((opcode >> 4) & 0x0F);
+  uint8_t *vf = reg(0x0F);
+
+  switch (opcode & 0x000F) {
+  case 0x0:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      vx[lane] = vy[lane];
+    }
+    break;
+  case 0x1:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      vx[lane] |= vy[lane];
+    }
+    break;
+  case 0x2:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      vx[lane] &= vy[lane];
+    }
+    break;
+  case 0x3:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      vx[lane] ^= vy[lane];
+    }
+    break;
+  case 0x4:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      const unsigned sum = vx[lane] + vy[lane];
+      vf[lane] = sum > 0xFFu ? 1 : 0;
+      vx[lane] = static_cast<uint8_t>(sum);
+    }
+    break;
+  case 0x5:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      vf[lane] = vx[lane] >= vy[lane] ? 1 : 0;
+      vx[lane] = static_cast<uint8_t>(vx[lane] - vy[lane]);
+    }
+    break;
+  case 0x6:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      vf[lane] = vx[lane] & 1u;
+      vx[lane] = static_cast<uint8_t>(vx[lane] >> 1);
+    }
+    break;
+  case 0x7:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      const uint8_t original_vx = vx[lane];
+      const uint8_t original_vy = vy[lane];
+      vf[lane] = original_vy >= original_vx ? 1 : 0;
+      vx[lane] = static_cast<uint8_t>(original_vy - original_vx);
+    }
+    break;
+  case 0xE:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      vf[lane] = (vx[lane] & 0x80u) != 0 ? 1 : 0;
+      vx[lane] = static_cast<uint8_t>(vx[lane] << 1);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void LockstepEngine::execute_F(uint16_t opcode, std::size_t begin,
+                               std::size_t end) {
+  const std::size_t x = (opcode >> 8) & 0x0F;
+  uint8_t *vx = reg(x);
+  uint16_t *index = I_.data();
+
+  switch (opcode & 0x00FF) {
+  case 0x07:
+    std::copy(delay_.begin() + begin, delay_.begin() + end, vx + begin);
+    break;
+  case 0x0A:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      if (last_pressed_[lane] != NO_KEY) {
+        vx[lane] = last_pressed_[lane];
+        last_pressed_[lane] = NO_KEY;
+      } else {
+        pc_[lane] -= 2;
+      }
+    }
+    break;
+  case 0x15:
+    std::copy(vx + begin, vx + end, delay_.begin() + begin);
+    break;
+  case 0x18:
+    std::copy(vx + begin, vx + end, sound_.begin() + begin);
+    break;
+  case 0x1E:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      index[lane] = static_cast<uint16_t>(index[lane] + vx[lane]);
+    }
+    break;
+  case 0x29:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      index[lane] = static_cast<uint16_t>(vx[lane] * 5);
+    }
+    break;
+  case 0x33:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      const uint8_t value = vx[lane];
+      write_memory(lane, index[lane], value / 100);
+      write_memory(lane, static_cast<uint16_t>(index[lane] + 1),
+                   (value / 10) % 10);
+      write_memory(lane, static_cast<uint16_t>(index[lane] + 2), value % 10);
+    }
+    break;
+  case 0x55:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      for (std::size_t i = 0; i <= x; ++i) {
+        write_memory(lane, static_cast<uint16_t>(index[lane] + i),
+                     v_[i * lanes_ + lane]);
+      }
+      index[lane] = static_cast<uint16_t>(index[lane] + x + 1);
+    }
+    break;
+  case 0x65:
+    for (std::size_t lane = begin; lane < end; ++lane) {
+      const uint8_t *memory = memory_.data() + lane * MEMORY_SIZE;
+      for (std::size_t i = 0; i <= x; ++i) {
+        const auto addr = static_cast<uint16_t>(index[lane] + i);
+        v_[i * lanes_ + lane] = memory[DefaultAccess::address(addr)];
+      }
+      index[lane] = static_cast<uint16_t>(index[lane] + x + 1);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void LockstepEngine::draw(uint16_t opcode, std::size_t lane) {
+  // Same clipping as Cpu::execute_D and wrapping as Display::draw_sprite.
+  uint8_t &vf = v_[0x0F * lanes_ + lane];
+  const uint16_t index = I_[lane];
+  const std::size_t n = opcode & 0x000F;
+  if (index >= MEMORY_SIZE || n == 0) {
+    vf = 0;
+    return;
+  }
+
+  const std::size_t rows = std::min<std::size_t>(n, MEMORY_SIZE - index);
+  const uint8_t *sprite = memory_.data() + lane * MEMORY_SIZE + index;
+  const int nx = v_[((opcode >> 8) & 0x0F) * lanes_ + lane] % SCREEN_WIDTH;
+  const int ny = v_[((opcode >> 4) & 0x0F) * lanes_ + lane] % SCREEN_HEIGHT;
+  uint64_t *screen = rows_.data() + lane * SCREEN_HEIGHT;
+
+  uint64_t collision = 0;
+  for (std::size_t row = 0; row < rows; ++row) {
+    const uint64_t bits = std::rotr(uint64_t{sprite[row]} << 56, nx);
+    uint64_t &line = screen[(ny + row) % SCREEN_HEIGHT];
+    collision |= line & bits;
+    line ^= bits;
+  }
+  vf = collision != 0 ? 1 : 0;
+}
+
+} // namespace chip8
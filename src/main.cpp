@@ -1,21 +1,138 @@
 #define SDL_MAIN_HANDLED 1
 #include "SDL2/SDL.h"
 #include "chip8_emulator.h"
+#include "fast_forward.h"
+#include "frame_handoff.h"
+#include "frame_pacer.h"
+#include "input_movie.h"
 #include "sdl_audio.h"
 #include "sdl_display.h"
 #include "sdl_input.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <exception>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <optional>
+#include <string>
 #include <thread>
+#include <vector>
+
+namespace {
+
+constexpr const char *WINDOW_TITLE = "CHIP8 Emulator";
+
+struct Options {
+  std::filesystem::path rom;
+  std::optional<std::filesystem::path> movie;
+  // Frames per displayed frame while fast-forwarding, 0 = as many as fit.
+  uint32_t turbo_multiplier = chip8::FastForward::UNLIMITED;
+  bool turbo = false;
+  chip8::LatePolicy late_policy = chip8::LatePolicy::CatchUp;
+  uint16_t audio_buffer_samples = chip8::AudioConfig{}.buffer_samples;
+};
+
+// What the emulation thread hands the renderer after each displayed frame.
+struct Frame {
+  std::array<uint64_t, chip8::SCREEN_HEIGHT> rows{};
+  uint64_t sequence{}; // counts published frames, for spotting dropped ones
+  std::chrono::steady_clock::time_point published{};
+  bool fast_forward{};
+  double speed{}; // while fast-forwarding, 0 until first measured
+};
+
+// Passes the buzzer changes run_frame() reports on to SdlAudio, stamped
+// with the emulated frame and the position in it of the Fx18 or timer tick
+// behind them. Emulation thread only.
+class SdlBeepSink final : public chip8::BeepSink {
+public:
+  explicit SdlBeepSink(chip8::SdlAudio &audio) noexcept : audio_{audio} {}
+
+  void beep(float offset, bool on) override {
+    on_ = on;
+    if (!muted_) {
+      audio_.beep(frame_, on, offset);
+    }
+  }
+
+  void end_frame() override { ++frame_; }
+
+  // Silences the buzzer without losing track of it.
+  void set_muted(bool muted) noexcept {
+    muted_ = muted;
+    audio_.beep(frame_, on_ && !muted_);
+  }
+
+private:
+  chip8::SdlAudio &audio_;
+  uint64_t frame_{};
+  bool on_{};
+  bool muted_{};
+};
+
+std::optional<Options> parse_options(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg{argv[i]};
+    if (arg == "--record" && i + 1 < argc) {
+      options.movie = argv[++i];
+    } else if (arg == "--turbo" && i + 1 < argc) {
+      try {
+        options.turbo_multiplier =
+            static_cast<uint32_t>(std::stoul(argv[++i]));
+      } catch (const std::exception &) {
+        return std::nullopt;
+      }
+      options.turbo = true;
+    } else if (arg == "--audio-buffer" && i + 1 < argc) {
+      try {
+        const unsigned long samples = std::stoul(argv[++i]);
+        if (samples == 0 || samples > 0xFFFF) {
+          return std::nullopt;
+        }
+        options.audio_buffer_samples = static_cast<uint16_t>(samples);
+      } catch (const std::exception &) {
+        return std::nullopt;
+      }
+    } else if (arg == "--skip-late") {
+      options.late_policy = chip8::LatePolicy::Skip;
+    } else if (options.rom.empty() && !arg.starts_with("--")) {
+      options.rom = arg;
+    } else {
+      return std::nullopt;
+    }
+  }
+  if (options.rom.empty()) {
+    return std::nullopt;
+  }
+  return options;
+}
+
+} // namespace
 
 int main(int argc, char **argv) {
-  if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <path-to-rom>\n";
+  const auto options = parse_options(argc, argv);
+  if (!options) {
+    std::cerr << "Usage: " << argv[0]
+              << " <path-to-rom> [--record <movie-file>] [--turbo N]"
+                 " [--skip-late] [--audio-buffer SAMPLES]\n"
+                 "--turbo starts fast-forwarding at N times speed, 0 for as"
+                 " fast as possible;\nTab toggles fast-forward while"
+                 " running.\n"
+                 "--skip-late drops frames the host fell behind on instead"
+                 " of catching up.\n"
+                 "--audio-buffer sets the sound device buffer (default 512"
+                 " samples).\n";
     return 1;
   }
 
-  const std::filesystem::path rom_path{argv[1]};
+  const std::filesystem::path &rom_path = options->rom;
+  const std::optional<std::filesystem::path> &movie_path = options->movie;
 
   if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
     std::cerr << "SDL initialization failed: " << SDL_GetError() << '\n';
@@ -23,49 +140,205 @@ int main(int argc, char **argv) {
   }
 
   try {
+    std::ifstream rom_file(rom_path, std::ios::binary);
+    if (!rom_file) {
+      throw std::runtime_error("Failed to open ROM file: " +
+                               rom_path.string());
+    }
+    const std::vector<uint8_t> rom{std::istreambuf_iterator<char>(rom_file),
+                                   std::istreambuf_iterator<char>()};
+
     chip8::Emulator emulator;
-    emulator.load_rom(rom_path);
+    emulator.enable_rewind();
+    emulator.load_rom(rom);
+
+    std::optional<chip8::MovieRecorder> recorder;
+    if (movie_path) {
+      recorder.emplace(emulator, rom);
+    }
 
+    // Events and presenting stay on this thread, the one that created the
+    // window, as SDL requires on some platforms; emulation gets its own.
     chip8::SdlDisplay display{10};
-    chip8::SdlAudio audio;
-    chip8::SdlInput input{emulator.keyboard()};
-
-    bool running = true;
-    constexpr auto frame_duration = std::chrono::milliseconds(16);
-
-    while (running) {
-      const auto frame_start = std::chrono::steady_clock::now();
-
-      SDL_Event event{};
-      while (SDL_PollEvent(&event)) {
-        if (event.type == SDL_QUIT) {
-          running = false;
-        } else if (event.type == SDL_KEYDOWN &&
-                   event.key.keysym.sym == SDLK_ESCAPE) {
-          running = false;
-        } else {
-          input.handle_event(event);
+    chip8::SdlAudio audio{chip8::AudioConfig{
+        .buffer_samples = options->audio_buffer_samples}};
+    chip8::Keyboard keyboard;
+    chip8::SdlInput input{keyboard};
+    SdlBeepSink beeps{audio};
+    emulator.set_beep_sink(&beeps);
+
+    std::atomic<bool> running{true};
+    // Written by the event loop, read by the emulation thread every frame.
+    std::atomic<uint16_t> held_keys{0};
+    std::atomic<bool> rewinding{false}; // while Backspace is held
+    std::atomic<bool> fast_forwarding{options->turbo};
+    chip8::TripleBuffer<Frame> frames;
+
+    // Emulation paces itself and never waits for the renderer; vsync only
+    // holds up presenting.
+    chip8::SteadyPacerClock clock;
+    chip8::PacerConfig pacing;
+    pacing.late_policy = options->late_policy;
+    chip8::FramePacer pacer{clock, pacing};
+    std::exception_ptr emulation_error;
+
+    std::thread emulation{[&] {
+      try {
+        chip8::FastForward fast_forward{options->turbo_multiplier};
+        chip8::SpeedMeter speed;
+        uint32_t frames_due = 1;
+        uint64_t sequence = 0;
+        while (running.load(std::memory_order_relaxed)) {
+          emulator.keyboard().set_key_mask(
+              held_keys.load(std::memory_order_relaxed));
+          const bool fast = fast_forwarding.load(std::memory_order_relaxed);
+          if (fast != fast_forward.active()) {
+            fast_forward.set_active(fast);
+            speed.restart();
+          }
+
+          // A sped-up or rewound beep is just noise.
+          const bool rewind = rewinding.load(std::memory_order_relaxed);
+          beeps.set_muted(fast || rewind);
+          if (rewind) {
+            const uint32_t rewound = emulator.rewind();
+            if (recorder) {
+              recorder->drop_last(rewound);
+            }
+          } else {
+            const auto run_frame = [&] {
+              if (recorder) {
+                recorder->record(emulator.keyboard());
+              }
+              emulator.run_frame();
+            };
+            uint32_t run = 0;
+            if (fast) {
+              // Stops short of the deadline the pacer would spin out.
+              run = fast_forward.step(
+                  run_frame,
+                  std::chrono::time_point_cast<
+                      chip8::FastForward::Clock::duration>(
+                      pacer.next_deadline() - pacing.spin_threshold));
+              speed.count(run, std::chrono::steady_clock::now());
+            } else {
+              // More than one when catching up on frames the host was late
+              // for.
+              for (; run < frames_due; ++run) {
+                run_frame();
+              }
+            }
+          }
+
+          ++sequence;
+
+          // Only the newest of the frames run is shown.
+          Frame &frame = frames.back();
+          std::ranges::copy(emulator.display().rows(), frame.rows.begin());
+          frame.sequence = sequence;
+          frame.fast_forward = fast;
+          frame.speed = fast ? speed.speed().value_or(0.0) : 0.0;
+          frame.published = std::chrono::steady_clock::now();
+          frames.publish();
+
+          frames_due = pacer.wait();
         }
+      } catch (...) {
+        emulation_error = std::current_exception();
+        running.store(false);
       }
+    }};
 
-      const auto frame_result = emulator.run_frame();
-      display.render(emulator.display());
+    chip8::Display shown;
+    chip8::LatencyHistogram latency;
+    uint64_t shown_sequence = 0;
+    uint64_t frames_dropped = 0;
+    bool shown_fast_forward = false;
+    double shown_speed = 0.0;
 
-      if (frame_result.sound_active) {
-        audio.play();
-      } else {
-        audio.stop();
+    const auto present = [&] {
+      if (!frames.update()) {
+        return false;
       }
+      const Frame &frame = frames.front();
+      frames_dropped += frame.sequence - shown_sequence - 1;
+      shown_sequence = frame.sequence;
 
-      const auto frame_end = std::chrono::steady_clock::now();
-      const auto elapsed = frame_end - frame_start;
-      if (elapsed < frame_duration) {
-        std::this_thread::sleep_for(frame_duration - elapsed);
+      if (frame.fast_forward != shown_fast_forward ||
+          frame.speed != shown_speed) {
+        shown_fast_forward = frame.fast_forward;
+        shown_speed = frame.speed;
+        char title[64];
+        std::snprintf(title, sizeof(title), "%s - fast-forward %.1fx",
+                      WINDOW_TITLE, shown_speed);
+        display.set_title(shown_fast_forward && shown_speed > 0.0
+                              ? title
+                              : WINDOW_TITLE);
       }
+
+      // Rows that match the previous frame are not uploaded again.
+      shown.restore(frame.rows);
+      display.render(shown);
+      latency.record(std::chrono::steady_clock::now() - frame.published);
+      return true;
+    };
+
+    try {
+      while (running.load(std::memory_order_relaxed)) {
+        SDL_Event event{};
+        while (SDL_PollEvent(&event)) {
+          if (event.type == SDL_QUIT) {
+            running.store(false);
+          } else if (event.type == SDL_KEYDOWN &&
+                     event.key.keysym.sym == SDLK_ESCAPE) {
+            running.store(false);
+          } else if ((event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) &&
+                     event.key.keysym.scancode == SDL_SCANCODE_BACKSPACE) {
+            rewinding.store(event.type == SDL_KEYDOWN);
+          } else if (event.type == SDL_KEYDOWN && event.key.repeat == 0 &&
+                     event.key.keysym.scancode == SDL_SCANCODE_TAB) {
+            fast_forwarding.store(!fast_forwarding.load());
+          } else {
+            input.handle_event(event);
+          }
+        }
+        held_keys.store(keyboard.key_mask(), std::memory_order_relaxed);
+
+        if (!present()) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+    } catch (...) {
+      running.store(false);
+      emulation.join();
+      throw;
+    }
+    emulation.join();
+    if (emulation_error) {
+      std::rethrow_exception(emulation_error);
     }
 
+    if (recorder) {
+      std::ofstream movie_file(*movie_path, std::ios::binary);
+      chip8::write_movie(movie_file, recorder->finish(emulator));
+    }
+
+    const auto micros = [](std::chrono::nanoseconds duration) {
+      return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+          .count();
+    };
+    const auto &stats = pacer.stats();
+    std::cerr << "Pacing: " << stats.frames << " frames, lateness mean "
+              << micros(stats.mean_lateness()) << " us, max "
+              << micros(stats.max_lateness) << " us, " << stats.late_frames
+              << " late, " << stats.skipped_frames << " skipped\n"
+              << "Emulation to present: " << latency.count()
+              << " frames, mean " << micros(latency.mean()) << " us, p99 "
+              << micros(latency.percentile(0.99)) << " us, max "
+              << micros(latency.max()) << " us, " << frames_dropped
+              << " never shown\n";
+
     emulator.stop();
-    audio.stop();
   } catch (const std::exception &ex) {
     std::cerr << "Fatal error: " << ex.what() << '\n';
     SDL_Quit();
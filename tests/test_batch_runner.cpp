@@ -0,0 +1,108 @@
+#include "batch_runner.h"
+#include "work_stealing_pool.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Draws the digits 0-9 along the top row, then parks on a jump to itself.
+std::shared_ptr<const std::vector<uint8_t>> make_counting_rom() {
+  return std::make_shared<const std::vector<uint8_t>>(std::vector<uint8_t>{
+      0x60, 0x00, // 0x200: LD V0, 0
+      0x61, 0x00, // 0x202: LD V1, 0
+      0xF0, 0x29, // 0x204: LD F, V0
+      0xD0, 0x15, // 0x206: DRW V0, V1, 5
+      0x70, 0x01, // 0x208: ADD V0, 1
+      0x30, 0x0A, // 0x20A: SE V0, 10
+      0x12, 0x04, // 0x20C: JP 0x204
+      0x12, 0x0E, // 0x20E: JP 0x20E
+  });
+}
+
+// Never halts: keeps drawing random bytes at random positions.
+std::shared_ptr<const std::vector<uint8_t>> make_noise_rom() {
+  return std::make_shared<const std::vector<uint8_t>>(std::vector<uint8_t>{
+      0xC0, 0x3F, // 0x200: RND V0, 0x3F
+      0xC1, 0x1F, // 0x202: RND V1, 0x1F
+      0xA2, 0x00, // 0x204: LD I, 0x200
+      0xD0, 0x13, // 0x206: DRW V0, V1, 3
+      0x12, 0x00, // 0x208: JP 0x200
+  });
+}
+
+std::vector<chip8::BatchJob> make_jobs() {
+  std::vector<chip8::BatchJob> jobs;
+  const auto counting = make_counting_rom();
+  const auto noise = make_noise_rom();
+  for (uint32_t i = 0; i < 16; ++i) {
+    jobs.push_back({"counting", counting, 100, 10 + i});
+    jobs.push_back({"noise", noise, 50 + i, 10});
+  }
+  return jobs;
+}
+
+} // namespace
+
+TEST(WorkStealingPoolTest, ParallelForVisitsEveryIndexOnce) {
+  chip8::WorkStealingPool pool{4};
+  std::vector<std::atomic<int>> visits(1000);
+
+  pool.parallel_for(visits.size(), [&](std::size_t i) { ++visits[i]; });
+  pool.parallel_for(visits.size(), [&](std::size_t i) { ++visits[i]; });
+
+  for (const auto &count : visits) {
+    EXPECT_EQ(count.load(), 2);
+  }
+}
+
+TEST(WorkStealingPoolTest, ParallelForRethrowsJobException) {
+  chip8::WorkStealingPool pool{2};
+  EXPECT_THROW(pool.parallel_for(10,
+                                 [](std::size_t i) {
+                                   if (i == 7) {
+                                     throw std::runtime_error("boom");
+                                   }
+                                 }),
+               std::runtime_error);
+}
+
+TEST(BatchRunnerTest, HaltedRomStopsBeforeFrameLimit) {
+  chip8::BatchJob job{"counting", make_counting_rom(), 1000, 10};
+  const auto result = chip8::run_batch_job(job);
+
+  EXPECT_EQ(result.stop_reason, chip8::BatchStopReason::Halted);
+  EXPECT_LT(result.frames_run, 1000u);
+  EXPECT_EQ(result.program_counter, 0x20Eu);
+}
+
+TEST(BatchRunnerTest, EmptyRomIsReportedAsError) {
+  chip8::BatchJob job{"empty", std::make_shared<const std::vector<uint8_t>>(),
+                      10, 10};
+  const auto result = chip8::run_batch_job(job);
+
+  EXPECT_EQ(result.stop_reason, chip8::BatchStopReason::Error);
+  EXPECT_FALSE(result.error.empty());
+}
+
+TEST(BatchRunnerTest, ResultsAreIdenticalAcrossThreadCounts) {
+  const auto jobs = make_jobs();
+
+  chip8::WorkStealingPool single{1};
+  const auto expected = chip8::run_batch(jobs, single);
+
+  for (std::size_t threads : {2u, 3u, 8u}) {
+    chip8::WorkStealingPool pool{threads};
+    const auto results = chip8::run_batch(jobs, pool);
+    ASSERT_EQ(results.size(), expected.size());
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      EXPECT_EQ(results[i].frames_run, expected[i].frames_run);
+      EXPECT_EQ(results[i].cycles_run, expected[i].cycles_run);
+      EXPECT_EQ(results[i].program_counter, expected[i].program_counter);
+      EXPECT_EQ(results[i].display_hash, expected[i].display_hash);
+      EXPECT_EQ(results[i].stop_reason, expected[i].stop_reason);
+    }
+  }
+}
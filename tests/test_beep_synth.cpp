@@ -0,0 +1,146 @@
+#include "beep_synth.h"
+#include "spsc_queue.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 600 samples per frame keeps the arithmetic exact.
+constexpr chip8::SynthConfig CONFIG{.sample_rate = 36000,
+                                    .frames_per_second = 60.0,
+                                    .frequency = 450.0,
+                                    .volume = 0.5f,
+                                    .max_lead_frames = 2.0};
+
+// Index of the first sample that is not silent, or the size if none is.
+std::size_t first_sound(const std::vector<float> &samples) {
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    if (samples[i] != 0.0f) {
+      return i;
+    }
+  }
+  return samples.size();
+}
+
+} // namespace
+
+TEST(SpscQueueTest, PushesAndPopsInOrderUpToCapacity) {
+  chip8::SpscQueue<int> queue{3};
+  EXPECT_EQ(queue.capacity(), 4u);
+  EXPECT_FALSE(queue.front().has_value());
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.try_push(i));
+  }
+  EXPECT_FALSE(queue.try_push(4));
+  EXPECT_EQ(queue.front(), 0);
+
+  int value = -1;
+  EXPECT_TRUE(queue.try_pop(value));
+  EXPECT_EQ(value, 0);
+  EXPECT_TRUE(queue.try_push(4)); // wraps around
+  for (int expected = 1; expected <= 4; ++expected) {
+    ASSERT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, expected);
+  }
+  EXPECT_FALSE(queue.try_pop(value));
+}
+
+TEST(SpscQueueTest, CrossesThreadsInOrder) {
+  constexpr uint32_t COUNT = 200'000;
+  chip8::SpscQueue<uint32_t> queue{64};
+  std::thread producer{[&] {
+    for (uint32_t i = 0; i < COUNT; ++i) {
+      while (!queue.try_push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  }};
+  uint32_t expected = 0;
+  while (expected < COUNT) {
+    uint32_t value = 0;
+    if (queue.try_pop(value)) {
+      ASSERT_EQ(value, expected);
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+}
+
+TEST(BeepSynthTest, SilentUntilAnEventTurnsTheBeepOn) {
+  chip8::BeepSynth synth{CONFIG};
+  chip8::SpscQueue<chip8::BeepEvent> events{8};
+  std::vector<float> block(256, 1.0f);
+  synth.render(block, events);
+  EXPECT_EQ(first_sound(block), block.size());
+  EXPECT_EQ(synth.samples_rendered(), 256u);
+}
+
+TEST(BeepSynthTest, WavetableFollowsASine) {
+  chip8::BeepSynth synth{CONFIG};
+  chip8::SpscQueue<chip8::BeepEvent> events{8};
+  events.try_push({0, 0.0f, true});
+  std::vector<float> block(CONFIG.sample_rate / 10);
+  synth.render(block, events);
+
+  // The first event plays at once and starts on a zero crossing.
+  EXPECT_EQ(block[0], 0.0f);
+  const double step = 2.0 * std::numbers::pi * CONFIG.frequency /
+                      CONFIG.sample_rate;
+  for (std::size_t i = 0; i < block.size(); ++i) {
+    // One table entry is 2 pi / 1024 wide.
+    ASSERT_NEAR(block[i], CONFIG.volume * std::sin(step * i),
+                CONFIG.volume * 2.0 * std::numbers::pi / 1024)
+        << "sample " << i;
+  }
+}
+
+TEST(BeepSynthTest, EventsLandOnTheirFrameRelativeSamples) {
+  chip8::BeepSynth synth{CONFIG};
+  chip8::SpscQueue<chip8::BeepEvent> events{8};
+  events.try_push({10, 0.0f, true});  // anchors at sample 0
+  events.try_push({10, 0.5f, false}); // half a frame later: 300
+  events.try_push({11, 0.25f, true}); // 600 + 150 = 750, next block
+  std::vector<float> block(512);
+  synth.render(block, events);
+
+  EXPECT_NE(block[1], 0.0f);
+  EXPECT_NE(block[299], 0.0f);
+  EXPECT_EQ(first_sound({block.begin() + 300, block.end()}), 212u);
+  EXPECT_FALSE(synth.on());
+  EXPECT_TRUE(events.front().has_value()); // still pending
+
+  synth.render(block, events);
+  EXPECT_EQ(first_sound(block), 750u - 512u + 1); // starts at zero
+  EXPECT_TRUE(synth.on());
+  EXPECT_FALSE(events.front().has_value());
+}
+
+TEST(BeepSynthTest, LateOrRunawayEventsReanchorAtTheBlock) {
+  chip8::BeepSynth synth{CONFIG};
+  chip8::SpscQueue<chip8::BeepEvent> events{8};
+  std::vector<float> block(600);
+
+  events.try_push({0, 0.0f, true});
+  synth.render(block, events); // frame 0 is sample 0
+  synth.render(block, events);
+  synth.render(block, events);
+
+  // Frame 1 maps to sample 600, which has been played: play it now.
+  events.try_push({1, 0.0f, false});
+  synth.render(block, events);
+  EXPECT_EQ(first_sound(block), block.size());
+
+  // Now frame 1 is sample 1800. Frame 10 would be 5400, over two frames
+  // ahead of the block at 2400, so it too plays at once.
+  events.try_push({10, 0.0f, true});
+  synth.render(block, events);
+  EXPECT_EQ(first_sound(block), 1u);
+  EXPECT_TRUE(synth.on());
+}
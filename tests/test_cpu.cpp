@@ -6,9 +6,18 @@
 #include "constants.h"
 #include "mock_rng.h"
 #include "gtest/gtest.h"
+#include <cstdint>
 
-class CpuTest : public ::testing::Test {
+// Every test runs once per dispatch mode; they must all behave identically.
+class CpuTest : public ::testing::TestWithParam<chip8::DispatchMode> {
 protected:
+  void SetUp() override {
+    if (GetParam() == chip8::DispatchMode::Jit && !chip8::Jit::supported()) {
+      GTEST_SKIP() << "JIT is not supported on this host";
+    }
+    cpu.set_dispatch_mode(GetParam());
+  }
+
   chip8::Memory memory;
   chip8::Display display;
   chip8::Keyboard keyboard;
@@ -17,7 +26,7 @@ protected:
   chip8::Cpu cpu{memory, display, keyboard, timer, rng};
 };
 
-TEST_F(CpuTest, CLSInstrcutionClearsScreen) {
+TEST_P(CpuTest, CLSInstrcutionClearsScreen) {
   for (uint8_t i = 0; i < chip8::SCREEN_WIDTH; ++i) {
     for (uint8_t j = 0; j < chip8::SCREEN_HEIGHT; ++j) {
       display.set_pixel(i, j, true);
@@ -36,7 +45,7 @@ TEST_F(CpuTest, CLSInstrcutionClearsScreen) {
   }
 }
 
-TEST_F(CpuTest, RETInstructionReturnsToCaller) {
+TEST_P(CpuTest, RETInstructionReturnsToCaller) {
   // Arrange: simulate CALL 0x300 (we'll manually pre-load stack)
   // Program layout:
   // 0x200: 23 00   -> CALL 0x300
@@ -59,7 +68,7 @@ TEST_F(CpuTest, RETInstructionReturnsToCaller) {
   SUCCEED();
 }
 
-TEST_F(CpuTest, JPInstructionSetsProgramCounterToNNN) {
+TEST_P(CpuTest, JPInstructionSetsProgramCounterToNNN) {
   memory.write_byte(0x200, 0x12u);
   memory.write_byte(0x201, 0x34u);
 
@@ -68,7 +77,7 @@ TEST_F(CpuTest, JPInstructionSetsProgramCounterToNNN) {
   EXPECT_EQ(cpu.program_counter(), 0x0234u);
 }
 
-TEST_F(CpuTest, LDPutsValueKKInRegisterX) {
+TEST_P(CpuTest, LDPutsValueKKInRegisterX) {
   memory.write_byte(0x200, 0x65u);
   memory.write_byte(0x201, 0xFAu);
 
@@ -77,7 +86,7 @@ TEST_F(CpuTest, LDPutsValueKKInRegisterX) {
   EXPECT_EQ(cpu.registers()[0x05], 0xFAu);
 }
 
-TEST_F(CpuTest, SESkipsNextInstructionIfVxIsKK) {
+TEST_P(CpuTest, SESkipsNextInstructionIfVxIsKK) {
   // Set V[B] = 85
   memory.write_byte(0x200, 0x6Bu);
   memory.write_byte(0x201, 0x85u);
@@ -91,7 +100,7 @@ TEST_F(CpuTest, SESkipsNextInstructionIfVxIsKK) {
   EXPECT_EQ(cpu.program_counter(), 0x206);
 }
 
-TEST_F(CpuTest, SNE_VxByte_SkipsNextInstructionWhenNotEqual) {
+TEST_P(CpuTest, SNE_VxByte_SkipsNextInstructionWhenNotEqual) {
   // Arrange: set v[0x09] = 0x56
   memory.write_byte(0x200, 0x69u);
   memory.write_byte(0x201, 0x56u);
@@ -106,7 +115,7 @@ TEST_F(CpuTest, SNE_VxByte_SkipsNextInstructionWhenNotEqual) {
   EXPECT_EQ(cpu.program_counter(), before + 4);
 }
 
-TEST_F(CpuTest, SE_VxVy_SkipsNextInstructionWhenEqual) {
+TEST_P(CpuTest, SE_VxVy_SkipsNextInstructionWhenEqual) {
   // Arrange: set v[0x03] = v[0x0A] = 0x85
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x85u);
@@ -126,7 +135,7 @@ TEST_F(CpuTest, SE_VxVy_SkipsNextInstructionWhenEqual) {
   EXPECT_EQ(cpu.program_counter(), before + 4);
 }
 
-TEST_F(CpuTest, ADD_VxByte_AddsImmediateToRegister) {
+TEST_P(CpuTest, ADD_VxByte_AddsImmediateToRegister) {
   // Arrange: set v[0x03] = 0x23
   uint8_t first = 0x23;
   uint8_t second = 0x45;
@@ -143,7 +152,7 @@ TEST_F(CpuTest, ADD_VxByte_AddsImmediateToRegister) {
   EXPECT_EQ(cpu.registers()[0x03], first + second);
 }
 
-TEST_F(CpuTest, LD_VxVy_StoresValueOfVyInVx) {
+TEST_P(CpuTest, LD_VxVy_StoresValueOfVyInVx) {
   // Arrange: set v[0x03] = 0x85
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x85u);
@@ -160,7 +169,7 @@ TEST_F(CpuTest, LD_VxVy_StoresValueOfVyInVx) {
   EXPECT_EQ(cpu.registers()[0x0E], 0x85u);
 }
 
-TEST_F(CpuTest, OR_VxVy_BitwiseOrOfVxAndVyIsStoredInVx) {
+TEST_P(CpuTest, OR_VxVy_BitwiseOrOfVxAndVyIsStoredInVx) {
   // Arrange: set v[0x03] = 0x23 and v[0x0A] = 0x45
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x23u);
@@ -181,7 +190,7 @@ TEST_F(CpuTest, OR_VxVy_BitwiseOrOfVxAndVyIsStoredInVx) {
   EXPECT_EQ(cpu.registers()[0x03], 0x67u);
 }
 
-TEST_F(CpuTest, AND_VxVy_BitwiseAndfOfVxAndVyIsStoredInVx) {
+TEST_P(CpuTest, AND_VxVy_BitwiseAndfOfVxAndVyIsStoredInVx) {
   // Arrange: set v[0x03] = 0x23 and v[0x0A] = 0x45
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x23u);
@@ -202,7 +211,7 @@ TEST_F(CpuTest, AND_VxVy_BitwiseAndfOfVxAndVyIsStoredInVx) {
   EXPECT_EQ(cpu.registers()[0x03], 0x01u);
 }
 
-TEST_F(CpuTest, XOR_VxVy_BitwiseXorfOfVxAndVyIsStoredInVx) {
+TEST_P(CpuTest, XOR_VxVy_BitwiseXorfOfVxAndVyIsStoredInVx) {
   // Arrange: set v[0x03] = 0x23 and v[0x0A] = 0x45
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x23u);
@@ -223,7 +232,7 @@ TEST_F(CpuTest, XOR_VxVy_BitwiseXorfOfVxAndVyIsStoredInVx) {
   EXPECT_EQ(cpu.registers()[0x03], 0x66u);
 }
 
-TEST_F(CpuTest, ADD_VxVy_AddTwoRegistersAndStoreCarryInVf) {
+TEST_P(CpuTest, ADD_VxVy_AddTwoRegistersAndStoreCarryInVf) {
   // Arrange: set v[0x03] = 0x80 and v[0x0A] = 0x64
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x80u);
@@ -254,7 +263,7 @@ TEST_F(CpuTest, ADD_VxVy_AddTwoRegistersAndStoreCarryInVf) {
   EXPECT_EQ(cpu.registers()[0x0F], 0x01u);
 }
 
-TEST_F(CpuTest, SUB_VxVy_WhenVxIsGreaterThanVy) {
+TEST_P(CpuTest, SUB_VxVy_WhenVxIsGreaterThanVy) {
   // Arrange: set v[0x03] = 0x80 and v[0x0A] = 0x64
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x80u);
@@ -276,7 +285,7 @@ TEST_F(CpuTest, SUB_VxVy_WhenVxIsGreaterThanVy) {
   EXPECT_EQ(cpu.registers()[0x0F], 0x01u);
 }
 
-TEST_F(CpuTest, SUB_VxVy_WhenVxIsLessThanVy) {
+TEST_P(CpuTest, SUB_VxVy_WhenVxIsLessThanVy) {
   // Arrange: set v[0x03] = 0x64 and v[0x0A] = 0x80
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x64u);
@@ -298,7 +307,7 @@ TEST_F(CpuTest, SUB_VxVy_WhenVxIsLessThanVy) {
   EXPECT_EQ(cpu.registers()[0x0F], 0x00u);
 }
 
-TEST_F(CpuTest, SHR_Vx_DivdeVxBy2WhenItIsEven) {
+TEST_P(CpuTest, SHR_Vx_DivdeVxBy2WhenItIsEven) {
   // Arrange: set v[0x03] = 0x64
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x64u);
@@ -315,7 +324,7 @@ TEST_F(CpuTest, SHR_Vx_DivdeVxBy2WhenItIsEven) {
   EXPECT_EQ(cpu.registers()[0x0F], 0x00u);
 }
 
-TEST_F(CpuTest, SHR_Vx_DivdeVxBy2WhenItIsOdd) {
+TEST_P(CpuTest, SHR_Vx_DivdeVxBy2WhenItIsOdd) {
   // Arrange: set v[0x03] = 0x63
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x63u);
@@ -332,7 +341,7 @@ TEST_F(CpuTest, SHR_Vx_DivdeVxBy2WhenItIsOdd) {
   EXPECT_EQ(cpu.registers()[0x0F], 0x01u);
 }
 
-TEST_F(CpuTest, SUB_VyVx_WhenVyIsLessThanVx) {
+TEST_P(CpuTest, SUB_VyVx_WhenVyIsLessThanVx) {
   // Arrange: set v[0x03] = 0x80 and v[0x0A] = 0x64
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x80u);
@@ -355,7 +364,7 @@ TEST_F(CpuTest, SUB_VyVx_WhenVyIsLessThanVx) {
   EXPECT_EQ(cpu.registers()[0x0F], 0x00u);
 }
 
-TEST_F(CpuTest, SUB_VyVx_WhenVxIsGreaterThanVy) {
+TEST_P(CpuTest, SUB_VyVx_WhenVxIsGreaterThanVy) {
   // Arrange: set v[0x03] = 0x64 and v[0x0A] = 0x80
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x64u);
@@ -378,7 +387,7 @@ TEST_F(CpuTest, SUB_VyVx_WhenVxIsGreaterThanVy) {
   EXPECT_EQ(cpu.registers()[0x0F], 0x01u);
 }
 
-TEST_F(CpuTest, SHL_Vx_MultiplyVxBy2WhenMostSignificantBitIsZero) {
+TEST_P(CpuTest, SHL_Vx_MultiplyVxBy2WhenMostSignificantBitIsZero) {
   // Arrange: set v[0x03] = 0x64
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x64u);
@@ -395,7 +404,7 @@ TEST_F(CpuTest, SHL_Vx_MultiplyVxBy2WhenMostSignificantBitIsZero) {
   EXPECT_EQ(cpu.registers()[0x0F], 0x00u);
 }
 
-TEST_F(CpuTest, SHL_Vx_MultiplyVxBy2WhenMostSignificantBitIsOne) {
+TEST_P(CpuTest, SHL_Vx_MultiplyVxBy2WhenMostSignificantBitIsOne) {
   // Arrange: set v[0x03] = 0xA5
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0xA5u);
@@ -412,7 +421,7 @@ TEST_F(CpuTest, SHL_Vx_MultiplyVxBy2WhenMostSignificantBitIsOne) {
   EXPECT_EQ(cpu.registers()[0x0F], 0x01u);
 }
 
-TEST_F(CpuTest, SNE_VxVy_SkipsNextInstructionIfVxNEVy) {
+TEST_P(CpuTest, SNE_VxVy_SkipsNextInstructionIfVxNEVy) {
   // Arrange: set v[0x03] = 0x64 and v[0x0A] = 0x80
   memory.write_byte(0x200, 0x63u);
   memory.write_byte(0x201, 0x64u);
@@ -434,7 +443,7 @@ TEST_F(CpuTest, SNE_VxVy_SkipsNextInstructionIfVxNEVy) {
   EXPECT_EQ(cpu.program_counter(), before + 4);
 }
 
-TEST_F(CpuTest, LD_I_SetsValueOfRegisterIToNNN) {
+TEST_P(CpuTest, LD_I_SetsValueOfRegisterIToNNN) {
   // Arrange
   memory.write_byte(0x200, 0xAF);
   memory.write_byte(0x201, 0xED);
@@ -446,7 +455,7 @@ TEST_F(CpuTest, LD_I_SetsValueOfRegisterIToNNN) {
   EXPECT_EQ(cpu.index_register(), 0x0FEDu);
 }
 
-TEST_F(CpuTest, JP_V0_JumpsToNNNPlusV0) {
+TEST_P(CpuTest, JP_V0_JumpsToNNNPlusV0) {
   // Arrange: set v[0x00] = 0xAB
   memory.write_byte(0x200, 0x60u);
   memory.write_byte(0x201, 0xABu);
@@ -462,7 +471,7 @@ TEST_F(CpuTest, JP_V0_JumpsToNNNPlusV0) {
   EXPECT_EQ(cpu.program_counter(), 0x00ABu + 0x0879u);
 }
 
-TEST_F(CpuTest, RND_Vx_SetsVxRndByteAndKK) {
+TEST_P(CpuTest, RND_Vx_SetsVxRndByteAndKK) {
   // Arrange
   memory.write_byte(0x200, 0xC0u);
   memory.write_byte(0x201, 0xBCu);
@@ -475,7 +484,7 @@ TEST_F(CpuTest, RND_Vx_SetsVxRndByteAndKK) {
   EXPECT_EQ(cpu.registers()[0x00], 0x34u);
 }
 
-TEST_F(CpuTest, DRW_DrawSpriteWithoutCollision) {
+TEST_P(CpuTest, DRW_DrawSpriteWithoutCollision) {
   // Arrange: simple one byte sprite
   memory.write_byte(0x300, 0b11110101u);
 
@@ -503,7 +512,7 @@ TEST_F(CpuTest, DRW_DrawSpriteWithoutCollision) {
   EXPECT_TRUE(display.is_pixel_set(7, 0));
 }
 
-TEST_F(CpuTest, DRW_DrawSpriteWithCollision) {
+TEST_P(CpuTest, DRW_DrawSpriteWithCollision) {
   // Arrange: simple one byte sprite
   memory.write_byte(0x300, 0b11110101u);
 
@@ -533,7 +542,7 @@ TEST_F(CpuTest, DRW_DrawSpriteWithCollision) {
   }
 }
 
-TEST_F(CpuTest, DRW_DrawSpriteNearEdgeWrapsAround) {
+TEST_P(CpuTest, DRW_DrawSpriteNearEdgeWrapsAround) {
   // Arrange: simple two byte sprite
   memory.write_byte(0x300, 0xFFu);
   memory.write_byte(0x301, 0xFFu);
@@ -565,7 +574,7 @@ TEST_F(CpuTest, DRW_DrawSpriteNearEdgeWrapsAround) {
   }
 }
 
-TEST_F(CpuTest, SKP_SkipsNextInstructionWhenKeyPressed) {
+TEST_P(CpuTest, SKP_SkipsNextInstructionWhenKeyPressed) {
   // Arrange: set value of v[0x02] = 0x0C
   memory.write_byte(0x200, 0x62u);
   memory.write_byte(0x201, 0x0Cu);
@@ -583,7 +592,7 @@ TEST_F(CpuTest, SKP_SkipsNextInstructionWhenKeyPressed) {
   EXPECT_EQ(cpu.program_counter(), before + 4);
 }
 
-TEST_F(CpuTest, SKNP_SkipsNextInstructionWhenKeyNotPressed) {
+TEST_P(CpuTest, SKNP_SkipsNextInstructionWhenKeyNotPressed) {
   // Arrange: set value of v[0x02] = 0x0C
   memory.write_byte(0x200, 0x62u);
   memory.write_byte(0x201, 0x0Cu);
@@ -601,7 +610,7 @@ TEST_F(CpuTest, SKNP_SkipsNextInstructionWhenKeyNotPressed) {
   EXPECT_EQ(cpu.program_counter(), before + 4);
 }
 
-TEST_F(CpuTest, Fx07_PutsValueOfDelayTimerInRegister) {
+TEST_P(CpuTest, Fx07_PutsValueOfDelayTimerInRegister) {
   // Arrange
   timer.set_delay(0xFAu);
   EXPECT_EQ(cpu.registers()[0x0A], 0);
@@ -615,7 +624,7 @@ TEST_F(CpuTest, Fx07_PutsValueOfDelayTimerInRegister) {
   EXPECT_EQ(cpu.registers()[0x0A], 0xFAu);
 }
 
-TEST_F(CpuTest, LD_Vx_K_DoesNotAdvanceWhenNoKeyPressed) {
+TEST_P(CpuTest, LD_Vx_K_DoesNotAdvanceWhenNoKeyPressed) {
   // Arrange: opcode Fx0A (wait for key press, store in Vx)
   memory.write_byte(0x200, 0xF0u);
   memory.write_byte(0x201, 0x0Au);
@@ -630,7 +639,7 @@ TEST_F(CpuTest, LD_Vx_K_DoesNotAdvanceWhenNoKeyPressed) {
       << "PC advanced despite no key being pressed.";
 }
 
-TEST_F(CpuTest, LD_Vx_K_StoresPressedKeyAndAdvances) {
+TEST_P(CpuTest, LD_Vx_K_StoresPressedKeyAndAdvances) {
   // Arrange
   memory.write_byte(0x200, 0xF0u);
   memory.write_byte(0x201, 0x0Au);
@@ -646,7 +655,7 @@ TEST_F(CpuTest, LD_Vx_K_StoresPressedKeyAndAdvances) {
   EXPECT_EQ(cpu.program_counter(), old_pc + 2);
 }
 
-TEST_F(CpuTest, Fx15_LoadsDelayTimerFromVx) {
+TEST_P(CpuTest, Fx15_LoadsDelayTimerFromVx) {
   // Arrange: set v[0x02] = 0x0C
   memory.write_byte(0x200, 0x62u);
   memory.write_byte(0x201, 0x0Cu);
@@ -662,7 +671,7 @@ TEST_F(CpuTest, Fx15_LoadsDelayTimerFromVx) {
   EXPECT_EQ(timer.delay(), 0x0Cu);
 }
 
-TEST_F(CpuTest, Fx18_LoadsSoundTimerFromVx) {
+TEST_P(CpuTest, Fx18_LoadsSoundTimerFromVx) {
   // Arrange: set v[0x02] = 0x0C
   memory.write_byte(0x200, 0x62u);
   memory.write_byte(0x201, 0x0Cu);
@@ -678,7 +687,7 @@ TEST_F(CpuTest, Fx18_LoadsSoundTimerFromVx) {
   EXPECT_EQ(timer.sound(), 0x0Cu);
 }
 
-TEST_F(CpuTest, Fx1E_AddsValueOfVxToI) {
+TEST_P(CpuTest, Fx1E_AddsValueOfVxToI) {
   // Arrange: set v[0x0A] = 0x11
   memory.write_byte(0x200, 0x6Au);
   memory.write_byte(0x201, 0x11u);
@@ -703,7 +712,7 @@ TEST_F(CpuTest, Fx1E_AddsValueOfVxToI) {
   EXPECT_EQ(cpu.index_register(), 0x22u);
 }
 
-TEST_F(CpuTest, Fx29_SetsIndexToFontSpriteForVx) {
+TEST_P(CpuTest, Fx29_SetsIndexToFontSpriteForVx) {
   // Arrange set V1 = 0x0A
   memory.write_byte(0x200, 0x61u);
   memory.write_byte(0x201, 0x0Au);
@@ -721,7 +730,7 @@ TEST_F(CpuTest, Fx29_SetsIndexToFontSpriteForVx) {
   EXPECT_EQ(cpu.index_register(), 0x32u);
 }
 
-TEST_F(CpuTest, Fx33_StoresBCDRepresentationOfVxInMemory) {
+TEST_P(CpuTest, Fx33_StoresBCDRepresentationOfVxInMemory) {
   // Arrange load V1 = 234 (0xEA)
   memory.write_byte(0x200, 0x61u);
   memory.write_byte(0x201, 0xEAu);
@@ -745,7 +754,7 @@ TEST_F(CpuTest, Fx33_StoresBCDRepresentationOfVxInMemory) {
   EXPECT_EQ(memory.read_byte(0x302), 4u);
 }
 
-TEST_F(CpuTest, Fx55_StoresRegistersV0ToVxIntoMemoryStartingAtI) {
+TEST_P(CpuTest, Fx55_StoresRegistersV0ToVxIntoMemoryStartingAtI) {
   // Arrange
   // Set V0..V3 = 0x10, 0x20, 0x30, 0x40
   memory.write_byte(0x200, 0x60u);
@@ -786,7 +795,7 @@ TEST_F(CpuTest, Fx55_StoresRegistersV0ToVxIntoMemoryStartingAtI) {
   EXPECT_EQ(cpu.index_register(), 0x304u);
 }
 
-TEST_F(CpuTest, Fx65_LoadsRegistersV0ToVxFromMemoryStartingAtI) {
+TEST_P(CpuTest, Fx65_LoadsRegistersV0ToVxFromMemoryStartingAtI) {
   // Arrange initialize memory with some values starting at I = 0x300
   memory.write_byte(0x300, 0x11u);
   memory.write_byte(0x301, 0x22u);
@@ -813,3 +822,54 @@ TEST_F(CpuTest, Fx65_LoadsRegistersV0ToVxFromMemoryStartingAtI) {
   // I should now point past the loaded block
   EXPECT_EQ(cpu.index_register(), 0x304u);
 }
+
+TEST_P(CpuTest, LD_VxK_StopsRunUntilAKeyIsPressed) {
+  memory.write_byte(0x200, 0xF3u); // LD V3, K
+  memory.write_byte(0x201, 0x0Au);
+  memory.write_byte(0x202, 0x74u); // ADD V4, 1
+  memory.write_byte(0x203, 0x01u);
+
+  cpu.run(100);
+  EXPECT_TRUE(cpu.waiting_for_key());
+  EXPECT_EQ(cpu.program_counter(), 0x200u);
+
+  keyboard.set_key_state(7, true);
+  cpu.run(2);
+  EXPECT_FALSE(cpu.waiting_for_key());
+  EXPECT_EQ(cpu.registers()[3], 7u);
+  EXPECT_EQ(cpu.registers()[4], 1u);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    DispatchModes, CpuTest,
+    ::testing::Values(chip8::DispatchMode::Switch, chip8::DispatchMode::Table,
+                      chip8::DispatchMode::Cached, chip8::DispatchMode::Jit),
+    [](const ::testing::TestParamInfo<chip8::DispatchMode> &info) {
+      switch (info.param) {
+      case chip8::DispatchMode::Switch:
+        return "Switch";
+      case chip8::DispatchMode::Table:
+        return "Table";
+      case chip8::DispatchMode::Cached:
+        return "Cached";
+      case chip8::DispatchMode::Jit:
+        return "Jit";
+      }
+      return "Unknown";
+    });
+
+TEST(CpuLayoutTest, RegistersAndStackShareOneCacheLine) {
+  static_assert(alignof(chip8::Cpu) == 64);
+  chip8::Memory memory;
+  chip8::Display display;
+  chip8::Keyboard keyboard;
+  chip8::Timer timer;
+  MockRandom rng;
+  chip8::Cpu cpu{memory, display, keyboard, timer, rng};
+
+  const auto line = reinterpret_cast<std::uintptr_t>(cpu.registers().data());
+  const auto stack =
+      reinterpret_cast<std::uintptr_t>(cpu.call_stack().data());
+  EXPECT_EQ(line % 64, 0u);
+  EXPECT_LE(stack + sizeof(uint16_t) * chip8::NUM_CPU_STACK, line + 64);
+}
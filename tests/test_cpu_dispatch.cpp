@@ -0,0 +1,313 @@
+#include "chip8_cpu.h"
+#include "chip8_display.h"
+#include "chip8_emulator.h"
+#include "chip8_irand_gen.h"
+#include "chip8_keyboard.h"
+#include "chip8_memory.h"
+#include "chip8_timer.h"
+#include "constants.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+
+namespace {
+
+class FixedRandom : public chip8::RandomGenerator {
+public:
+  uint8_t next(uint8_t mask) override { return 0xA5u & mask; }
+};
+
+// Low registers hold valid key indices (Ex9E/ExA1 throw otherwise), high
+// registers hold values large enough to carry and borrow.
+constexpr uint8_t register_value(uint16_t x) {
+  return static_cast<uint8_t>(x < 8 ? x * 2 : 0x80 + x * 13);
+}
+
+// One CPU with every subsystem it touches, primed with a CALL (so 00EE has a
+// frame to return from), all sixteen registers, I, both timers, a pressed
+// key and some pixels. The opcode under test sits right after the prologue.
+struct Machine {
+  explicit Machine(chip8::DispatchMode mode, uint16_t opcode) {
+    cpu.set_dispatch_mode(mode);
+
+    uint16_t addr = chip8::START_ADDRESS;
+    auto emit = [&](uint16_t op) {
+      memory.write_byte(addr++, static_cast<uint8_t>(op >> 8));
+      memory.write_byte(addr++, static_cast<uint8_t>(op & 0xFF));
+    };
+
+    emit(0x2204); // CALL 0x204
+    emit(0x0000);
+    for (uint16_t x = 0; x < chip8::NUM_CPU_REGISTERS; ++x) {
+      emit(static_cast<uint16_t>(0x6000 | x << 8 | register_value(x)));
+    }
+    emit(0xA300); // LD I, 0x300
+    emit(opcode);
+
+    for (uint16_t i = 0; i < 0x40; ++i) {
+      memory.write_byte(0x300 + i, static_cast<uint8_t>(i * 29));
+    }
+
+    timer.set_delay(42);
+    timer.set_sound(7);
+    keyboard.set_key_state(0x6, true);
+    display.set_pixel(11, 3, true);
+    display.set_pixel(63, 31, true);
+
+    for (int i = 0; i < 2 + chip8::NUM_CPU_REGISTERS; ++i) {
+      cpu.execute();
+    }
+  }
+
+  chip8::Memory memory;
+  chip8::Display display;
+  chip8::Keyboard keyboard;
+  chip8::Timer timer;
+  FixedRandom rng;
+  chip8::Cpu cpu{memory, display, keyboard, timer, rng};
+};
+
+void expect_same_state(const Machine &lhs, const Machine &rhs,
+                       uint16_t opcode) {
+  SCOPED_TRACE(::testing::Message() << "opcode 0x" << std::hex << opcode);
+  EXPECT_EQ(lhs.cpu.program_counter(), rhs.cpu.program_counter());
+  EXPECT_EQ(lhs.cpu.index_register(), rhs.cpu.index_register());
+  EXPECT_TRUE(std::ranges::equal(lhs.cpu.registers(), rhs.cpu.registers()));
+  EXPECT_TRUE(std::ranges::equal(lhs.memory.span(), rhs.memory.span()));
+  EXPECT_EQ(lhs.timer.delay(), rhs.timer.delay());
+  EXPECT_EQ(lhs.timer.sound(), rhs.timer.sound());
+  EXPECT_EQ(lhs.keyboard.last_pressed(), rhs.keyboard.last_pressed());
+  for (int y = 0; y < chip8::SCREEN_HEIGHT; ++y) {
+    for (int x = 0; x < chip8::SCREEN_WIDTH; ++x) {
+      ASSERT_EQ(lhs.display.is_pixel_set(x, y), rhs.display.is_pixel_set(x, y))
+          << "pixel " << x << "," << y;
+    }
+  }
+}
+
+} // namespace
+
+class CpuDispatchTest : public ::testing::TestWithParam<chip8::DispatchMode> {
+};
+
+TEST_P(CpuDispatchTest, MatchesSwitchForEveryOpcode) {
+  if (GetParam() == chip8::DispatchMode::Jit && !chip8::Jit::supported()) {
+    GTEST_SKIP() << "JIT is not supported on this host";
+  }
+  for (uint32_t opcode = 0; opcode <= 0xFFFF; ++opcode) {
+    const auto op = static_cast<uint16_t>(opcode);
+    // 0nnn only logs a warning; keep a handful of them to cover the path.
+    if (op < 0x1000 && op != 0x00E0 && op != 0x00EE && op > 0x0002) {
+      continue;
+    }
+    const auto key_op = op & 0xF0FF;
+    const bool valid_key = register_value((op >> 8) & 0x0F) < chip8::NUM_KEYS;
+    if ((key_op == 0xE09E || key_op == 0xE0A1) && !valid_key) {
+      continue;
+    }
+
+    Machine reference{chip8::DispatchMode::Switch, op};
+    Machine candidate{GetParam(), op};
+    reference.cpu.execute();
+    candidate.cpu.execute();
+
+    expect_same_state(reference, candidate, op);
+    if (::testing::Test::HasFailure()) {
+      return;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, CpuDispatchTest,
+                         ::testing::Values(chip8::DispatchMode::Table,
+                                           chip8::DispatchMode::Cached,
+                                           chip8::DispatchMode::Jit));
+
+class DecodeCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override { cpu.set_dispatch_mode(chip8::DispatchMode::Cached); }
+
+  void load(std::initializer_list<uint16_t> program) {
+    uint16_t addr = chip8::START_ADDRESS;
+    for (auto op : program) {
+      memory.write_byte(addr++, static_cast<uint8_t>(op >> 8));
+      memory.write_byte(addr++, static_cast<uint8_t>(op & 0xFF));
+    }
+  }
+
+  chip8::Memory memory;
+  chip8::Display display;
+  chip8::Keyboard keyboard;
+  chip8::Timer timer;
+  FixedRandom rng;
+  chip8::Cpu cpu{memory, display, keyboard, timer, rng};
+};
+
+TEST_F(DecodeCacheTest, ExternalWriteInvalidatesCachedInstruction) {
+  load({0x7001,   // 0x200: ADD V0, 1
+        0x1200}); // 0x202: JP 0x200
+  for (int i = 0; i < 10; ++i) {
+    cpu.execute();
+  }
+  EXPECT_EQ(cpu.registers()[0x0], 5u);
+
+  memory.write_byte(0x201, 0x02); // now ADD V0, 2
+  cpu.execute();
+  cpu.execute();
+
+  EXPECT_EQ(cpu.registers()[0x0], 7u);
+}
+
+TEST_F(DecodeCacheTest, Fx55OverwritingCachedInstructionIsObserved) {
+  load({0x120C,   // 0x200: JP 0x20C (runs the target once so it is cached)
+        0x6070,   // 0x202: LD V0, 0x70
+        0x6105,   // 0x204: LD V1, 0x05
+        0xA20C,   // 0x206: LD I, 0x20C
+        0xF155,   // 0x208: LD [I], V1 -> 0x20C becomes ADD V0, 5
+        0x120C,   // 0x20A: JP 0x20C
+        0x7301,   // 0x20C: ADD V3, 1
+        0x1202}); // 0x20E: JP 0x202
+  for (int i = 0; i < 9; ++i) {
+    cpu.execute();
+  }
+
+  EXPECT_EQ(cpu.registers()[0x3], 1u);
+  EXPECT_EQ(cpu.registers()[0x0], 0x75u);
+}
+
+TEST_F(DecodeCacheTest, Fx33OverwritingCachedInstructionIsObserved) {
+  load({0x1208,   // 0x200: JP 0x208 (runs the target once so it is cached)
+        0x60FF,   // 0x202: LD V0, 255
+        0xA209,   // 0x204: LD I, 0x209
+        0xF033,   // 0x206: LD B, V0 -> writes 2 5 5, 0x208 becomes ADD V3, 2
+        0x7301,   // 0x208: ADD V3, 1
+        0x1202}); // 0x20A: JP 0x202
+  for (int i = 0; i < 7; ++i) {
+    cpu.execute();
+  }
+
+  EXPECT_EQ(cpu.registers()[0x3], 3u);
+}
+
+namespace {
+
+template <typename Access> struct PolicyMachine {
+  PolicyMachine(chip8::DispatchMode mode,
+                std::initializer_list<uint16_t> program) {
+    cpu.set_dispatch_mode(mode);
+    uint16_t addr = chip8::START_ADDRESS;
+    for (auto op : program) {
+      memory.write_byte(addr++, static_cast<uint8_t>(op >> 8));
+      memory.write_byte(addr++, static_cast<uint8_t>(op & 0xFF));
+    }
+  }
+
+  chip8::BasicMemory<Access> memory;
+  chip8::Display display;
+  chip8::Keyboard keyboard;
+  chip8::Timer timer;
+  FixedRandom rng;
+  chip8::BasicCpu<Access> cpu{memory, display, keyboard, timer, rng};
+};
+
+} // namespace
+
+class MemoryAccessTest : public ::testing::TestWithParam<chip8::DispatchMode> {
+protected:
+  void SetUp() override {
+    if (GetParam() == chip8::DispatchMode::Jit && !chip8::Jit::supported()) {
+      GTEST_SKIP() << "JIT is not supported on this host";
+    }
+  }
+};
+
+TEST_P(MemoryAccessTest, CheckedAccessThrowsOutOfExecute) {
+  PolicyMachine<chip8::CheckedAccess> store{GetParam(),
+                                            {0xAFFE,   // LD I, 0xFFE
+                                             0xF255}}; // LD [I], V2
+  store.cpu.execute();
+  EXPECT_THROW(store.cpu.execute(), std::out_of_range);
+
+  PolicyMachine<chip8::CheckedAccess> fetch{GetParam(), {0x1FFF}}; // JP 0xFFF
+  fetch.cpu.execute();
+  EXPECT_THROW(fetch.cpu.execute(), std::out_of_range);
+}
+
+TEST_P(MemoryAccessTest, MaskedAccessWrapsAroundTheEnd) {
+  PolicyMachine<chip8::MaskedAccess> machine{
+      GetParam(),
+      {0x6001,   // 0x200: LD V0, 0x01
+       0x6112,   // 0x202: LD V1, 0x12
+       0x620E,   // 0x204: LD V2, 0x0E
+       0xAFFF,   // 0x206: LD I, 0xFFF
+       0xF255,   // 0x208: LD [I], V2 -> 0xFFF, 0x000, 0x001
+       0xF065,   // 0x20A: LD V0, [I] -> reads 0x002
+       0x1FFE,   // 0x20C: JP 0xFFE
+       0x120E}}; // 0x20E: JP 0x20E
+  // With V0 and V1, V2 stored: 0xFFE ADD V3, 1 and 0x000 JP 0x20E.
+  machine.memory.write_byte(0xFFE, 0x73);
+  for (int i = 0; i < 9; ++i) {
+    machine.cpu.execute();
+  }
+
+  EXPECT_EQ(machine.cpu.program_counter(), 0x20Eu);
+  EXPECT_EQ(machine.cpu.registers()[0x3], 1u);
+  EXPECT_EQ(machine.cpu.registers()[0x0], chip8::DEFAULT_CHAR_SET[2]);
+  EXPECT_EQ(machine.cpu.index_register(), 0x1003u);
+  EXPECT_EQ(machine.memory.read_byte(0x000), 0x12u);
+}
+
+TEST_P(MemoryAccessTest, CheckedAccessThrowsOnKeysAndStack) {
+  using chip8::CheckedAccess;
+  PolicyMachine<CheckedAccess> key{GetParam(), {0x60FF,   // LD V0, 0xFF
+                                                0xE09E}}; // SKP V0
+  key.cpu.execute();
+  EXPECT_THROW(key.cpu.execute(), std::out_of_range);
+
+  PolicyMachine<CheckedAccess> underflow{GetParam(), {0x00EE}}; // RET
+  EXPECT_THROW(underflow.cpu.execute(), std::out_of_range);
+
+  PolicyMachine<CheckedAccess> overflow{GetParam(), {0x2200}}; // CALL 0x200
+  for (std::size_t i = 0; i < chip8::NUM_CPU_STACK; ++i) {
+    overflow.cpu.execute();
+  }
+  EXPECT_THROW(overflow.cpu.execute(), std::out_of_range);
+}
+
+TEST_P(MemoryAccessTest, MaskedAccessWrapsKeysAndStack) {
+  using chip8::MaskedAccess;
+  PolicyMachine<MaskedAccess> key{GetParam(), {0x6013,   // LD V0, 0x13
+                                               0xE09E}}; // SKP V0
+  key.keyboard.set_key_mask(1u << 0x3);
+  key.cpu.execute();
+  key.cpu.execute();
+  EXPECT_EQ(key.cpu.program_counter(), 0x206u);
+
+  PolicyMachine<MaskedAccess> underflow{GetParam(), {0x00EE}}; // RET
+  underflow.cpu.execute();
+  EXPECT_EQ(underflow.cpu.program_counter(), 0x000u);
+
+  PolicyMachine<MaskedAccess> overflow{GetParam(), {0x2200}}; // CALL 0x200
+  for (std::size_t i = 0; i <= chip8::NUM_CPU_STACK; ++i) {
+    overflow.cpu.execute();
+  }
+  EXPECT_EQ(overflow.cpu.call_stack().size(), 1u);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllModes, MemoryAccessTest,
+                         ::testing::Values(chip8::DispatchMode::Switch,
+                                           chip8::DispatchMode::Table,
+                                           chip8::DispatchMode::Cached,
+                                           chip8::DispatchMode::Jit));
+
+TEST(DispatchModeTest, EmulatorReportsUnsupportedJit) {
+  if (chip8::Jit::supported()) {
+    GTEST_SKIP() << "JIT is supported on this host";
+  }
+  chip8::Emulator emulator{10};
+  EXPECT_THROW(emulator.set_dispatch_mode(chip8::DispatchMode::Jit),
+               std::runtime_error);
+  EXPECT_NO_THROW(emulator.set_dispatch_mode(chip8::DispatchMode::Table));
+}
@@ -56,3 +56,71 @@ TEST(DisplayTest, DrawSpriteWithCollision) {
   EXPECT_TRUE(collision);
   EXPECT_FALSE(d.is_pixel_set(0, 0)); // flipped off
 }
+
+TEST(DisplayTest, DrawSpriteWrapsAcrossRightEdge) {
+  chip8::Display d;
+  uint8_t sprite[1] = {0b11000011};
+  auto _ = d.draw_sprite(chip8::SCREEN_WIDTH - 4, 0, sprite);
+
+  EXPECT_TRUE(d.is_pixel_set(chip8::SCREEN_WIDTH - 4, 0));
+  EXPECT_FALSE(d.is_pixel_set(chip8::SCREEN_WIDTH - 2, 0));
+  EXPECT_FALSE(d.is_pixel_set(1, 0));
+  EXPECT_TRUE(d.is_pixel_set(3, 0));
+}
+
+TEST(DisplayTest, DrawSpriteWrapsAcrossBottomEdgeAndDetectsCollision) {
+  chip8::Display d;
+  d.set_pixel(0, 0, true);
+  uint8_t sprite[2] = {0b10000000, 0b10000000};
+
+  bool collision = d.draw_sprite(chip8::SCREEN_WIDTH, -1, sprite);
+
+  EXPECT_TRUE(collision);
+  EXPECT_TRUE(d.is_pixel_set(0, chip8::SCREEN_HEIGHT - 1));
+  EXPECT_FALSE(d.is_pixel_set(0, 0));
+}
+
+TEST(DisplayTest, RowsExposePackedPixelsMostSignificantBitFirst) {
+  chip8::Display d;
+  d.set_pixel(0, 2, true);
+  d.set_pixel(chip8::SCREEN_WIDTH - 1, 2, true);
+
+  EXPECT_EQ(d.rows()[2], 0x8000000000000001ull);
+  EXPECT_EQ(d.rows()[1], 0u);
+}
+
+TEST(DisplayTest, DirtyRowsTrackChangesSinceGeneration) {
+  chip8::Display d;
+  const uint64_t start = d.generation();
+  uint8_t sprite[3] = {0b10000000, 0b00000000, 0b01000000};
+
+  auto _ = d.draw_sprite(0, chip8::SCREEN_HEIGHT - 1, sprite);
+
+  EXPECT_GT(d.generation(), start);
+  // Rows 31 and 1 changed; the blank sprite row left row 0 alone.
+  EXPECT_EQ(d.dirty_rows(start), (1u << 31) | (1u << 1));
+  EXPECT_EQ(d.dirty_rows(d.generation()), 0u);
+}
+
+TEST(DisplayTest, NoOpWritesDoNotAdvanceGeneration) {
+  chip8::Display d;
+  d.set_pixel(5, 5, true);
+  const uint64_t seen = d.generation();
+
+  d.set_pixel(5, 5, true);
+  d.set_pixel(6, 6, false);
+
+  EXPECT_EQ(d.generation(), seen);
+  EXPECT_EQ(d.dirty_rows(seen), 0u);
+}
+
+TEST(DisplayTest, ClearMarksOnlyRowsThatHadPixels) {
+  chip8::Display d;
+  d.set_pixel(0, 4, true);
+  d.set_pixel(0, 9, true);
+  const uint64_t seen = d.generation();
+
+  d.clear();
+
+  EXPECT_EQ(d.dirty_rows(seen), (1u << 4) | (1u << 9));
+}
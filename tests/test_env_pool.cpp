@@ -0,0 +1,201 @@
+#include "env_pool.h"
+#include "mpmc_queue.h"
+#include "vector_env.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Draws random bytes at random positions forever.
+const std::vector<uint8_t> NOISE_ROM{
+    0xC0, 0x3F, // 0x200: RND V0, 0x3F
+    0xC1, 0x1F, // 0x202: RND V1, 0x1F
+    0xA2, 0x00, // 0x204: LD I, 0x200
+    0xD0, 0x13, // 0x206: DRW V0, V1, 3
+    0x12, 0x00, // 0x208: JP 0x200
+};
+
+} // namespace
+
+TEST(MpmcQueueTest, FifoUntilFull) {
+  chip8::MpmcQueue<int> queue{3};
+  ASSERT_EQ(queue.capacity(), 4u);
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.try_push(i));
+  }
+  EXPECT_FALSE(queue.try_push(4));
+
+  int value = -1;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.try_pop(value));
+
+  // Wrapping around reuses the cells.
+  EXPECT_TRUE(queue.try_push(7));
+  ASSERT_TRUE(queue.try_pop(value));
+  EXPECT_EQ(value, 7);
+}
+
+TEST(MpmcQueueTest, ManyProducersAndConsumersLoseNothing) {
+  constexpr int PRODUCERS = 4;
+  constexpr int CONSUMERS = 4;
+  constexpr int PER_PRODUCER = 20000;
+  chip8::MpmcQueue<int> queue{64};
+  std::vector<std::atomic<int>> seen(PRODUCERS * PER_PRODUCER);
+  std::atomic<int> consumed{0};
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < PRODUCERS; ++p) {
+    threads.emplace_back([&, p] {
+      for (int i = 0; i < PER_PRODUCER; ++i) {
+        while (!queue.try_push(p * PER_PRODUCER + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int c = 0; c < CONSUMERS; ++c) {
+    threads.emplace_back([&] {
+      int value = 0;
+      while (consumed.load() < PRODUCERS * PER_PRODUCER) {
+        if (queue.try_pop(value)) {
+          ++seen[value];
+          ++consumed;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (const auto &count : seen) {
+    ASSERT_EQ(count.load(), 1);
+  }
+}
+
+TEST(EnvPoolTest, MatchesSynchronousStepping) {
+  constexpr std::size_t N = 8;
+  chip8::VectorEnv env{NOISE_ROM, N};
+  chip8::EnvPool pool{NOISE_ROM, N, 3};
+  const std::size_t obs = env.observation_size();
+
+  std::vector<uint8_t> expected(N * obs);
+  std::vector<float> rewards(N);
+  std::vector<uint8_t> dones(N);
+  std::vector<uint16_t> actions(N);
+  std::vector<std::size_t> all(N);
+  std::iota(all.begin(), all.end(), 0);
+
+  std::vector<std::size_t> ids(N);
+  std::vector<uint8_t> observations(N * obs);
+  for (int frame = 0; frame < 30; ++frame) {
+    env.step(actions, expected, rewards, dones);
+    pool.send(all, actions);
+    pool.recv(ids, observations, rewards, dones);
+
+    std::vector<std::size_t> sorted = ids;
+    std::ranges::sort(sorted);
+    ASSERT_EQ(sorted, all);
+    for (std::size_t j = 0; j < N; ++j) {
+      ASSERT_TRUE(std::equal(observations.begin() + j * obs,
+                             observations.begin() + (j + 1) * obs,
+                             expected.begin() + ids[j] * obs));
+    }
+  }
+  EXPECT_EQ(pool.in_flight(), 0u);
+}
+
+TEST(EnvPoolTest, ReceivesSubsetsWhileOthersStep) {
+  constexpr std::size_t N = 16;
+  chip8::EnvPool pool{NOISE_ROM, N, 4};
+  std::vector<int> frames(N);
+  pool.set_reward_hook([](std::size_t index, const chip8::Emulator &) {
+    return static_cast<float>(index);
+  });
+
+  std::vector<std::size_t> all(N);
+  std::iota(all.begin(), all.end(), 0);
+  pool.send(all, std::vector<uint16_t>(N));
+
+  constexpr std::size_t BATCH = 4;
+  std::vector<std::size_t> ids(BATCH);
+  std::vector<uint8_t> observations(BATCH * pool.observation_size());
+  std::vector<float> rewards(BATCH);
+  std::vector<uint8_t> dones(BATCH);
+  for (int round = 0; round < 200; ++round) {
+    pool.recv(ids, observations, rewards, dones);
+    for (std::size_t j = 0; j < BATCH; ++j) {
+      EXPECT_EQ(rewards[j], static_cast<float>(ids[j]));
+      ++frames[ids[j]];
+    }
+    EXPECT_EQ(pool.in_flight(), N - BATCH);
+    pool.send(ids, std::vector<uint16_t>(BATCH));
+  }
+
+  EXPECT_EQ(std::accumulate(frames.begin(), frames.end(), 0),
+            static_cast<int>(200 * BATCH));
+  std::vector<std::size_t> rest(N);
+  std::vector<uint8_t> rest_observations(N * pool.observation_size());
+  std::vector<float> rest_rewards(N);
+  std::vector<uint8_t> rest_dones(N);
+  pool.recv(rest, rest_observations, rest_rewards, rest_dones);
+  EXPECT_EQ(pool.in_flight(), 0u);
+}
+
+TEST(EnvPoolTest, RejectsMisuse) {
+  chip8::EnvPool pool{NOISE_ROM, 2, 1};
+  const std::vector<std::size_t> first{0};
+  const std::vector<uint16_t> keys{0};
+  std::vector<std::size_t> ids(2);
+  std::vector<uint8_t> observations(2 * pool.observation_size());
+  std::vector<float> rewards(2);
+  std::vector<uint8_t> dones(2);
+
+  EXPECT_THROW(pool.send(std::vector<std::size_t>{5}, keys),
+               std::out_of_range);
+  pool.send(first, keys);
+  EXPECT_THROW(pool.send(first, keys), std::logic_error);
+  // Only one instance is stepping, so waiting for two would never return.
+  EXPECT_THROW(pool.recv(ids, observations, rewards, dones), std::logic_error);
+  EXPECT_THROW(pool.reset(observations), std::logic_error);
+
+  std::vector<std::size_t> one(1);
+  std::vector<uint8_t> one_observation(pool.observation_size());
+  pool.recv(one, one_observation, std::span(rewards).first(1),
+            std::span(dones).first(1));
+  EXPECT_EQ(one[0], 0u);
+  EXPECT_NO_THROW(pool.reset(observations));
+}
+
+TEST(EnvPoolTest, RethrowsInstanceErrors) {
+  chip8::EnvPool pool{NOISE_ROM, 2, 2};
+  pool.set_reward_hook([](std::size_t index, const chip8::Emulator &) {
+    if (index == 1) {
+      throw std::runtime_error("no reward");
+    }
+    return 0.0f;
+  });
+  std::vector<std::size_t> all{0, 1};
+  std::vector<std::size_t> ids(2);
+  std::vector<uint8_t> observations(2 * pool.observation_size());
+  std::vector<float> rewards(2);
+  std::vector<uint8_t> dones(2);
+
+  pool.send(all, std::vector<uint16_t>(2));
+  EXPECT_THROW(pool.recv(ids, observations, rewards, dones),
+               std::runtime_error);
+  // Both results were consumed despite the error.
+  EXPECT_EQ(pool.in_flight(), 0u);
+}
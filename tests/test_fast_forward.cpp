@@ -0,0 +1,68 @@
+#include "fast_forward.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdint>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+using Clock = chip8::FastForward::Clock;
+
+// A clock that advances by `tick` every time it is read.
+struct FakeClock {
+  Clock::time_point *time;
+  Clock::duration tick;
+
+  Clock::time_point operator()() const {
+    *time += tick;
+    return *time;
+  }
+};
+
+} // namespace
+
+TEST(FastForwardTest, RunsOneFrameWhenInactive) {
+  chip8::FastForward fast_forward{8};
+  int frames = 0;
+  EXPECT_EQ(fast_forward.step([&] { ++frames; }, Clock::now()), 1u);
+  EXPECT_EQ(frames, 1);
+}
+
+TEST(FastForwardTest, RunsTheMultiplierWhileActive) {
+  chip8::FastForward fast_forward{8};
+  fast_forward.toggle();
+  ASSERT_TRUE(fast_forward.active());
+  int frames = 0;
+  // The deadline is ignored with a fixed multiplier.
+  EXPECT_EQ(fast_forward.step([&] { ++frames; }, Clock::time_point{}), 8u);
+  EXPECT_EQ(frames, 8);
+}
+
+TEST(FastForwardTest, UnlimitedRunsUntilTheDeadline) {
+  chip8::FastForward fast_forward{chip8::FastForward::UNLIMITED, true};
+  Clock::time_point time{};
+  const FakeClock clock{&time, 1ms};
+  int frames = 0;
+  EXPECT_EQ(fast_forward.step([&] { ++frames; }, time + 12ms, clock), 12u);
+  EXPECT_EQ(frames, 12);
+
+  // At least one frame, even past the deadline.
+  EXPECT_EQ(fast_forward.step([&] { ++frames; }, Clock::time_point{}, clock),
+            1u);
+}
+
+TEST(SpeedMeterTest, ReportsFramesRelativeToRealTime) {
+  chip8::SpeedMeter meter{60.0, 1s};
+  const Clock::time_point start{};
+  EXPECT_FALSE(meter.speed().has_value());
+
+  EXPECT_FALSE(meter.count(0, start));
+  EXPECT_FALSE(meter.count(200, start + 500ms));
+  EXPECT_TRUE(meter.count(100, start + 1s));
+  ASSERT_TRUE(meter.speed().has_value());
+  EXPECT_DOUBLE_EQ(*meter.speed(), 5.0); // 300 frames in one second
+
+  EXPECT_TRUE(meter.count(30, start + 2s));
+  EXPECT_DOUBLE_EQ(*meter.speed(), 0.5);
+}
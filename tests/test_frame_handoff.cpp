@@ -0,0 +1,103 @@
+#include "frame_handoff.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST(TripleBufferTest, ConsumerSeesOnlyTheNewestPublishedValue) {
+  chip8::TripleBuffer<int> buffer;
+  EXPECT_FALSE(buffer.update());
+
+  buffer.back() = 1;
+  EXPECT_FALSE(buffer.update()); // not published yet
+  buffer.publish();
+  ASSERT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.front(), 1);
+  EXPECT_FALSE(buffer.update());
+  EXPECT_EQ(buffer.front(), 1);
+
+  buffer.back() = 2;
+  buffer.publish();
+  buffer.back() = 3;
+  buffer.publish();
+  ASSERT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.front(), 3);
+}
+
+TEST(TripleBufferTest, ProducerNeverWritesTheSlotBeingRead) {
+  chip8::TripleBuffer<int> buffer;
+  buffer.back() = 1;
+  buffer.publish();
+  ASSERT_TRUE(buffer.update());
+  const int *reading = &buffer.front();
+
+  for (int value = 2; value < 10; ++value) {
+    EXPECT_NE(&buffer.back(), reading);
+    buffer.back() = value;
+    buffer.publish();
+  }
+  EXPECT_EQ(*reading, 1);
+}
+
+TEST(TripleBufferTest, ValuesCrossThreadsWhole) {
+  // Every word of a value holds the same number, so a torn read shows.
+  struct Value {
+    std::array<uint64_t, 16> words;
+  };
+  constexpr uint64_t LAST = 200'000;
+  chip8::TripleBuffer<Value> buffer;
+
+  std::thread producer{[&] {
+    for (uint64_t n = 1; n <= LAST; ++n) {
+      buffer.back().words.fill(n);
+      buffer.publish();
+    }
+  }};
+
+  uint64_t seen = 0;
+  uint64_t updates = 0;
+  while (seen != LAST) {
+    if (!buffer.update()) {
+      continue;
+    }
+    ++updates;
+    const Value &value = buffer.front();
+    const uint64_t n = value.words[0];
+    for (const uint64_t word : value.words) {
+      ASSERT_EQ(word, n);
+    }
+    ASSERT_GT(n, seen);
+    seen = n;
+  }
+  producer.join();
+  EXPECT_GT(updates, 0u);
+}
+
+TEST(LatencyHistogramTest, SummarisesSamples) {
+  chip8::LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.percentile(0.99), 0ns);
+
+  for (int i = 0; i < 99; ++i) {
+    histogram.record(1ms);
+  }
+  histogram.record(20ms);
+  EXPECT_EQ(histogram.count(), 100u);
+  EXPECT_EQ(histogram.max(), 20ms);
+  EXPECT_EQ(histogram.mean(), 1190us);
+  EXPECT_EQ(histogram.percentile(0.5), 1250us);
+  EXPECT_EQ(histogram.percentile(0.98), 1250us);
+  EXPECT_EQ(histogram.percentile(1.0), 20ms);
+}
+
+TEST(LatencyHistogramTest, OverflowReportsTheMaximum) {
+  chip8::LatencyHistogram histogram;
+  histogram.record(-5us); // clock skew counts as no delay
+  histogram.record(2s);
+  EXPECT_EQ(histogram.percentile(0.0), 250us);
+  EXPECT_EQ(histogram.percentile(1.0), 2s);
+  EXPECT_EQ(histogram.mean(), 1s);
+}
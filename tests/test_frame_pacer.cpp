@@ -0,0 +1,116 @@
+#include "frame_pacer.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdint>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+using Duration = chip8::PacerClock::Duration;
+using TimePoint = chip8::PacerClock::TimePoint;
+
+// Sleeps by jumping ahead, oversleeping by `oversleep`; every read of the
+// time costs `tick`, so spinning terminates.
+class FakeClock : public chip8::PacerClock {
+public:
+  explicit FakeClock(Duration oversleep = {}, Duration tick = 1us)
+      : oversleep_{oversleep}, tick_{tick} {}
+
+  TimePoint now() override {
+    time_ += tick_;
+    return time_;
+  }
+  void sleep_for(Duration duration) override {
+    time_ += duration + oversleep_;
+    ++sleeps_;
+    slept_ += duration;
+  }
+
+  void advance(Duration duration) { time_ += duration; }
+  [[nodiscard]] TimePoint time() const { return time_; }
+  [[nodiscard]] int sleeps() const { return sleeps_; }
+  [[nodiscard]] Duration slept() const { return slept_; }
+
+private:
+  Duration oversleep_;
+  Duration tick_;
+  TimePoint time_{};
+  int sleeps_{};
+  Duration slept_{};
+};
+
+} // namespace
+
+TEST(FramePacerTest, KeepsToTheScheduleWithoutDrift) {
+  // Each wake-up is a millisecond late, well inside the spin threshold.
+  FakeClock clock{1ms};
+  const TimePoint start = clock.time();
+  chip8::FramePacer pacer{clock};
+
+  for (int frame = 0; frame < 6000; ++frame) {
+    clock.advance(3ms); // emulating and presenting
+    ASSERT_EQ(pacer.wait(), 1u) << "frame " << frame;
+  }
+  // 6000 frames at 60 Hz are 100 s to the tick, not 6000 * 16.667 ms.
+  const auto elapsed = clock.time() - start;
+  EXPECT_GE(elapsed, 100s);
+  EXPECT_LT(elapsed, 100s + 100us);
+  EXPECT_EQ(pacer.stats().frames, 6000u);
+  EXPECT_EQ(pacer.stats().late_frames, 0u);
+  EXPECT_LT(pacer.stats().max_lateness, 10us);
+}
+
+TEST(FramePacerTest, CatchesUpOnMissedFrames) {
+  FakeClock clock;
+  chip8::FramePacer pacer{clock};
+  ASSERT_EQ(pacer.wait(), 1u);
+
+  // A 50 ms hitch runs over the next deadline and two more.
+  clock.advance(50ms);
+  EXPECT_EQ(pacer.wait(), 3u);
+  EXPECT_GE(pacer.stats().max_lateness, 16ms);
+  EXPECT_EQ(pacer.stats().late_frames, 1u);
+
+  // Back on schedule: frame 5 is due at 83.3 ms.
+  EXPECT_EQ(pacer.wait(), 1u);
+  EXPECT_GE(clock.time() - TimePoint{}, 83ms);
+  EXPECT_LT(clock.time() - TimePoint{}, 84ms);
+
+  // A long stall catches up at most max_catch_up frames.
+  clock.advance(1s);
+  EXPECT_EQ(pacer.wait(), pacer.config().max_catch_up);
+  EXPECT_GT(pacer.stats().skipped_frames, 50u);
+}
+
+TEST(FramePacerTest, SkipPolicyDropsMissedFrames) {
+  FakeClock clock;
+  chip8::PacerConfig config;
+  config.late_policy = chip8::LatePolicy::Skip;
+  chip8::FramePacer pacer{clock, config};
+  const TimePoint first = pacer.next_deadline();
+
+  clock.advance(50ms);
+  EXPECT_EQ(pacer.wait(), 1u);
+  EXPECT_EQ(pacer.stats().skipped_frames, 2u);
+  // The next deadline stays on the original grid, three periods on.
+  EXPECT_EQ(pacer.next_deadline() - first, 50ms);
+}
+
+TEST(FramePacerTest, SpinsOnlyTheLastStretch) {
+  FakeClock clock;
+  chip8::FramePacer pacer{clock};
+  pacer.wait();
+  EXPECT_EQ(clock.sleeps(), 1);
+  EXPECT_GT(clock.slept(), 15ms);
+  EXPECT_LT(clock.slept(), 16ms);
+}
+
+TEST(FramePacerTest, RestartStartsAFreshSchedule) {
+  FakeClock clock;
+  chip8::FramePacer pacer{clock};
+  clock.advance(10s);
+  pacer.restart();
+  EXPECT_EQ(pacer.wait(), 1u);
+  EXPECT_EQ(pacer.stats().skipped_frames, 0u);
+}
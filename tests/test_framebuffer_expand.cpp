@@ -0,0 +1,60 @@
+#include "framebuffer_expand.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t FG = 0x11223344u;
+constexpr uint32_t BG = 0xAABBCCDDu;
+
+} // namespace
+
+TEST(FramebufferExpandTest, ScalarMapsMostSignificantBitToLeftmostPixel) {
+  std::array<uint32_t, chip8::SCREEN_WIDTH> out{};
+  chip8::expand_row_scalar(0x8000000000000001ull, out.data(), FG, BG);
+
+  EXPECT_EQ(out[0], FG);
+  EXPECT_EQ(out[63], FG);
+  for (int x = 1; x < 63; ++x) {
+    EXPECT_EQ(out[x], BG) << "pixel " << x;
+  }
+}
+
+TEST(FramebufferExpandTest, VectorPathMatchesScalar) {
+  uint64_t bits = 0x9E3779B97F4A7C15ull;
+  for (int i = 0; i < 256; ++i) {
+    std::array<uint32_t, chip8::SCREEN_WIDTH> expected{};
+    std::array<uint32_t, chip8::SCREEN_WIDTH> actual{};
+    chip8::expand_row_scalar(bits, expected.data(), FG, BG);
+    chip8::expand_row(bits, actual.data(), FG, BG);
+    ASSERT_EQ(actual, expected) << "row 0x" << std::hex << bits;
+    bits ^= bits << 13;
+    bits ^= bits >> 7;
+    bits ^= bits << 17;
+  }
+}
+
+TEST(FramebufferExpandTest, ExpandRowsHonoursPitch) {
+  std::array<uint64_t, chip8::SCREEN_HEIGHT> rows{};
+  for (int y = 0; y < chip8::SCREEN_HEIGHT; ++y) {
+    rows[y] = uint64_t{1} << (63 - y);
+  }
+  // Eight bytes of padding after each row must stay untouched.
+  constexpr std::size_t pitch = (chip8::SCREEN_WIDTH + 2) * sizeof(uint32_t);
+  std::vector<uint32_t> texture(pitch / sizeof(uint32_t) *
+                                    chip8::SCREEN_HEIGHT,
+                                0xDEADBEEFu);
+
+  chip8::expand_rows(rows, texture.data(), pitch, FG, BG);
+
+  for (int y = 0; y < chip8::SCREEN_HEIGHT; ++y) {
+    const uint32_t *line = texture.data() + y * pitch / sizeof(uint32_t);
+    for (int x = 0; x < chip8::SCREEN_WIDTH; ++x) {
+      ASSERT_EQ(line[x], x == y ? FG : BG) << "pixel " << x << "," << y;
+    }
+    EXPECT_EQ(line[chip8::SCREEN_WIDTH], 0xDEADBEEFu);
+    EXPECT_EQ(line[chip8::SCREEN_WIDTH + 1], 0xDEADBEEFu);
+  }
+}
@@ -0,0 +1,248 @@
+#include "batch_runner.h"
+#include "chip8_emulator.h"
+#include "headless_audio.h"
+#include "wav_writer.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Starts the buzzer at instruction 2, counts V2 to 5, then stops it at
+// instruction 17 and halts.
+const std::vector<uint8_t> BLIP_ROM{
+    0x60, 0x02, // 0x200: LD V0, 2
+    0x61, 0x00, // 0x202: LD V1, 0
+    0xF0, 0x18, // 0x204: LD ST, V0
+    0x72, 0x01, // 0x206: ADD V2, 1
+    0x32, 0x05, // 0x208: SE V2, 5
+    0x12, 0x06, // 0x20A: JP 0x206
+    0xF1, 0x18, // 0x20C: LD ST, V1
+    0x12, 0x0E, // 0x20E: JP 0x20E
+};
+
+// Beeps for two frames and halts.
+const std::vector<uint8_t> BEEP_ROM{
+    0x60, 0x02, // 0x200: LD V0, 2
+    0xF0, 0x18, // 0x202: LD ST, V0
+    0x12, 0x04, // 0x204: JP 0x204
+};
+
+// Beeps for 16 frames while waiting for a key that never comes.
+const std::vector<uint8_t> WAIT_ROM{
+    0x60, 0x10, // 0x200: LD V0, 0x10
+    0xF0, 0x18, // 0x202: LD ST, V0
+    0xF1, 0x0A, // 0x204: LD V1, K
+};
+
+struct Change {
+  uint64_t frame;
+  float offset;
+  bool on;
+
+  bool operator==(const Change &) const = default;
+};
+
+class RecordingSink final : public chip8::BeepSink {
+public:
+  void beep(float offset, bool on) override {
+    changes.push_back({frame, offset, on});
+  }
+  void end_frame() override { ++frame; }
+
+  uint64_t frame{};
+  std::vector<Change> changes;
+};
+
+std::string render(const std::vector<Change> &changes, uint64_t frames) {
+  std::ostringstream out;
+  chip8::HeadlessAudio audio{out};
+  uint64_t frame = 0;
+  for (const Change &change : changes) {
+    for (; frame < change.frame; ++frame) {
+      audio.end_frame();
+    }
+    audio.beep(change.offset, change.on);
+  }
+  for (; frame < frames; ++frame) {
+    audio.end_frame();
+  }
+  audio.finish();
+  return std::move(out).str();
+}
+
+int16_t sample(const std::string &wav, std::size_t index) {
+  const std::size_t at = chip8::WavWriter::HEADER_SIZE + 2 * index;
+  return static_cast<int16_t>(static_cast<uint8_t>(wav[at]) |
+                              static_cast<uint8_t>(wav[at + 1]) << 8);
+}
+
+uint32_t u32_at(const std::string &bytes, std::size_t at) {
+  uint32_t value = 0;
+  for (int i = 3; i >= 0; --i) {
+    value = value << 8 | static_cast<uint8_t>(bytes[at + i]);
+  }
+  return value;
+}
+
+} // namespace
+
+class BeepTimingTest : public ::testing::TestWithParam<chip8::DispatchMode> {
+protected:
+  void SetUp() override {
+    if (GetParam() == chip8::DispatchMode::Jit && !chip8::Jit::supported()) {
+      GTEST_SKIP() << "JIT is not supported on this host";
+    }
+  }
+};
+
+TEST_P(BeepTimingTest, ChangesAreTimedToTheInstruction) {
+  for (const bool skip_idle_loops : {true, false}) {
+    chip8::Emulator emulator{100};
+    emulator.set_dispatch_mode(GetParam());
+    emulator.set_skip_idle_loops(skip_idle_loops);
+    RecordingSink sink;
+    emulator.set_beep_sink(&sink);
+    emulator.load_rom(BLIP_ROM);
+    emulator.run_frame();
+    emulator.run_frame();
+
+    EXPECT_EQ(sink.frame, 2u);
+    EXPECT_EQ(sink.changes, (std::vector<Change>{{0, 0.02f, true},
+                                                 {0, 0.17f, false}}));
+    EXPECT_EQ(emulator.cpu().program_counter(), 0x20Eu);
+  }
+}
+
+TEST_P(BeepTimingTest, TimerRunningOutEndsTheBeepBetweenFrames) {
+  chip8::Emulator emulator{50};
+  emulator.set_dispatch_mode(GetParam());
+  RecordingSink sink;
+  emulator.set_beep_sink(&sink);
+  emulator.load_rom(BEEP_ROM);
+  for (int frame = 0; frame < 4; ++frame) {
+    emulator.run_frame();
+  }
+  EXPECT_EQ(sink.changes,
+            (std::vector<Change>{{0, 0.02f, true}, {2, 0.0f, false}}));
+}
+
+INSTANTIATE_TEST_SUITE_P(AllModes, BeepTimingTest,
+                         ::testing::Values(chip8::DispatchMode::Switch,
+                                           chip8::DispatchMode::Table,
+                                           chip8::DispatchMode::Cached,
+                                           chip8::DispatchMode::Jit));
+
+TEST(BeepSinkTest, DetachingStopsReports) {
+  chip8::Emulator emulator{50};
+  RecordingSink sink;
+  emulator.set_beep_sink(&sink);
+  emulator.load_rom(BEEP_ROM);
+  emulator.run_frame();
+  emulator.set_beep_sink(nullptr);
+  emulator.run_frame();
+  emulator.run_frame();
+  EXPECT_EQ(sink.changes.size(), 1u);
+  EXPECT_EQ(sink.frame, 1u);
+}
+
+TEST(WavWriterTest, WritesAPcmHeaderAndClippedSamples) {
+  std::ostringstream out;
+  chip8::WavWriter wav{out, 22050};
+  const std::vector<float> samples{0.0f, 1.0f, -2.0f, 0.5f};
+  wav.write(samples);
+  wav.finish();
+  const std::string bytes = std::move(out).str();
+
+  ASSERT_EQ(bytes.size(), chip8::WavWriter::HEADER_SIZE + 8);
+  EXPECT_EQ(bytes.substr(0, 4), "RIFF");
+  EXPECT_EQ(u32_at(bytes, 4), 72u + 8u);
+  EXPECT_EQ(bytes.substr(8, 8), "WAVEJUNK");
+  EXPECT_EQ(u32_at(bytes, 16), 28u);
+  EXPECT_EQ(bytes.substr(48, 4), "fmt ");
+  EXPECT_EQ(u32_at(bytes, 60), 22050u);
+  EXPECT_EQ(u32_at(bytes, 64), 44100u);
+  EXPECT_EQ(bytes.substr(72, 4), "data");
+  EXPECT_EQ(u32_at(bytes, 76), 8u);
+  EXPECT_EQ(sample(bytes, 0), 0);
+  EXPECT_EQ(sample(bytes, 1), 32767);
+  EXPECT_EQ(sample(bytes, 2), -32767);
+  EXPECT_EQ(sample(bytes, 3), 16384);
+}
+
+TEST(WavWriterTest, SwitchesToRf64PastTheRiffLimit) {
+  std::ostringstream out;
+  // Room for the header and three samples.
+  chip8::WavWriter wav{out, 22050, chip8::WavWriter::HEADER_SIZE - 8 + 6};
+  const std::vector<float> samples{0.0f, 0.5f, 0.0f, -0.5f};
+  wav.write(samples);
+  wav.finish();
+  const std::string bytes = std::move(out).str();
+
+  ASSERT_EQ(bytes.size(), chip8::WavWriter::HEADER_SIZE + 8);
+  EXPECT_EQ(bytes.substr(0, 4), "RF64");
+  EXPECT_EQ(u32_at(bytes, 4), UINT32_MAX);
+  EXPECT_EQ(bytes.substr(8, 8), "WAVEds64");
+  EXPECT_EQ(u32_at(bytes, 20), 72u + 8u); // RIFF size, low half
+  EXPECT_EQ(u32_at(bytes, 24), 0u);
+  EXPECT_EQ(u32_at(bytes, 28), 8u); // data size
+  EXPECT_EQ(u32_at(bytes, 36), 4u); // sample frames
+  EXPECT_EQ(bytes.substr(72, 4), "data");
+  EXPECT_EQ(u32_at(bytes, 76), UINT32_MAX);
+  EXPECT_EQ(sample(bytes, 3), -16384);
+}
+
+TEST(HeadlessAudioTest, RendersChangesAtTheirSamples) {
+  // 735 samples per frame at 44.1 kHz.
+  const std::string wav = render({{0, 0.5f, true}, {2, 0.0f, false}}, 3);
+  ASSERT_EQ(wav.size(), chip8::WavWriter::HEADER_SIZE + 2 * 3 * 735);
+
+  for (std::size_t i = 0; i <= 368; ++i) {
+    ASSERT_EQ(sample(wav, i), 0) << "sample " << i; // 368 is a zero crossing
+  }
+  EXPECT_NE(sample(wav, 369), 0);
+  EXPECT_NE(sample(wav, 1469), 0);
+  for (std::size_t i = 1470; i < 3 * 735; ++i) {
+    ASSERT_EQ(sample(wav, i), 0) << "sample " << i;
+  }
+}
+
+TEST(HeadlessAudioTest, SameChangesGiveTheSameBytes) {
+  const std::vector<Change> changes{
+      {0, 0.1f, true}, {3, 0.25f, false}, {7, 0.0f, true}, {9, 0.9f, false}};
+  EXPECT_EQ(render(changes, 12), render(changes, 12));
+  EXPECT_NE(render(changes, 12), render({{0, 0.1f, true}}, 12));
+}
+
+TEST(HeadlessAudioTest, BatchJobWritesTheWholeRun) {
+  const auto path =
+      std::filesystem::temp_directory_path() / "chip8_headless_audio.wav";
+  chip8::BatchJob job{"wait",
+                      std::make_shared<const std::vector<uint8_t>>(WAIT_ROM),
+                      1000, 20};
+  job.audio = path;
+
+  const auto read = [&] {
+    const auto result = chip8::run_batch_job(job);
+    EXPECT_TRUE(result.error.empty()) << result.error;
+    EXPECT_EQ(result.frames_run, 1000u);
+    std::ifstream file(path, std::ios::binary);
+    return std::string{std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>()};
+  };
+  const std::string first = read();
+  const std::string second = read();
+  std::filesystem::remove(path);
+
+  ASSERT_EQ(first.size(), chip8::WavWriter::HEADER_SIZE + 2 * 735 * 1000);
+  EXPECT_EQ(first, second);
+  // The beep starts at instruction 1 of frame 0 and lasts 16 frames.
+  EXPECT_NE(sample(first, 100), 0);
+  EXPECT_EQ(sample(first, 16 * 735 + 100), 0);
+}
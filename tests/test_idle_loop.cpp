@@ -0,0 +1,176 @@
+#include "batch_runner.h"
+#include "chip8_emulator.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Sets the delay timer to 3 and polls it until it runs out, counting the
+// rounds in V2 and drawing a digit after each.
+const std::vector<uint8_t> DELAY_ROM{
+    0x60, 0x03, // 0x200: LD V0, 3
+    0xF0, 0x15, // 0x202: LD DT, V0
+    0xF1, 0x07, // 0x204: LD V1, DT
+    0x31, 0x00, // 0x206: SE V1, 0
+    0x12, 0x04, // 0x208: JP 0x204
+    0x72, 0x01, // 0x20A: ADD V2, 1
+    0xF2, 0x29, // 0x20C: LD F, V2
+    0xD3, 0x35, // 0x20E: DRW V3, V3, 5
+    0x12, 0x00, // 0x210: JP 0x200
+};
+
+// Counts V0 up in a loop: it never leaves the registers as it found them.
+const std::vector<uint8_t> COUNTER_ROM{
+    0x70, 0x01, // 0x200: ADD V0, 1
+    0x12, 0x00, // 0x202: JP 0x200
+};
+
+// Spins until key 5 is held, then draws and waits for it to be released.
+const std::vector<uint8_t> KEY_ROM{
+    0x65, 0x05, // 0x200: LD V5, 5
+    0xE5, 0x9E, // 0x202: SKP V5
+    0x12, 0x02, // 0x204: JP 0x202
+    0xD0, 0x05, // 0x206: DRW V0, V0, 5
+    0xE5, 0xA1, // 0x208: SKNP V5
+    0x12, 0x08, // 0x20A: JP 0x208
+    0x12, 0x02, // 0x20C: JP 0x202
+};
+
+// Starts the delay timer, then waits for a key and counts presses in V2.
+const std::vector<uint8_t> WAIT_ROM{
+    0x60, 0x20, // 0x200: LD V0, 0x20
+    0xF0, 0x15, // 0x202: LD DT, V0
+    0xF1, 0x0A, // 0x204: LD V1, K
+    0x72, 0x01, // 0x206: ADD V2, 1
+    0x12, 0x04, // 0x208: JP 0x204
+};
+
+bool same_state(const chip8::Emulator &a, const chip8::Emulator &b) {
+  const auto left = a.save_state();
+  const auto right = b.save_state();
+  return std::memcmp(&left, &right, sizeof(left)) == 0;
+}
+
+} // namespace
+
+class IdleLoopTest : public ::testing::TestWithParam<chip8::DispatchMode> {
+protected:
+  void SetUp() override {
+    if (GetParam() == chip8::DispatchMode::Jit && !chip8::Jit::supported()) {
+      GTEST_SKIP() << "JIT is not supported on this host";
+    }
+  }
+};
+
+TEST_P(IdleLoopTest, SkippingMatchesExecutingEveryFrame) {
+  for (const uint32_t cycles : {7u, 33u, 100u, 1000u}) {
+    chip8::Emulator skipping{cycles};
+    chip8::Emulator executing{cycles};
+    skipping.set_dispatch_mode(GetParam());
+    executing.set_dispatch_mode(GetParam());
+    executing.set_skip_idle_loops(false);
+    skipping.load_rom(DELAY_ROM);
+    executing.load_rom(DELAY_ROM);
+
+    for (int frame = 0; frame < 40; ++frame) {
+      skipping.run_frame();
+      executing.run_frame();
+      ASSERT_TRUE(same_state(skipping, executing))
+          << "cycles " << cycles << ", frame " << frame;
+    }
+    EXPECT_EQ(executing.cpu().idle_cycles_skipped(), 0u);
+    if (cycles == 1000) {
+      // Nearly all of every frame is spent polling the timer.
+      EXPECT_GT(skipping.cpu().idle_cycles_skipped(), 40u * cycles * 9 / 10);
+    }
+  }
+}
+
+TEST_P(IdleLoopTest, KeyPollingIsSkippedUntilTheKeyChanges) {
+  chip8::Emulator skipping{500};
+  chip8::Emulator executing{500};
+  skipping.set_dispatch_mode(GetParam());
+  executing.set_dispatch_mode(GetParam());
+  executing.set_skip_idle_loops(false);
+  skipping.load_rom(KEY_ROM);
+  executing.load_rom(KEY_ROM);
+
+  for (int frame = 0; frame < 30; ++frame) {
+    const bool held = frame % 10 >= 5;
+    skipping.keyboard().set_key_state(5, held);
+    executing.keyboard().set_key_state(5, held);
+    skipping.run_frame();
+    executing.run_frame();
+    ASSERT_TRUE(same_state(skipping, executing)) << "frame " << frame;
+  }
+  EXPECT_GT(skipping.cpu().idle_cycles_skipped(), 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllModes, IdleLoopTest,
+                         ::testing::Values(chip8::DispatchMode::Switch,
+                                           chip8::DispatchMode::Table,
+                                           chip8::DispatchMode::Cached,
+                                           chip8::DispatchMode::Jit));
+
+TEST(IdleLoopSkipTest, LoopsThatChangeRegistersRunInFull) {
+  chip8::Emulator skipping{1000};
+  chip8::Emulator executing{1000};
+  executing.set_skip_idle_loops(false);
+  skipping.load_rom(COUNTER_ROM);
+  executing.load_rom(COUNTER_ROM);
+
+  for (int frame = 0; frame < 5; ++frame) {
+    skipping.run_frame();
+    executing.run_frame();
+  }
+  EXPECT_TRUE(same_state(skipping, executing));
+  EXPECT_EQ(skipping.cpu().idle_cycles_skipped(), 0u);
+}
+
+TEST(IdleLoopSkipTest, ProfilingExecutesEveryInstruction) {
+  chip8::Emulator emulator{1000};
+  emulator.enable_profiling();
+  emulator.load_rom(DELAY_ROM);
+  emulator.run_frame();
+  EXPECT_EQ(emulator.cpu().idle_cycles_skipped(), 0u);
+  EXPECT_EQ(emulator.profiler()->instructions(), 1000u);
+}
+
+TEST(WaitForKeyTest, RunFrameParksUntilAKeyGoesDown) {
+  chip8::Emulator emulator{100};
+  emulator.load_rom(WAIT_ROM);
+
+  for (int frame = 0; frame < 5; ++frame) {
+    const auto result = emulator.run_frame();
+    EXPECT_TRUE(result.frame_complete);
+    EXPECT_TRUE(result.waiting_for_key);
+  }
+  EXPECT_TRUE(emulator.waiting_for_key());
+  EXPECT_EQ(emulator.cpu().program_counter(), 0x204u);
+  // Parked frames still tick the timers.
+  EXPECT_EQ(emulator.save_state().delay, 0x20 - 5);
+
+  emulator.keyboard().set_key_state(0xA, true);
+  const auto result = emulator.run_frame();
+  EXPECT_TRUE(result.waiting_for_key); // back at Fx0A for the next press
+  EXPECT_EQ(emulator.cpu().registers()[1], 0xAu);
+  EXPECT_EQ(emulator.cpu().registers()[2], 1u);
+
+  // Holding the key is not another press.
+  emulator.run_frame();
+  EXPECT_EQ(emulator.cpu().registers()[2], 1u);
+}
+
+TEST(WaitForKeyTest, BatchSkipsFramesNoInputCanEnd) {
+  chip8::BatchJob job{"wait",
+                      std::make_shared<const std::vector<uint8_t>>(WAIT_ROM),
+                      100'000'000, 1000};
+  const auto result = chip8::run_batch_job(job);
+  EXPECT_EQ(result.stop_reason, chip8::BatchStopReason::FrameLimit);
+  EXPECT_EQ(result.frames_run, 100'000'000u);
+  EXPECT_EQ(result.cycles_run, 100'000'000'000u);
+  EXPECT_EQ(result.program_counter, 0x204u);
+}
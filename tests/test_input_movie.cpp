@@ -0,0 +1,146 @@
+#include "batch_runner.h"
+#include "chip8_emulator.h"
+#include "input_movie.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Moves a dot with keys 4/6, waits for a key press with Fx0A whenever 5 is
+// held, and mixes in random draws so the seed matters.
+const std::vector<uint8_t> INPUT_ROM{
+    0xA2, 0x40, // 0x200: LD I, 0x240
+    0x62, 0x04, // 0x202: LD V2, 4
+    0xE2, 0xA1, // 0x204: SKNP V2
+    0x70, 0xFF, // 0x206: ADD V0, -1
+    0x62, 0x06, // 0x208: LD V2, 6
+    0xE2, 0xA1, // 0x20A: SKNP V2
+    0x70, 0x01, // 0x20C: ADD V0, 1
+    0x62, 0x05, // 0x20E: LD V2, 5
+    0xE2, 0x9E, // 0x210: SKP V2
+    0x12, 0x16, // 0x212: JP 0x216
+    0xF3, 0x0A, // 0x214: LD V3, K
+    0xC1, 0x1F, // 0x216: RND V1, 0x1F
+    0xD0, 0x11, // 0x218: DRW V0, V1, 1
+    0x12, 0x02, // 0x21A: JP 0x202
+};
+
+struct Session {
+  chip8::InputMovie movie;
+  uint64_t display_hash{};
+};
+
+// Plays a scripted session the way the SDL frontend would.
+Session record_session(uint64_t seed) {
+  chip8::Emulator emulator{10, seed};
+  emulator.load_rom(INPUT_ROM);
+  chip8::MovieRecorder recorder{emulator, INPUT_ROM};
+  for (uint32_t frame = 0; frame < 240; ++frame) {
+    auto &keyboard = emulator.keyboard();
+    keyboard.set_key_state(0x4, frame % 40 < 10);
+    keyboard.set_key_state(0x6, frame % 30 > 20);
+    keyboard.set_key_state(0x5, frame % 50 == 7);
+    if (frame % 50 == 9) {
+      keyboard.set_key_state(0xA, true);
+      keyboard.set_key_state(0xA, false);
+    }
+    recorder.record(keyboard);
+    emulator.run_frame();
+  }
+  return {recorder.finish(emulator), chip8::hash_display(emulator.display())};
+}
+
+} // namespace
+
+TEST(InputMovieTest, PlaybackReproducesRecordedSession) {
+  const auto session = record_session(1234);
+
+  chip8::Emulator emulator;
+  const auto playback = chip8::play_movie(emulator, session.movie, INPUT_ROM);
+
+  EXPECT_TRUE(playback.verified);
+  EXPECT_EQ(playback.frames, 240u);
+  EXPECT_EQ(emulator.seed(), 1234u);
+  EXPECT_EQ(chip8::hash_display(emulator.display()), session.display_hash);
+  EXPECT_LT(session.movie.inputs.size(), 60u);
+}
+
+TEST(InputMovieTest, FileRoundTripKeepsEverything) {
+  const auto session = record_session(99);
+  std::stringstream file;
+  chip8::write_movie(file, session.movie);
+
+  const auto loaded = chip8::read_movie(file);
+
+  EXPECT_EQ(loaded.seed, 99u);
+  EXPECT_EQ(loaded.cycles_per_frame, session.movie.cycles_per_frame);
+  EXPECT_EQ(loaded.rom_hash, session.movie.rom_hash);
+  EXPECT_EQ(loaded.frames, session.movie.frames);
+  EXPECT_EQ(loaded.final_hash, session.movie.final_hash);
+  ASSERT_EQ(loaded.inputs.size(), session.movie.inputs.size());
+  chip8::Emulator emulator;
+  EXPECT_TRUE(chip8::play_movie(emulator, loaded, INPUT_ROM).verified);
+}
+
+TEST(InputMovieTest, AlteredInputFailsVerification) {
+  auto movie = record_session(7).movie;
+  movie.inputs.front().keys ^= 1u << 0x6;
+
+  chip8::Emulator emulator;
+  EXPECT_FALSE(chip8::play_movie(emulator, movie, INPUT_ROM).verified);
+}
+
+TEST(InputMovieTest, RejectsOtherRomAndCorruptFiles) {
+  const auto movie = record_session(7).movie;
+  std::vector<uint8_t> other_rom = INPUT_ROM;
+  other_rom.back() ^= 1;
+  chip8::Emulator emulator;
+  EXPECT_THROW(chip8::play_movie(emulator, movie, other_rom),
+               std::invalid_argument);
+
+  std::stringstream file;
+  chip8::write_movie(file, movie);
+  const std::string bytes = file.str();
+  std::stringstream truncated{bytes.substr(0, bytes.size() - 3)};
+  EXPECT_THROW(chip8::read_movie(truncated), std::runtime_error);
+  std::stringstream garbage{"not a movie"};
+  EXPECT_THROW(chip8::read_movie(garbage), std::runtime_error);
+}
+
+TEST(InputMovieTest, DroppingRewoundFramesKeepsMovieValid) {
+  chip8::Emulator emulator;
+  emulator.enable_rewind();
+  emulator.load_rom(INPUT_ROM);
+  chip8::MovieRecorder recorder{emulator, INPUT_ROM};
+  for (uint32_t frame = 0; frame < 100; ++frame) {
+    if (frame == 60) {
+      recorder.drop_last(emulator.rewind(25));
+    }
+    emulator.keyboard().set_key_state(0x6, frame % 20 < 12);
+    recorder.record(emulator.keyboard());
+    emulator.run_frame();
+  }
+  const auto movie = recorder.finish(emulator);
+
+  EXPECT_EQ(movie.frames, 75u);
+  chip8::Emulator replay;
+  EXPECT_TRUE(chip8::play_movie(replay, movie, INPUT_ROM).verified);
+}
+
+TEST(InputMovieTest, BatchJobReplaysMovie) {
+  const auto session = record_session(5);
+  chip8::BatchJob job{"input", std::make_shared<const std::vector<uint8_t>>(
+                                   INPUT_ROM)};
+  job.movie = std::make_shared<const chip8::InputMovie>(session.movie);
+
+  const auto result = chip8::run_batch_job(job);
+
+  ASSERT_TRUE(result.movie_verified.has_value());
+  EXPECT_TRUE(*result.movie_verified);
+  EXPECT_EQ(result.frames_run, 240u);
+  EXPECT_EQ(result.display_hash, session.display_hash);
+}
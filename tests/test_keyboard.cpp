@@ -41,3 +41,33 @@ TEST(KeyboardTest, LastPressedClearsWhenKeyReleased) {
   keyboard.set_key_state(key, false);
   EXPECT_FALSE(keyboard.last_pressed().has_value());
 }
+
+TEST(KeyboardTest, KeyMaskRoundTripsThroughRestore) {
+  chip8::Keyboard keyboard;
+  keyboard.set_key_state(0x0, true);
+  keyboard.set_key_state(0xF, true);
+  EXPECT_EQ(keyboard.key_mask(), 0x8001u);
+
+  chip8::Keyboard copy;
+  copy.restore(keyboard.key_mask(), keyboard.last_pressed());
+
+  EXPECT_TRUE(copy.is_pressed(0x0));
+  EXPECT_TRUE(copy.is_pressed(0xF));
+  EXPECT_FALSE(copy.is_pressed(0x7));
+  EXPECT_EQ(copy.last_pressed(), std::optional<uint8_t>{0xF});
+  EXPECT_THROW(copy.restore(0, uint8_t{chip8::NUM_KEYS}), std::out_of_range);
+}
+
+TEST(KeyboardTest, SetKeyMaskOnlyTouchesChangedKeys) {
+  chip8::Keyboard keyboard;
+  keyboard.set_key_state(0x9, true);
+  keyboard.set_key_state(0x2, true);
+
+  keyboard.set_key_mask(1u << 0x9 | 1u << 0x4);
+
+  EXPECT_EQ(keyboard.key_mask(), 1u << 0x9 | 1u << 0x4);
+  EXPECT_EQ(keyboard.last_pressed(), std::optional<uint8_t>{0x4});
+
+  keyboard.set_key_mask(1u << 0x9);
+  EXPECT_FALSE(keyboard.last_pressed().has_value());
+}
@@ -0,0 +1,204 @@
+#include "chip8_emulator.h"
+#include "chip8_lockstep.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Random sprites, BCD digits drawn as sprites, a subroutine that rewrites
+// the instruction it returns to, a computed jump, and ALU operations with
+// VF as both source and destination.
+const std::vector<uint8_t> CHURN_ROM{
+    0xC0, 0x3F, // 0x200: RND V0, 0x3F
+    0xC1, 0x1F, // 0x202: RND V1, 0x1F
+    0xA2, 0x60, // 0x204: LD I, 0x260
+    0xF0, 0x33, // 0x206: LD B, V0
+    0xD0, 0x13, // 0x208: DRW V0, V1, 3
+    0x22, 0x20, // 0x20A: CALL 0x220
+    0x70, 0x01, // 0x20C: ADD V0, 1 (rewritten by the subroutine)
+    0x3F, 0x01, // 0x20E: SE VF, 1
+    0x12, 0x00, // 0x210: JP 0x200
+    0x8F, 0x04, // 0x212: ADD VF, V0
+    0x8F, 0x15, // 0x214: SUB VF, V1
+    0x81, 0xF7, // 0x216: SUBN V1, VF
+    0x8F, 0x06, // 0x218: SHR VF
+    0x80, 0xFE, // 0x21A: SHL V0
+    0x12, 0x00, // 0x21C: JP 0x200
+    0x00, 0x00, // 0x21E
+    0xC1, 0x0F, // 0x220: RND V1, 0x0F
+    0x60, 0x70, // 0x222: LD V0, 0x70
+    0xA2, 0x0C, // 0x224: LD I, 0x20C
+    0xF1, 0x55, // 0x226: LD [I], V1 -> 0x20C becomes ADD V0, V1
+    0xF1, 0x15, // 0x228: LD DT, V1
+    0xF1, 0x18, // 0x22A: LD ST, V1
+    0xF2, 0x07, // 0x22C: LD V2, DT
+    0xA2, 0x61, // 0x22E: LD I, 0x261
+    0xF0, 0x65, // 0x230: LD V0, [I] (tens digit)
+    0xF2, 0x1E, // 0x232: ADD I, V2
+    0x62, 0x01, // 0x234: LD V2, 1
+    0x80, 0x22, // 0x236: AND V0, V2
+    0x80, 0x0E, // 0x238: SHL V0
+    0xB2, 0x3C, // 0x23A: JP V0, 0x23C
+    0x6F, 0x01, // 0x23C: LD VF, 1 (even tens digit: take the ALU path)
+    0x7A, 0x01, // 0x23E: ADD VA, 1
+    0x00, 0xEE, // 0x240: RET
+};
+
+// Moves with keys 4/6, blocks on Fx0A whenever 5 is held.
+const std::vector<uint8_t> INPUT_ROM{
+    0xA2, 0x40, // 0x200: LD I, 0x240
+    0x62, 0x04, // 0x202: LD V2, 4
+    0xE2, 0xA1, // 0x204: SKNP V2
+    0x70, 0xFF, // 0x206: ADD V0, -1
+    0x62, 0x06, // 0x208: LD V2, 6
+    0xE2, 0xA1, // 0x20A: SKNP V2
+    0x70, 0x01, // 0x20C: ADD V0, 1
+    0x62, 0x05, // 0x20E: LD V2, 5
+    0xE2, 0x9E, // 0x210: SKP V2
+    0x12, 0x16, // 0x212: JP 0x216
+    0xF3, 0x0A, // 0x214: LD V3, K
+    0x00, 0xE0, // 0x216: CLS
+    0xD0, 0x31, // 0x218: DRW V0, V3, 1
+    0x12, 0x02, // 0x21A: JP 0x202
+};
+
+// Tests random keys, most of them above 0xF, recurses 19 levels deep and
+// returns 23 times before starting over.
+const std::vector<uint8_t> WRAP_ROM{
+    0xC0, 0xFF, // 0x200: RND V0, 0xFF
+    0xE0, 0x9E, // 0x202: SKP V0
+    0x71, 0x01, // 0x204: ADD V1, 1
+    0x72, 0x01, // 0x206: ADD V2, 1
+    0x32, 0x14, // 0x208: SE V2, 20
+    0x22, 0x00, // 0x20A: CALL 0x200
+    0x73, 0x01, // 0x20C: ADD V3, 1
+    0x33, 0x18, // 0x20E: SE V3, 24
+    0x00, 0xEE, // 0x210: RET
+    0x62, 0x00, // 0x212: LD V2, 0
+    0x63, 0x00, // 0x214: LD V3, 0
+    0x12, 0x00, // 0x216: JP 0x200
+};
+
+uint16_t keys_for(std::size_t lane, uint32_t frame) {
+  const auto phase = static_cast<uint32_t>(lane * 7 + frame);
+  uint16_t mask = 0;
+  mask |= phase % 40 < 10 ? 1u << 0x4 : 0u;
+  mask |= phase % 30 > 20 ? 1u << 0x6 : 0u;
+  mask |= phase % 50 == 7 ? 1u << 0x5 : 0u;
+  mask |= phase % 50 == 9 ? 1u << 0xA : 0u;
+  return mask;
+}
+
+void expect_lane_matches(const chip8::LockstepEngine &engine,
+                         const chip8::Emulator &reference, std::size_t lane) {
+  SCOPED_TRACE("lane " + std::to_string(lane));
+  const auto &cpu = reference.cpu();
+  ASSERT_EQ(engine.program_counter(lane), cpu.program_counter());
+  ASSERT_EQ(engine.index_register(lane), cpu.index_register());
+  ASSERT_TRUE(std::ranges::equal(engine.registers(lane), cpu.registers()));
+  const auto state = reference.save_state();
+  ASSERT_EQ(engine.delay(lane), state.delay);
+  ASSERT_EQ(engine.sound(lane), state.sound);
+  ASSERT_TRUE(
+      std::ranges::equal(engine.rows(lane), reference.display().rows()));
+  ASSERT_TRUE(
+      std::ranges::equal(engine.memory(lane), reference.memory().span()));
+}
+
+// Runs `lanes` copies in lockstep next to as many reference Emulators and
+// compares every lane after every frame.
+chip8::LockstepEngine::Stats
+run_differential(const std::vector<uint8_t> &rom, std::size_t lanes,
+                 uint32_t frames, bool with_input) {
+  std::vector<uint64_t> seeds(lanes);
+  for (std::size_t lane = 0; lane < lanes; ++lane) {
+    seeds[lane] = 1000 + lane * 17;
+  }
+  chip8::LockstepEngine engine{lanes, 12};
+  engine.load_rom(rom, seeds);
+
+  std::vector<std::unique_ptr<chip8::Emulator>> references;
+  for (const uint64_t seed : seeds) {
+    references.push_back(std::make_unique<chip8::Emulator>(12, seed));
+    references.back()->load_rom(rom);
+  }
+
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+      if (with_input) {
+        engine.set_key_mask(lane, keys_for(lane, frame));
+        references[lane]->keyboard().set_key_mask(keys_for(lane, frame));
+      }
+      references[lane]->run_frame();
+    }
+    engine.run_frame();
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+      expect_lane_matches(engine, *references[lane], lane);
+      if (::testing::Test::HasFatalFailure()) {
+        ADD_FAILURE() << "frame " << frame;
+        return engine.stats();
+      }
+    }
+  }
+  return engine.stats();
+}
+
+} // namespace
+
+TEST(LockstepEngineTest, MatchesEmulatorWithDivergingRandomness) {
+  const auto stats = run_differential(CHURN_ROM, 37, 120, false);
+  EXPECT_GT(stats.divergent_cycles, 0u);
+}
+
+TEST(LockstepEngineTest, MatchesEmulatorWithPerLaneInput) {
+  const auto stats = run_differential(INPUT_ROM, 21, 200, true);
+  EXPECT_GT(stats.lockstep_cycles, 0u);
+  EXPECT_GT(stats.divergent_cycles, 0u);
+}
+
+TEST(LockstepEngineTest, MatchesEmulatorOnKeysAndStackOutOfRange) {
+  if constexpr (chip8::DefaultAccess::THROWS) {
+    chip8::Emulator reference{12, 1000};
+    reference.load_rom(WRAP_ROM);
+    EXPECT_THROW(
+        for (int frame = 0; frame < 10; ++frame) { reference.run_frame(); },
+        std::out_of_range);
+
+    chip8::LockstepEngine engine{1, 12};
+    const std::vector<uint64_t> seeds{1000};
+    engine.load_rom(WRAP_ROM, seeds);
+    EXPECT_THROW(
+        for (int frame = 0; frame < 10; ++frame) { engine.run_frame(); },
+        std::out_of_range);
+  } else {
+    run_differential(WRAP_ROM, 13, 120, true);
+  }
+}
+
+TEST(LockstepEngineTest, IdenticalLanesStayInLockstep) {
+  chip8::LockstepEngine engine{64};
+  const std::vector<uint64_t> seeds(64, 42);
+  engine.load_rom(CHURN_ROM, seeds);
+  for (int frame = 0; frame < 50; ++frame) {
+    engine.run_frame();
+  }
+
+  EXPECT_EQ(engine.stats().divergent_cycles, 0u);
+  EXPECT_EQ(engine.stats().lockstep_cycles, 500u);
+  EXPECT_TRUE(std::ranges::equal(engine.rows(0), engine.rows(63)));
+}
+
+TEST(LockstepEngineTest, RejectsBadArguments) {
+  EXPECT_THROW(chip8::LockstepEngine{0}, std::invalid_argument);
+
+  chip8::LockstepEngine engine{4};
+  const std::vector<uint64_t> too_few(3);
+  EXPECT_THROW(engine.load_rom(CHURN_ROM, too_few), std::invalid_argument);
+  const std::vector<uint64_t> seeds(4);
+  EXPECT_THROW(engine.load_rom({}, seeds), std::invalid_argument);
+}
@@ -30,12 +30,38 @@ TEST(MemoryTest, ReadTwoBytes) {
   EXPECT_EQ(memory.read_two_bytes(addr), 0x0E9Fu);
 }
 
-TEST(MemoryTest, OutOfBoundAccessThrows) {
-  chip8::Memory memory;
+TEST(MemoryTest, CheckedAccessOutOfBoundsThrows) {
+  chip8::BasicMemory<chip8::CheckedAccess> memory;
   EXPECT_THROW(
       { auto _ = memory.read_byte(chip8::MEMORY_SIZE); }, std::out_of_range);
   EXPECT_THROW(
       { auto _ = memory.read_two_bytes(chip8::MEMORY_SIZE); },
       std::out_of_range);
   EXPECT_THROW(memory.write_byte(chip8::MEMORY_SIZE, 0xABu), std::out_of_range);
-}
\ No newline at end of file
+}
+
+namespace {
+
+class LastWrite : public chip8::MemoryObserver {
+public:
+  void on_write(uint16_t addr) noexcept override { last = addr; }
+  uint16_t last{};
+};
+
+} // namespace
+
+TEST(MemoryTest, MaskedAccessWrapsTo12Bits) {
+  chip8::BasicMemory<chip8::MaskedAccess> memory;
+  static_assert(noexcept(memory.read_two_bytes(0)));
+  LastWrite observer;
+  memory.set_observer(&observer);
+
+  memory.write_byte(chip8::MEMORY_SIZE + 0x300, 0xABu);
+  EXPECT_EQ(observer.last, 0x300u);
+  EXPECT_EQ(memory.read_byte(0x300), 0xABu);
+  EXPECT_EQ(memory.read_byte(0xF300), 0xABu);
+
+  memory.write_byte(0xFFF, 0x12u);
+  EXPECT_EQ(memory.read_two_bytes(0xFFF),
+            0x1200u | chip8::DEFAULT_CHAR_SET[0]);
+}
@@ -0,0 +1,76 @@
+#include "chip8_emulator.h"
+#include "chip8_opcode_profiler.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST(OpcodeProfilerTest, PatternsMaskOperands) {
+  using chip8::OpcodeProfiler;
+  EXPECT_EQ(OpcodeProfiler::pattern(0x00E0), 0x00E0);
+  EXPECT_EQ(OpcodeProfiler::pattern(0x00EE), 0x00EE);
+  EXPECT_EQ(OpcodeProfiler::pattern(0x0123), 0x0000);
+  EXPECT_EQ(OpcodeProfiler::pattern(0x8AB4), 0x8004);
+  EXPECT_EQ(OpcodeProfiler::pattern(0xF533), 0xF033);
+  EXPECT_EQ(OpcodeProfiler::pattern(0xE3A1), 0xE0A1);
+  EXPECT_EQ(OpcodeProfiler::pattern(0xD125), 0xD000);
+
+  EXPECT_EQ(OpcodeProfiler::pattern_name(0x00EE), "00EE");
+  EXPECT_EQ(OpcodeProfiler::pattern_name(0x0000), "0nnn");
+  EXPECT_EQ(OpcodeProfiler::pattern_name(0x2000), "2nnn");
+  EXPECT_EQ(OpcodeProfiler::pattern_name(0x7000), "7xkk");
+  EXPECT_EQ(OpcodeProfiler::pattern_name(0x8004), "8xy4");
+  EXPECT_EQ(OpcodeProfiler::pattern_name(0xD000), "Dxyn");
+  EXPECT_EQ(OpcodeProfiler::pattern_name(0xF033), "Fx33");
+}
+
+TEST(OpcodeProfilerTest, ReportIsSortedByCount) {
+  chip8::OpcodeProfiler profiler;
+  for (int i = 0; i < 3; ++i) {
+    profiler.end(profiler.begin(0x7105));
+  }
+  profiler.end(profiler.begin(0xD015));
+  for (int i = 0; i < 200; ++i) {
+    profiler.end(profiler.begin(0x8124));
+  }
+  chip8::OpcodeProfiler other;
+  other.end(other.begin(0x7FFF));
+  other.count_native(10);
+  profiler.merge(other);
+
+  EXPECT_EQ(profiler.count(0x7000), 4u);
+  EXPECT_EQ(profiler.count(0x8004), 200u);
+  EXPECT_EQ(profiler.total(), 215u);
+
+  std::ostringstream out;
+  profiler.report(out);
+  const std::string report = out.str();
+  const auto alu = report.find("8xy4");
+  const auto jit = report.find("jit");
+  const auto add = report.find("7xkk");
+  const auto draw = report.find("Dxyn");
+  ASSERT_NE(draw, std::string::npos);
+  EXPECT_LT(alu, jit);
+  EXPECT_LT(jit, add);
+  EXPECT_LT(add, draw);
+  // Every 64th instruction is timed; all of them were 8xyN.
+  EXPECT_NE(report.find("8xxx"), std::string::npos);
+}
+
+#if CHIP8_ENABLE_INSTRUMENTATION
+TEST(OpcodeProfilerTest, CpuCountsWhatItRuns) {
+  chip8::Emulator emulator{5};
+  emulator.load_rom(std::vector<uint8_t>{
+      0x60, 0x01, // 0x200: LD V0, 1
+      0x80, 0x04, // 0x202: ADD V0, V0
+      0x12, 0x02, // 0x204: JP 0x202
+  });
+  emulator.run_frame();
+
+  const auto &profiler = emulator.cpu().profiler();
+  EXPECT_EQ(profiler.count(0x6000), 1u);
+  EXPECT_EQ(profiler.count(0x8004), 2u);
+  EXPECT_EQ(profiler.count(0x1000), 2u);
+}
+#endif
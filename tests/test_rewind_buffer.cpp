@@ -0,0 +1,171 @@
+#include "chip8_emulator.h"
+#include "chip8_rewind_buffer.h"
+#include "chip8_save_state.h"
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Random sprites at random positions with the RNG drawn twice per loop, so
+// the engine state churns as much as the framebuffer.
+const std::vector<uint8_t> NOISE_ROM{
+    0xC0, 0x3F, // 0x200: RND V0, 0x3F
+    0xC1, 0x1F, // 0x202: RND V1, 0x1F
+    0xA2, 0x00, // 0x204: LD I, 0x200
+    0xD0, 0x13, // 0x206: DRW V0, V1, 3
+    0xF0, 0x15, // 0x208: LD DT, V0
+    0x12, 0x00, // 0x20A: JP 0x200
+};
+
+bool same_bytes(const chip8::SaveState &lhs, const chip8::SaveState &rhs) {
+  return std::ranges::equal(std::as_bytes(std::span{&lhs, 1}),
+                            std::as_bytes(std::span{&rhs, 1}));
+}
+
+// Runs the noise ROM and returns the state after each frame.
+std::vector<chip8::SaveState> record_frames(std::size_t frames) {
+  chip8::Emulator emulator;
+  emulator.load_rom(NOISE_ROM);
+  std::vector<chip8::SaveState> states;
+  for (std::size_t i = 0; i < frames; ++i) {
+    emulator.run_frame();
+    states.push_back(emulator.save_state());
+  }
+  return states;
+}
+
+} // namespace
+
+TEST(RewindBufferTest, ReadReconstructsEveryFrame) {
+  const auto states = record_frames(100);
+  chip8::RewindBuffer buffer{1u << 20, 7};
+  for (const auto &state : states) {
+    buffer.push(state);
+  }
+
+  ASSERT_EQ(buffer.size(), states.size());
+  chip8::SaveState out;
+  for (std::size_t age = 0; age < states.size(); ++age) {
+    buffer.read(age, out);
+    ASSERT_TRUE(same_bytes(out, states[states.size() - 1 - age]))
+        << "age " << age;
+  }
+  EXPECT_THROW(buffer.read(states.size(), out), std::out_of_range);
+}
+
+TEST(RewindBufferTest, PopWalksBackOneFrameAtATime) {
+  const auto states = record_frames(50);
+  chip8::RewindBuffer buffer{1u << 20, 8};
+  for (const auto &state : states) {
+    buffer.push(state);
+  }
+
+  for (std::size_t i = states.size(); i-- > 0;) {
+    ASSERT_TRUE(same_bytes(buffer.newest(), states[i])) << "frame " << i;
+    buffer.pop();
+  }
+  EXPECT_EQ(buffer.size(), 0u);
+  EXPECT_THROW(buffer.pop(), std::out_of_range);
+}
+
+TEST(RewindBufferTest, PushAfterPopContinuesHistory) {
+  const auto states = record_frames(30);
+  chip8::RewindBuffer buffer{1u << 20, 4};
+  for (std::size_t i = 0; i < 20; ++i) {
+    buffer.push(states[i]);
+  }
+  for (int i = 0; i < 7; ++i) {
+    buffer.pop();
+  }
+  buffer.push(states[25]);
+
+  chip8::SaveState out;
+  buffer.read(0, out);
+  EXPECT_TRUE(same_bytes(out, states[25]));
+  buffer.read(1, out);
+  EXPECT_TRUE(same_bytes(out, states[12]));
+}
+
+TEST(RewindBufferTest, FullBufferEvictsOldestFrames) {
+  const auto states = record_frames(400);
+  constexpr std::size_t capacity = 64u << 10;
+  chip8::RewindBuffer buffer{capacity, 16};
+  for (const auto &state : states) {
+    buffer.push(state);
+    ASSERT_LE(buffer.bytes_used(), capacity);
+  }
+
+  ASSERT_GT(buffer.size(), 0u);
+  ASSERT_LT(buffer.size(), states.size());
+  chip8::SaveState out;
+  for (std::size_t age = 0; age < buffer.size(); ++age) {
+    buffer.read(age, out);
+    ASSERT_TRUE(same_bytes(out, states[states.size() - 1 - age]))
+        << "age " << age;
+  }
+}
+
+TEST(RewindBufferTest, FramesCostFarLessThanFullStates) {
+  const auto states = record_frames(600);
+  chip8::RewindBuffer buffer;
+  for (const auto &state : states) {
+    buffer.push(state);
+  }
+
+  EXPECT_LT(buffer.bytes_used(), states.size() * sizeof(chip8::SaveState) / 8);
+}
+
+TEST(RewindBufferTest, RejectsCapacityBelowOneState) {
+  EXPECT_THROW(chip8::RewindBuffer(1024), std::invalid_argument);
+  EXPECT_THROW(chip8::RewindBuffer(1u << 20, 0), std::invalid_argument);
+}
+
+TEST(EmulatorRewindTest, RewindRestoresEarlierFrameAndReplaysIdentically) {
+  chip8::Emulator emulator;
+  emulator.enable_rewind();
+  emulator.load_rom(NOISE_ROM);
+  std::vector<chip8::SaveState> states;
+  for (int i = 0; i < 100; ++i) {
+    emulator.run_frame();
+    states.push_back(emulator.save_state());
+  }
+
+  EXPECT_EQ(emulator.rewind(60), 60u);
+  EXPECT_TRUE(same_bytes(emulator.save_state(), states[39]));
+
+  for (int i = 40; i < 100; ++i) {
+    emulator.run_frame();
+  }
+  EXPECT_TRUE(same_bytes(emulator.save_state(), states[99]));
+}
+
+TEST(EmulatorRewindTest, RewindStopsAtOldestFrameAndKeepsLiveKeys) {
+  chip8::Emulator emulator;
+  emulator.enable_rewind();
+  emulator.load_rom(NOISE_ROM);
+  for (int i = 0; i < 10; ++i) {
+    emulator.run_frame();
+  }
+  emulator.keyboard().set_key_state(0x5, true);
+
+  EXPECT_EQ(emulator.rewind(50), 9u);
+  EXPECT_EQ(emulator.rewind(), 0u);
+  EXPECT_TRUE(emulator.keyboard().is_pressed(0x5));
+}
+
+TEST(EmulatorRewindTest, LoadingRomForgetsHistory) {
+  chip8::Emulator emulator;
+  emulator.enable_rewind();
+  emulator.load_rom(NOISE_ROM);
+  for (int i = 0; i < 10; ++i) {
+    emulator.run_frame();
+  }
+  emulator.load_rom(NOISE_ROM);
+
+  ASSERT_NE(emulator.rewind_buffer(), nullptr);
+  EXPECT_EQ(emulator.rewind_buffer()->size(), 0u);
+}
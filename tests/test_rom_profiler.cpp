@@ -0,0 +1,136 @@
+#include "batch_runner.h"
+#include "chip8_disassembler.h"
+#include "chip8_emulator.h"
+#include "rom_profiler.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// main calls sub_0x20A, which calls sub_0x210 to store BCD digits at 0x300;
+// main then loads one of them back. Eight instructions per iteration.
+const std::vector<uint8_t> CALL_ROM{
+    0xA3, 0x00, // 0x200: LD I, 0x300
+    0x22, 0x0A, // 0x202: CALL 0x20A
+    0xF0, 0x65, // 0x204: LD V0, [I]
+    0x12, 0x00, // 0x206: JP 0x200
+    0x00, 0x00, //
+    0x22, 0x10, // 0x20A: CALL 0x210
+    0x00, 0xEE, // 0x20C: RET
+    0x00, 0x00, //
+    0xF0, 0x33, // 0x210: LD B, V0
+    0x00, 0xEE, // 0x212: RET
+};
+
+} // namespace
+
+TEST(DisassemblerTest, FormatsEveryFamily) {
+  EXPECT_EQ(chip8::disassemble(0x00E0), "CLS");
+  EXPECT_EQ(chip8::disassemble(0x00EE), "RET");
+  EXPECT_EQ(chip8::disassemble(0x0123), "SYS 0x123");
+  EXPECT_EQ(chip8::disassemble(0x1204), "JP 0x204");
+  EXPECT_EQ(chip8::disassemble(0x2ABC), "CALL 0xABC");
+  EXPECT_EQ(chip8::disassemble(0x3A05), "SE VA, 0x05");
+  EXPECT_EQ(chip8::disassemble(0x5120), "SE V1, V2");
+  EXPECT_EQ(chip8::disassemble(0x8124), "ADD V1, V2");
+  EXPECT_EQ(chip8::disassemble(0x812E), "SHL V1, V2");
+  EXPECT_EQ(chip8::disassemble(0xA2F0), "LD I, 0x2F0");
+  EXPECT_EQ(chip8::disassemble(0xB300), "JP V0, 0x300");
+  EXPECT_EQ(chip8::disassemble(0xD015), "DRW V0, V1, 5");
+  EXPECT_EQ(chip8::disassemble(0xE3A1), "SKNP V3");
+  EXPECT_EQ(chip8::disassemble(0xF40A), "LD V4, K");
+  EXPECT_EQ(chip8::disassemble(0xF555), "LD [I], V5");
+  EXPECT_EQ(chip8::disassemble(0x8128), "DW 0x8128");
+  EXPECT_EQ(chip8::disassemble(0xF0FF), "DW 0xF0FF");
+}
+
+TEST(RomProfilerTest, DerivesDataAccessesFromOpcodes) {
+  chip8::RomProfiler profiler;
+  profiler.sample(0x200, 0xF255, 0x300, {}); // LD [I], V2
+  profiler.sample(0x202, 0xF165, 0x300, {}); // LD V1, [I]
+  profiler.sample(0x204, 0xD01F, 0xFFE, {}); // DRW, clipped at the end
+  profiler.sample(0x206, 0x6012, 0x300, {}); // LD V0, 0x12
+
+  const auto &counts = profiler.memory_counts();
+  EXPECT_EQ(counts.writes[0x300], 1u);
+  EXPECT_EQ(counts.writes[0x302], 1u);
+  EXPECT_EQ(counts.writes[0x303], 0u);
+  EXPECT_EQ(counts.reads[0x301], 1u);
+  EXPECT_EQ(counts.reads[0x302], 0u);
+  EXPECT_EQ(counts.reads[0xFFF], 1u);
+  EXPECT_EQ(profiler.instructions(), 4u);
+}
+
+TEST(RomProfilerTest, WrapsAccessesLikeTheCpu) {
+  chip8::RomProfiler profiler;
+  profiler.sample(0x1200, 0xF255, 0xFFF, {}); // LD [I], V2
+  profiler.sample(0x202, 0xF165, 0x1FFF, {}); // LD V1, [I]
+  profiler.sample(0x204, 0xD01F, 0xFFE, {});  // DRW, never wraps
+
+  const auto &counts = profiler.memory_counts();
+  EXPECT_EQ(counts.writes[0xFFF], 1u);
+  EXPECT_EQ(counts.writes[0x000], 1u);
+  EXPECT_EQ(counts.writes[0x001], 1u);
+  EXPECT_EQ(counts.reads[0xFFF], 2u);
+  EXPECT_EQ(counts.reads[0x000], 1u);
+  EXPECT_EQ(counts.reads[0x001], 0u);
+  EXPECT_EQ(profiler.executions(0x200), 1u);
+}
+
+TEST(RomProfilerTest, EmulatorProfilesExecutionsAccessesAndStacks) {
+  chip8::Emulator emulator;
+  emulator.enable_profiling();
+  emulator.load_rom(CALL_ROM);
+  emulator.run_frame(8 * 10);
+
+  const chip8::RomProfiler *profiler = emulator.profiler();
+  ASSERT_NE(profiler, nullptr);
+  EXPECT_EQ(profiler->instructions(), 80u);
+  EXPECT_EQ(profiler->executions(0x200), 10u);
+  EXPECT_EQ(profiler->executions(0x210), 10u);
+  EXPECT_EQ(profiler->executions(0x208), 0u);
+  const auto &counts = profiler->memory_counts();
+  EXPECT_EQ(counts.writes[0x300], 10u);
+  EXPECT_EQ(counts.writes[0x302], 10u);
+  EXPECT_EQ(counts.reads[0x300], 10u);
+  EXPECT_EQ(counts.reads[0x301], 0u);
+  // Copying the ROM in is not the ROM's own traffic.
+  EXPECT_EQ(counts.writes[0x200], 0u);
+
+  std::ostringstream stacks;
+  profiler->write_collapsed_stacks(stacks, emulator.memory().span());
+  EXPECT_EQ(stacks.str(), "main 40\n"
+                          "main;sub_0x20A 20\n"
+                          "main;sub_0x20A;sub_0x210 20\n");
+
+  std::ostringstream hot;
+  profiler->write_hot_listing(hot, emulator.memory().span(), 3);
+  const std::string listing = hot.str();
+  // Ties are listed by address.
+  EXPECT_NE(listing.find("0x200  A300    LD I, 0x300"), std::string::npos);
+  EXPECT_NE(listing.find("0x202  220A    CALL 0x20A"), std::string::npos);
+  EXPECT_NE(listing.find("0x204  F065    LD V0, [I]"), std::string::npos);
+  EXPECT_EQ(listing.find("0x206  1200"), std::string::npos);
+  EXPECT_NE(listing.find("0x300          10         10"), std::string::npos);
+
+  emulator.disable_profiling();
+  EXPECT_EQ(emulator.profiler(), nullptr);
+  emulator.run_frame();
+}
+
+TEST(RomProfilerTest, BatchJobReturnsProfile) {
+  chip8::BatchJob job{"call", std::make_shared<const std::vector<uint8_t>>(
+                                  CALL_ROM),
+                      2, 7};
+  job.profile = true;
+  const auto result = chip8::run_batch_job(job);
+  EXPECT_NE(result.hot_listing.find("CALL 0x210"), std::string::npos);
+  EXPECT_NE(result.collapsed_stacks.find("main;sub_0x20A"),
+            std::string::npos);
+
+  job.profile = false;
+  EXPECT_TRUE(chip8::run_batch_job(job).hot_listing.empty());
+}
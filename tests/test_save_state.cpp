@@ -0,0 +1,151 @@
+#include "chip8_emulator.h"
+#include "chip8_save_state.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Draws random bytes at random positions, calls a subroutine and plays with
+// both timers, so every part of the state keeps changing.
+const std::vector<uint8_t> NOISE_ROM{
+    0xC0, 0x3F, // 0x200: RND V0, 0x3F
+    0xC1, 0x1F, // 0x202: RND V1, 0x1F
+    0xA2, 0x00, // 0x204: LD I, 0x200
+    0xD0, 0x13, // 0x206: DRW V0, V1, 3
+    0x22, 0x10, // 0x208: CALL 0x210
+    0x12, 0x00, // 0x20A: JP 0x200
+    0x00, 0x00, // 0x20C
+    0x00, 0x00, // 0x20E
+    0xF0, 0x15, // 0x210: LD DT, V0
+    0xF1, 0x18, // 0x212: LD ST, V1
+    0xA3, 0x00, // 0x214: LD I, 0x300
+    0xF1, 0x55, // 0x216: LD [I], V1
+    0x00, 0xEE, // 0x218: RET
+};
+
+// Adds `step` to V0 forever.
+std::vector<uint8_t> counter_rom(uint8_t step) {
+  return {0x70, step, 0x12, 0x00};
+}
+
+void expect_same_machine(const chip8::Emulator &lhs,
+                         const chip8::Emulator &rhs) {
+  EXPECT_EQ(lhs.cpu().program_counter(), rhs.cpu().program_counter());
+  EXPECT_EQ(lhs.cpu().index_register(), rhs.cpu().index_register());
+  EXPECT_TRUE(std::ranges::equal(lhs.cpu().registers(), rhs.cpu().registers()));
+  EXPECT_TRUE(std::ranges::equal(lhs.memory().span(), rhs.memory().span()));
+  EXPECT_TRUE(std::ranges::equal(lhs.display().rows(), rhs.display().rows()));
+}
+
+} // namespace
+
+TEST(SaveStateTest, RestoredEmulatorReplaysIdentically) {
+  chip8::Emulator original;
+  original.load_rom(NOISE_ROM);
+  original.keyboard().set_key_state(0x3, true);
+  for (int i = 0; i < 30; ++i) {
+    original.run_frame();
+  }
+  const chip8::SaveState snapshot = original.save_state();
+
+  chip8::Emulator restored;
+  restored.load_state(snapshot);
+  for (int i = 0; i < 50; ++i) {
+    original.run_frame();
+    restored.run_frame();
+  }
+
+  expect_same_machine(original, restored);
+  EXPECT_EQ(restored.keyboard().is_pressed(0x3), true);
+  EXPECT_EQ(restored.state(), chip8::EmulatorState::Running);
+}
+
+TEST(SaveStateTest, LoadRewindsToSnapshot) {
+  chip8::Emulator emulator;
+  emulator.load_rom(NOISE_ROM);
+  const chip8::SaveState snapshot = emulator.save_state();
+
+  for (int i = 0; i < 20; ++i) {
+    emulator.run_frame();
+  }
+  const chip8::SaveState first_run = emulator.save_state();
+
+  emulator.load_state(snapshot);
+  for (int i = 0; i < 20; ++i) {
+    emulator.run_frame();
+  }
+  const chip8::SaveState second_run = emulator.save_state();
+
+  const auto first = std::as_bytes(std::span{&first_run, 1});
+  const auto second = std::as_bytes(std::span{&second_run, 1});
+  EXPECT_TRUE(std::ranges::equal(first, second));
+}
+
+TEST(SaveStateTest, RawBytesRoundTrip) {
+  chip8::Emulator original;
+  original.load_rom(NOISE_ROM);
+  for (int i = 0; i < 10; ++i) {
+    original.run_frame();
+  }
+  const chip8::SaveState snapshot = original.save_state();
+  const auto bytes = std::as_bytes(std::span{&snapshot, 1});
+  const std::vector<std::byte> file(bytes.begin(), bytes.end());
+
+  chip8::Emulator restored;
+  restored.load_state(file);
+
+  expect_same_machine(original, restored);
+}
+
+TEST(SaveStateTest, RejectsForeignOrTruncatedData) {
+  chip8::Emulator emulator;
+  emulator.load_rom(counter_rom(1));
+  emulator.run_frame();
+  const uint8_t v0 = emulator.cpu().registers()[0];
+
+  chip8::SaveState bad_magic = emulator.save_state();
+  bad_magic.magic ^= 1;
+  chip8::SaveState bad_version = emulator.save_state();
+  ++bad_version.version;
+  chip8::SaveState bad_stack = emulator.save_state();
+  bad_stack.sp = chip8::NUM_CPU_STACK + 1;
+  const std::vector<std::byte> truncated(sizeof(chip8::SaveState) - 1);
+
+  EXPECT_THROW(emulator.load_state(bad_magic), std::invalid_argument);
+  EXPECT_THROW(emulator.load_state(bad_version), std::invalid_argument);
+  EXPECT_THROW(emulator.load_state(bad_stack), std::invalid_argument);
+  EXPECT_THROW(emulator.load_state(truncated), std::invalid_argument);
+  EXPECT_EQ(emulator.cpu().registers()[0], v0);
+}
+
+class SaveStateDispatchTest
+    : public ::testing::TestWithParam<chip8::DispatchMode> {};
+
+TEST_P(SaveStateDispatchTest, LoadDropsCodeDerivedFromOldMemory) {
+  if (GetParam() == chip8::DispatchMode::Jit && !chip8::Jit::supported()) {
+    GTEST_SKIP() << "JIT is not supported on this host";
+  }
+  chip8::Emulator by_two;
+  by_two.load_rom(counter_rom(2));
+  const chip8::SaveState snapshot = by_two.save_state();
+
+  chip8::Emulator emulator;
+  emulator.set_dispatch_mode(GetParam());
+  emulator.load_rom(counter_rom(1));
+  emulator.run_frame(100);
+
+  emulator.load_state(snapshot);
+  emulator.run_frame(100);
+
+  EXPECT_EQ(emulator.cpu().registers()[0], 100u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, SaveStateDispatchTest,
+                         ::testing::Values(chip8::DispatchMode::Switch,
+                                           chip8::DispatchMode::Cached,
+                                           chip8::DispatchMode::Jit));
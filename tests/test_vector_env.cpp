@@ -0,0 +1,162 @@
+#include "vector_env.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Holding key 5 draws the "5" glyph at the top left; key 0 halts the ROM.
+const std::vector<uint8_t> KEY_ROM{
+    0x00, 0xE0, // 0x200: CLS
+    0x60, 0x05, // 0x202: LD V0, 5
+    0xE0, 0xA1, // 0x204: SKNP V0
+    0x12, 0x10, // 0x206: JP 0x210
+    0x61, 0x00, // 0x208: LD V1, 0
+    0xE1, 0x9E, // 0x20A: SKP V1
+    0x12, 0x00, // 0x20C: JP 0x200
+    0x12, 0x0E, // 0x20E: JP 0x20E
+    0xF0, 0x29, // 0x210: LD F, V0
+    0x61, 0x00, // 0x212: LD V1, 0
+    0xD1, 0x15, // 0x214: DRW V1, V1, 5
+    0x62, 0x00, // 0x216: LD V2, 0
+    0x12, 0x16, // 0x218: JP 0x216
+};
+
+constexpr uint16_t key(int k) { return static_cast<uint16_t>(1u << k); }
+
+} // namespace
+
+TEST(VectorEnvTest, ObservationsMatchEachInstanceDisplay) {
+  chip8::VectorEnv env{KEY_ROM, 3};
+  std::vector<uint8_t> observations(3 * env.observation_size(), 0xAA);
+  std::vector<float> rewards(3);
+  std::vector<uint8_t> dones(3);
+  env.reset(observations);
+
+  const std::vector<uint16_t> actions{0, key(5), 0};
+  for (int frame = 0; frame < 3; ++frame) {
+    env.step(actions, observations, rewards, dones);
+  }
+
+  for (std::size_t i = 0; i < 3; ++i) {
+    const auto &display = env.instance(i).display();
+    const uint8_t *obs = observations.data() + i * env.observation_size();
+    for (int y = 0; y < chip8::SCREEN_HEIGHT; ++y) {
+      for (int x = 0; x < chip8::SCREEN_WIDTH; ++x) {
+        ASSERT_EQ(obs[y * chip8::SCREEN_WIDTH + x],
+                  display.is_pixel_set(x, y) ? 1 : 0);
+      }
+    }
+  }
+  // "5" starts with 0xF0: four lit pixels on the top row.
+  const uint8_t *lit = observations.data() + env.observation_size();
+  EXPECT_EQ(lit[0] + lit[1] + lit[2] + lit[3] + lit[4], 4);
+  EXPECT_EQ(observations[0], 0);
+}
+
+TEST(VectorEnvTest, PackedBitsAreMostSignificantFirst) {
+  chip8::VectorEnv env{KEY_ROM, 2, chip8::ObservationFormat::PackedBits};
+  ASSERT_EQ(env.observation_size(), 32u * 8u);
+  std::vector<uint8_t> observations(2 * env.observation_size());
+  std::vector<float> rewards(2);
+  std::vector<uint8_t> dones(2);
+
+  const std::vector<uint16_t> actions{key(5), 0};
+  for (int frame = 0; frame < 3; ++frame) {
+    env.step(actions, observations, rewards, dones);
+  }
+
+  // The "5" glyph rows are F0 80 F0 10 F0.
+  const std::vector<uint8_t> glyph{0xF0, 0x80, 0xF0, 0x10, 0xF0};
+  for (std::size_t y = 0; y < glyph.size(); ++y) {
+    EXPECT_EQ(observations[y * 8], glyph[y]);
+    EXPECT_EQ(observations[y * 8 + 1], 0);
+  }
+  for (std::size_t i = env.observation_size(); i < observations.size(); ++i) {
+    ASSERT_EQ(observations[i], 0);
+  }
+}
+
+TEST(VectorEnvTest, RewardHookAndDoneFlagsPerInstance) {
+  chip8::VectorEnv env{KEY_ROM, 4};
+  env.set_reward_hook([](std::size_t index, const chip8::Emulator &emulator) {
+    return static_cast<float>(index) +
+           (emulator.display().is_pixel_set(0, 0) ? 0.5f : 0.0f);
+  });
+  std::vector<uint8_t> observations(4 * env.observation_size());
+  std::vector<float> rewards(4);
+  std::vector<uint8_t> dones(4);
+
+  const std::vector<uint16_t> actions{0, key(5), key(0), 0};
+  env.step(actions, observations, rewards, dones);
+  EXPECT_EQ(rewards, (std::vector<float>{0.0f, 1.5f, 2.0f, 3.0f}));
+  EXPECT_EQ(dones, (std::vector<uint8_t>{0, 0, 1, 0}));
+
+  // The halted instance was reloaded with a fresh seed.
+  EXPECT_EQ(env.instance(2).cpu().program_counter(), chip8::START_ADDRESS);
+  EXPECT_EQ(env.instance(2).seed(), chip8::Emulator::DEFAULT_SEED + 2 + 4);
+  EXPECT_EQ(env.instance(1).seed(), chip8::Emulator::DEFAULT_SEED + 1);
+}
+
+TEST(VectorEnvTest, CustomDoneHookRestartsEpisodes) {
+  chip8::VectorEnv env{KEY_ROM, 2};
+  int frames = 0;
+  env.set_done_hook([&](std::size_t index, const chip8::Emulator &) {
+    return index == 0 && ++frames % 2 == 0;
+  });
+  std::vector<uint8_t> observations(2 * env.observation_size());
+  std::vector<float> rewards(2);
+  std::vector<uint8_t> dones(2);
+
+  const std::vector<uint16_t> actions{key(5), key(5)};
+  env.step(actions, observations, rewards, dones);
+  EXPECT_EQ(dones, (std::vector<uint8_t>{0, 0}));
+  env.step(actions, observations, rewards, dones);
+  EXPECT_EQ(dones, (std::vector<uint8_t>{1, 0}));
+  // Instance 0 shows its fresh episode, instance 1 kept its glyph.
+  EXPECT_EQ(observations[0], 0);
+  EXPECT_EQ(observations[env.observation_size()], 1);
+}
+
+TEST(VectorEnvTest, ResetAfterAnEpisodeMovesTheSeedOn) {
+  chip8::VectorEnv env{KEY_ROM, 2};
+  std::vector<uint8_t> observations(2 * env.observation_size());
+  std::vector<float> rewards(2);
+  std::vector<uint8_t> dones(2);
+  constexpr uint64_t SEED = chip8::Emulator::DEFAULT_SEED;
+
+  // The first reset keeps the constructor's seeds.
+  env.reset(observations);
+  EXPECT_EQ(env.instance(0).seed(), SEED);
+  EXPECT_EQ(env.instance(1).seed(), SEED + 1);
+
+  // Instance 0 finishes an episode and is reloaded with SEED + 2.
+  const std::vector<uint16_t> actions{key(0), 0};
+  env.step(actions, observations, rewards, dones);
+  EXPECT_EQ(dones, (std::vector<uint8_t>{1, 0}));
+  EXPECT_EQ(env.instance(0).seed(), SEED + 2);
+
+  env.reset(observations);
+  EXPECT_EQ(env.instance(0).seed(), SEED + 4);
+  EXPECT_EQ(env.instance(1).seed(), SEED + 3);
+}
+
+TEST(VectorEnvTest, RejectsMismatchedBuffers) {
+  EXPECT_THROW((chip8::VectorEnv{KEY_ROM, 0}), std::invalid_argument);
+
+  chip8::VectorEnv env{KEY_ROM, 2};
+  std::vector<uint8_t> observations(2 * env.observation_size());
+  std::vector<float> rewards(2);
+  std::vector<uint8_t> dones(2);
+  const std::vector<uint16_t> actions{0, 0};
+  const std::vector<uint16_t> too_few{0};
+  std::vector<uint8_t> short_observations(observations.size() - 1);
+
+  EXPECT_THROW(env.step(too_few, observations, rewards, dones),
+               std::invalid_argument);
+  EXPECT_THROW(env.step(actions, short_observations, rewards, dones),
+               std::invalid_argument);
+  EXPECT_THROW(env.reset(short_observations), std::invalid_argument);
+  EXPECT_NO_THROW(env.step(actions, observations, rewards, dones));
+}